@@ -9,15 +9,45 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include "settings.h"
 #include "media_sys.h"
 #include "network.h"
 #include "sys_state.h"
+#include "nal_index.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief  Describe the NAL layout of an access unit produced by the H.264 encoder
+ *
+ * @note  The encoder emits 4-byte start codes, a single slice per frame and
+ *        SPS/PPS only in front of IDR slices, so the layout is known from the
+ *        first NAL header and the short parameter-set prefix.
+ *
+ * @param[in]   data   Encoded access unit
+ * @param[in]   size   Access unit size
+ * @param[out]  index  NAL table to fill
+ *
+ * @return
+ *       - 0       On success
+ *       - Others  Frame does not follow the encoder layout
+ */
+int media_sys_describe_video_frame(const uint8_t *data, size_t size, nal_index_t *index);
+
+/**
+ * @brief  Set the frame rate the camera feeds to the video encoder
+ *
+ * @note  Camera frames above the rate are released before they are encoded,
+ *        so the running session changes frame rate without reopening. Rates
+ *        at or above VIDEO_FPS keep every frame
+ *
+ * @param[in]  fps  Target frame rate
+ */
+void media_sys_set_video_fps(int fps);
+
 /**
  * @brief  Initialize for board
  */
@@ -35,11 +65,62 @@ void init_board(void);
  */
 int start_webrtc(char *url, char *token);
 
+/**
+ * @brief  Start WebRTC with a participant token taken from the token cache
+ *
+ * @note  Tokens are single-use, so every reconnect or profile change takes a
+ *        fresh token from the cache (see token_cache.h); reconnecting stops
+ *        if none can be had
+ *
+ * @param[in]  url    WHIP server URL
+ * @param[in]  token  Bearer token, already consumed from the cache
+ *
+ * @return
+ *       - 0       On success
+ *       - Others  Fail to start
+ */
+int start_webrtc_with_cached_token(char *url, char *token);
+
 /**
  * @brief  Query WebRTC status
  */
 void query_webrtc(void);
 
+/**
+ * @brief  Close the current stats window: store it in the stats history
+ *         (see webrtc_stats.h), publish it on SEI when enabled, and feed it to
+ *         the video profile adaptation, handing a profile change to the
+ *         session task
+ *
+ * @note  Call periodically (every 2 s) from a single task
+ */
+void update_webrtc_stats(void);
+
+/**
+ * @brief  Pin a video profile and apply it to the running session
+ *
+ * @note  A new frame rate is applied to the running capture; a new resolution
+ *        reopens the session from the session task, once a participant token
+ *        is available when the token cache is in use
+ *
+ * @param[in]  index  Profile index (see video_profile.h), or -1 for automatic selection
+ *
+ * @return
+ *       - 0       On success
+ *       - Others  Invalid profile
+ */
+int set_webrtc_video_profile(int index);
+
+/**
+ * @brief  Tell the reconnect logic whether the network is up
+ *
+ * @note  While the network is down a lost session waits instead of retrying,
+ *        and it is reopened as soon as the network is back
+ *
+ * @param[in]  connected  true once the station has an IP address
+ */
+void set_webrtc_network_state(bool connected);
+
 /**
  * @brief  Stop WebRTC
  *
@@ -0,0 +1,192 @@
+/* DHT-11 Driver over RMT Implementation
+ *
+ * The pin is open drain: the host pulls it low for the start pulse and
+ * releases it, then the RMT channel records the sensor's reply as
+ * (level, duration) pairs at 1 us resolution and the bits are decoded from
+ * the high pulse widths. The sampling task shares core 0 with the video
+ * encoder, so the read runs above it from the start pulse until receiving
+ * is armed
+ */
+
+#include "dht_rmt.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/rmt_rx.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+static const char *TAG = "DHT_RMT";
+
+#define DHT_RMT_RESOLUTION_HZ 1000000   // 1 tick = 1 us
+#define DHT_RMT_SYMBOLS 64              // Reply is about 43 symbols
+#define DHT_START_LOW_MS 20             // Host start pulse, at least 18 ms for DHT-11
+#define DHT_REPLY_TIMEOUT_MS 20         // Reply takes about 5 ms
+#define DHT_GLITCH_NS 1000              // Shorter pulses are noise
+#define DHT_IDLE_NS 200000              // Line idle this long ends the reply
+#define DHT_BIT_ONE_MIN_US 48           // A 0 bit is high for ~27 us, a 1 bit for ~70 us
+#define DHT_FRAME_BITS 40
+
+// Held from the start pulse until receiving is armed. The task sleeps for
+// most of it, and releasing the line and arming take a few microseconds
+#define DHT_ARM_PRIORITY (configMAX_PRIORITIES - 1)
+
+typedef struct {
+    rmt_channel_handle_t channel;
+    gpio_num_t gpio;
+    QueueHandle_t done;                 // Symbol count from the receive-done callback
+    SemaphoreHandle_t lock;
+    rmt_symbol_word_t symbols[DHT_RMT_SYMBOLS];
+
+    // Last read, returned again when reads come faster than the sensor allows
+    int64_t last_read_us;
+    bool last_ok;
+    int16_t last_temperature_deci;
+    uint16_t last_humidity_deci;
+} dht_rmt_t;
+
+static dht_rmt_t g_dht = {
+    .gpio = GPIO_NUM_NC,
+};
+
+static bool IRAM_ATTR on_recv_done(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata,
+                                   void *user_ctx) {
+    BaseType_t woken = pdFALSE;
+    size_t num_symbols = edata->num_symbols;
+    xQueueSendFromISR(g_dht.done, &num_symbols, &woken);
+    return woken == pdTRUE;
+}
+
+bool dht_rmt_init(gpio_num_t gpio) {
+    if (g_dht.channel) return true;
+
+    g_dht.done = xQueueCreate(1, sizeof(size_t));
+    g_dht.lock = xSemaphoreCreateMutex();
+    if (!g_dht.done || !g_dht.lock) {
+        ESP_LOGE(TAG, "Failed to create DHT locks");
+        return false;
+    }
+
+    rmt_rx_channel_config_t channel_config = {
+        .gpio_num = gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = DHT_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DHT_RMT_SYMBOLS,
+    };
+    esp_err_t err = rmt_new_rx_channel(&channel_config, &g_dht.channel);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Failed to create RMT channel: %s", esp_err_to_name(err));
+        g_dht.channel = NULL;
+        return false;
+    }
+    rmt_rx_event_callbacks_t callbacks = {
+        .on_recv_done = on_recv_done,
+    };
+    rmt_rx_register_event_callbacks(g_dht.channel, &callbacks, NULL);
+    rmt_enable(g_dht.channel);
+
+    // RMT keeps the input, the host drives the start pulse as open drain
+    gpio_set_direction(gpio, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(gpio, GPIO_PULLUP_ONLY);
+    gpio_set_level(gpio, 1);
+    g_dht.gpio = gpio;
+
+    ESP_LOGI(TAG, "🌡️  DHT-11 on GPIO%d captured with RMT", gpio);
+    return true;
+}
+
+/**
+ * @brief Decode the last 40 high pulses of a reply into bytes
+ *
+ * The reply starts with an 80 us response pulse, which may or may not be
+ * captured depending on how fast receiving started, so bits are taken from
+ * the end.
+ */
+static bool decode_frame(const rmt_symbol_word_t *symbols, size_t num_symbols, uint8_t frame[5]) {
+    uint16_t highs[DHT_RMT_SYMBOLS];
+    int high_count = 0;
+    for (size_t i = 0; i < num_symbols; i++) {
+        const rmt_symbol_word_t *symbol = &symbols[i];
+        if (symbol->level0 && symbol->duration0) highs[high_count++] = symbol->duration0;
+        if (symbol->level1 && symbol->duration1) highs[high_count++] = symbol->duration1;
+        if (high_count > DHT_RMT_SYMBOLS - 2) break;
+    }
+    if (high_count < DHT_FRAME_BITS) {
+        ESP_LOGD(TAG, "Short reply: %d high pulses in %d symbols", high_count, (int)num_symbols);
+        return false;
+    }
+
+    memset(frame, 0, 5);
+    const uint16_t *bits = &highs[high_count - DHT_FRAME_BITS];
+    for (int i = 0; i < DHT_FRAME_BITS; i++) {
+        frame[i / 8] = (frame[i / 8] << 1) | (bits[i] >= DHT_BIT_ONE_MIN_US);
+    }
+
+    uint8_t checksum = (uint8_t)(frame[0] + frame[1] + frame[2] + frame[3]);
+    if (checksum != frame[4]) {
+        ESP_LOGD(TAG, "Checksum mismatch: %02x != %02x", checksum, frame[4]);
+        return false;
+    }
+    // A line stuck low decodes as all zeros with a valid checksum
+    return frame[0] != 0 || frame[2] != 0;
+}
+
+static bool read_frame(uint8_t frame[5]) {
+    rmt_receive_config_t receive_config = {
+        .signal_range_min_ns = DHT_GLITCH_NS,
+        .signal_range_max_ns = DHT_IDLE_NS,
+    };
+    size_t num_symbols = 0;
+    xQueueReset(g_dht.done);
+
+    // The reply starts 20-40 us after the line is released, so the encoder
+    // must not get the core between the release and rmt_receive, and must
+    // not stretch the start pulse by delaying the wake-up
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, DHT_ARM_PRIORITY);
+
+    // Start pulse: an ordinary task delay, nothing spins
+    gpio_set_level(g_dht.gpio, 0);
+    vTaskDelay(pdMS_TO_TICKS(DHT_START_LOW_MS) + 1);
+    gpio_set_level(g_dht.gpio, 1);
+
+    esp_err_t err = rmt_receive(g_dht.channel, g_dht.symbols, sizeof(g_dht.symbols), &receive_config);
+    vTaskPrioritySet(NULL, priority);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "RMT receive failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (xQueueReceive(g_dht.done, &num_symbols, pdMS_TO_TICKS(DHT_REPLY_TIMEOUT_MS)) != pdTRUE) {
+        // No reply, cancel the pending receive
+        rmt_disable(g_dht.channel);
+        rmt_enable(g_dht.channel);
+        ESP_LOGD(TAG, "No reply from sensor");
+        return false;
+    }
+    return decode_frame(g_dht.symbols, num_symbols, frame);
+}
+
+bool dht_rmt_read(int16_t *temperature_deci, uint16_t *humidity_deci) {
+    if (!g_dht.channel || !temperature_deci || !humidity_deci) return false;
+
+    xSemaphoreTake(g_dht.lock, portMAX_DELAY);
+    int64_t now_us = esp_timer_get_time();
+    if (g_dht.last_read_us == 0 || now_us - g_dht.last_read_us >= (int64_t)DHT_RMT_MIN_INTERVAL_MS * 1000) {
+        uint8_t frame[5];
+        g_dht.last_read_us = now_us;
+        g_dht.last_ok = read_frame(frame);
+        if (g_dht.last_ok) {
+            // DHT-11: integral and decimal bytes, sign in bit 7 of the temperature decimal
+            int temperature = frame[2] * 10 + (frame[3] & 0x7f);
+            g_dht.last_temperature_deci = (int16_t)(frame[3] & 0x80 ? -temperature : temperature);
+            g_dht.last_humidity_deci = (uint16_t)(frame[0] * 10 + frame[1]);
+        }
+    }
+    bool ok = g_dht.last_ok;
+    *temperature_deci = g_dht.last_temperature_deci;
+    *humidity_deci = g_dht.last_humidity_deci;
+    xSemaphoreGive(g_dht.lock);
+    return ok;
+}
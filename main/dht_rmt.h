@@ -0,0 +1,44 @@
+/* DHT-11 Driver over RMT
+ *
+ * Reads a DHT-11 by timing its response with an RMT receive channel instead
+ * of bit-banging: the host start pulse is a plain GPIO level held with a
+ * task delay, and the 40 data bits are captured by the peripheral. No
+ * interrupts are disabled and no CPU time is spent busy-waiting, so a read
+ * doesn't add jitter to other threads.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Shortest time between two reads the sensor supports
+#define DHT_RMT_MIN_INTERVAL_MS 2000
+
+/**
+ * @brief Claim an RMT receive channel for the sensor on a GPIO
+ *
+ * @param gpio Data pin, needs a pull-up (most modules have one)
+ * @return true on success
+ */
+bool dht_rmt_init(gpio_num_t gpio);
+
+/**
+ * @brief Read the sensor
+ *
+ * Blocks the caller for about 25 ms. Safe to call from several tasks.
+ *
+ * @param temperature_deci Temperature in tenths of a degree Celsius
+ * @param humidity_deci Relative humidity in tenths of a percent
+ * @return true if a frame with a valid checksum was received
+ */
+bool dht_rmt_read(int16_t *temperature_deci, uint16_t *humidity_deci);
+
+#ifdef __cplusplus
+}
+#endif
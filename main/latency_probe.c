@@ -0,0 +1,185 @@
+/* Latency Probe Implementation
+ *
+ * Fixed ring of per-frame stage times guarded by a spinlock, written from
+ * the capture, encoder and peer threads; entries are small, so readers copy
+ * them out instead of holding the lock
+ */
+
+#include "latency_probe.h"
+#include "settings.h"
+#include <string.h>
+#include <sys/time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif_sntp.h"
+#include "freertos/FreeRTOS.h"
+
+#ifndef LATENCY_PROBE_INTERVAL_MS
+#define LATENCY_PROBE_INTERVAL_MS 1000
+#endif
+
+#ifndef LATENCY_PROBE_SNTP_SERVER
+#define LATENCY_PROBE_SNTP_SERVER "pool.ntp.org"
+#endif
+
+// Clock readings before this (2023-11-14) mean the time was never set
+#define LATENCY_CLOCK_VALID_SEC 1700000000
+
+static const char *TAG = "LATENCY_PROBE";
+
+typedef struct {
+    latency_frame_t frames[LATENCY_PROBE_RING_SIZE];
+    int next;                   // Slot the next captured frame takes
+    int count;
+    uint32_t interval_ms;
+    int64_t last_probe_us;
+    uint32_t next_seq;
+    uint32_t probes;
+    uint32_t unmatched;
+    bool sntp_started;
+    portMUX_TYPE lock;
+} latency_probe_ring_t;
+
+static latency_probe_ring_t g_probe = {
+    .interval_ms = LATENCY_PROBE_INTERVAL_MS,
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+bool latency_probe_init(void) {
+    if (LATENCY_PROBE_SNTP_SERVER[0] == '\0') {
+        ESP_LOGI(TAG, "⏱️  No SNTP server, probes carry device time only");
+        return true;
+    }
+    // SNTP waits for connectivity on its own, and keeps the clock in sync afterwards
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(LATENCY_PROBE_SNTP_SERVER);
+    esp_err_t err = esp_netif_sntp_init(&config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Failed to start SNTP: %s", esp_err_to_name(err));
+        return false;
+    }
+    g_probe.sntp_started = true;
+    ESP_LOGI(TAG, "⏱️  Syncing clock with %s", LATENCY_PROBE_SNTP_SERVER);
+    return true;
+}
+
+/**
+ * @brief Find the newest entry of a frame, must be called with the lock held
+ */
+static latency_frame_t *find_frame(uint32_t pts) {
+    for (int i = 0; i < g_probe.count; i++) {
+        int slot = (g_probe.next - 1 - i + LATENCY_PROBE_RING_SIZE) % LATENCY_PROBE_RING_SIZE;
+        if (g_probe.frames[slot].pts == pts) {
+            return &g_probe.frames[slot];
+        }
+    }
+    return NULL;
+}
+
+void latency_probe_mark(latency_stage_t stage, uint32_t pts) {
+    if (stage >= LATENCY_STAGE_COUNT) return;
+
+    int64_t now_us = esp_timer_get_time();
+    taskENTER_CRITICAL(&g_probe.lock);
+    if (stage == LATENCY_STAGE_CAPTURE) {
+        latency_frame_t *frame = &g_probe.frames[g_probe.next];
+        memset(frame, 0, sizeof(*frame));
+        frame->pts = pts;
+        frame->stage_us[LATENCY_STAGE_CAPTURE] = now_us;
+        g_probe.next = (g_probe.next + 1) % LATENCY_PROBE_RING_SIZE;
+        if (g_probe.count < LATENCY_PROBE_RING_SIZE) {
+            g_probe.count++;
+        }
+    } else {
+        latency_frame_t *frame = find_frame(pts);
+        if (frame && frame->stage_us[stage] == 0) {
+            frame->stage_us[stage] = now_us;
+        }
+    }
+    taskEXIT_CRITICAL(&g_probe.lock);
+}
+
+int64_t latency_probe_unix_time_us(void) {
+    struct timeval tv;
+    if (gettimeofday(&tv, NULL) != 0 || tv.tv_sec < LATENCY_CLOCK_VALID_SEC) {
+        return 0;
+    }
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+bool latency_probe_wait_clock(uint32_t timeout_ms) {
+    if (latency_probe_unix_time_us() != 0) return true;
+    if (!g_probe.sntp_started) return false;
+    return esp_netif_sntp_sync_wait(pdMS_TO_TICKS(timeout_ms)) == ESP_OK;
+}
+
+bool latency_probe_on_send(uint32_t pts, latency_probe_t *probe) {
+    if (!probe) return false;
+
+    int64_t now_us = esp_timer_get_time();
+    int64_t unix_now_us = latency_probe_unix_time_us();
+    bool due = false;
+
+    taskENTER_CRITICAL(&g_probe.lock);
+    latency_frame_t *frame = find_frame(pts);
+    if (!frame) {
+        g_probe.unmatched++;
+    } else {
+        if (frame->stage_us[LATENCY_STAGE_SEND] == 0) {
+            frame->stage_us[LATENCY_STAGE_SEND] = now_us;
+        }
+        due = g_probe.interval_ms > 0 &&
+              now_us - g_probe.last_probe_us >= (int64_t)g_probe.interval_ms * 1000;
+    }
+    if (due) {
+        int64_t capture_us = frame->stage_us[LATENCY_STAGE_CAPTURE];
+        int64_t encoded_us = frame->stage_us[LATENCY_STAGE_ENCODED];
+        probe->seq = g_probe.next_seq++;
+        probe->pts = pts;
+        probe->capture_us = capture_us;
+        // The wall clock is read now, so map the capture back by the elapsed device time
+        probe->capture_unix_us = unix_now_us ? unix_now_us - (now_us - capture_us) : 0;
+        probe->encode_us = encoded_us ? (uint32_t)(encoded_us - capture_us) : 0;
+        probe->send_us = (uint32_t)(frame->stage_us[LATENCY_STAGE_SEND] - capture_us);
+        g_probe.last_probe_us = now_us;
+        g_probe.probes++;
+    }
+    taskEXIT_CRITICAL(&g_probe.lock);
+    return due;
+}
+
+void latency_probe_set_interval(uint32_t interval_ms) {
+    taskENTER_CRITICAL(&g_probe.lock);
+    g_probe.interval_ms = interval_ms;
+    g_probe.last_probe_us = 0;
+    taskEXIT_CRITICAL(&g_probe.lock);
+}
+
+uint32_t latency_probe_get_interval(void) {
+    taskENTER_CRITICAL(&g_probe.lock);
+    uint32_t interval_ms = g_probe.interval_ms;
+    taskEXIT_CRITICAL(&g_probe.lock);
+    return interval_ms;
+}
+
+int latency_probe_get_recent(latency_frame_t *out, int max_count) {
+    if (!out || max_count <= 0) return 0;
+
+    taskENTER_CRITICAL(&g_probe.lock);
+    int count = g_probe.count < max_count ? g_probe.count : max_count;
+    for (int i = 0; i < count; i++) {
+        int slot = (g_probe.next - 1 - i + LATENCY_PROBE_RING_SIZE) % LATENCY_PROBE_RING_SIZE;
+        out[i] = g_probe.frames[slot];
+    }
+    taskEXIT_CRITICAL(&g_probe.lock);
+    return count;
+}
+
+void latency_probe_get_stats(latency_probe_stats_t *out) {
+    if (!out) return;
+
+    taskENTER_CRITICAL(&g_probe.lock);
+    out->probes = g_probe.probes;
+    out->unmatched = g_probe.unmatched;
+    taskEXIT_CRITICAL(&g_probe.lock);
+    out->clock_set = latency_probe_unix_time_us() != 0;
+}
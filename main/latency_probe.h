@@ -0,0 +1,137 @@
+/* Latency Probe
+ *
+ * Records when each video frame passes the capture source, leaves the
+ * encoder and reaches the peer's send callback, in a small ring matched by
+ * PTS, and periodically hands out a probe with the stage times of the frame
+ * being sent. Published as SEI in that frame, a probe lets viewers measure
+ * capture-to-display latency in band; with the clock set over SNTP it
+ * carries the capture time as wall-clock time.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Frames whose stage times are kept; covers the camera buffers plus the encoder and send queue
+#define LATENCY_PROBE_RING_SIZE 16
+
+/**
+ * @brief Points on the video path where a frame is timestamped
+ */
+typedef enum {
+    LATENCY_STAGE_CAPTURE = 0,  /*!< Frame taken from the V4L2/DVP source */
+    LATENCY_STAGE_ENCODED,      /*!< Camera buffer handed back after encoding */
+    LATENCY_STAGE_SEND,         /*!< Encoded frame reached on_video_send */
+    LATENCY_STAGE_COUNT,
+} latency_stage_t;
+
+/**
+ * @brief Stage times of one frame
+ */
+typedef struct {
+    uint32_t pts;                           /*!< Frame PTS, milliseconds */
+    int64_t stage_us[LATENCY_STAGE_COUNT];  /*!< esp_timer time of each stage, 0 if not seen */
+} latency_frame_t;
+
+/**
+ * @brief Probe for one sent frame
+ */
+typedef struct {
+    uint32_t seq;               /*!< Probe sequence number, gaps mean lost probes */
+    uint32_t pts;               /*!< PTS of the frame the probe describes */
+    int64_t capture_us;         /*!< Capture time, esp_timer microseconds */
+    int64_t capture_unix_us;    /*!< Capture time, microseconds since the Unix epoch, 0 if the clock isn't set */
+    uint32_t encode_us;         /*!< Capture to encoded, 0 if not seen */
+    uint32_t send_us;           /*!< Capture to on_video_send */
+} latency_probe_t;
+
+/**
+ * @brief Probe counters
+ */
+typedef struct {
+    uint32_t probes;            /*!< Probes handed out */
+    uint32_t unmatched;         /*!< Sent frames with no capture record (PTS rewritten or ring overrun) */
+    bool clock_set;             /*!< Wall-clock time is available */
+} latency_probe_stats_t;
+
+/**
+ * @brief Start clock sync for wall-clock capture times
+ *
+ * Call once the network stack is initialized. Starts SNTP against
+ * LATENCY_PROBE_SNTP_SERVER unless it is empty. This is the only SNTP
+ * client of the application; anything else needing wall-clock time waits
+ * for it with latency_probe_wait_clock.
+ *
+ * @return true on success
+ */
+bool latency_probe_init(void);
+
+/**
+ * @brief Current wall-clock time from the SNTP-set clock
+ *
+ * @return Microseconds since the Unix epoch, 0 if the clock was never set
+ */
+int64_t latency_probe_unix_time_us(void);
+
+/**
+ * @brief Wait until the clock is set
+ *
+ * @param timeout_ms Longest time to wait for the first SNTP sync
+ * @return true if the clock is set
+ */
+bool latency_probe_wait_clock(uint32_t timeout_ms);
+
+/**
+ * @brief Timestamp a frame at a stage
+ *
+ * LATENCY_STAGE_CAPTURE starts a new ring entry; later stages fill in the
+ * entry with the same PTS. Safe from any task.
+ *
+ * @param stage Stage reached
+ * @param pts Frame PTS, milliseconds
+ */
+void latency_probe_mark(latency_stage_t stage, uint32_t pts);
+
+/**
+ * @brief Timestamp a frame at the send callback and take a probe when one is due
+ *
+ * @param pts Frame PTS, milliseconds
+ * @param probe Filled when a probe is due
+ * @return true if probe should be published in this frame
+ */
+bool latency_probe_on_send(uint32_t pts, latency_probe_t *probe);
+
+/**
+ * @brief Set the time between two probes
+ *
+ * @param interval_ms Probe interval, 0 to stop probing (stages are still recorded)
+ */
+void latency_probe_set_interval(uint32_t interval_ms);
+
+/**
+ * @brief Get the time between two probes, 0 when probing is off
+ */
+uint32_t latency_probe_get_interval(void);
+
+/**
+ * @brief Copy the most recent frames, newest first
+ *
+ * @param out Array to fill
+ * @param max_count Capacity of out
+ * @return Number of frames copied
+ */
+int latency_probe_get_recent(latency_frame_t *out, int max_count);
+
+/**
+ * @brief Get the probe counters
+ */
+void latency_probe_get_stats(latency_probe_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
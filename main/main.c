@@ -19,23 +19,30 @@
 #include "media_lib_adapter.h"
 #include "media_lib_os.h"
 #include "esp_timer.h"
-#include "webrtc_utils_time.h"
 #include "esp_cpu.h"
 #include "settings.h"
 #include "common.h"
 #include "driver/gpio.h"
-#include "esp_http_client.h"
-#include "cJSON.h"
-#include "esp_crt_bundle.h"
 #include "esp_system.h"
 #include <inttypes.h>
+#include <stdlib.h>
 #include "sei.h"
 #include "video_sei_hook.h"
+#include "sei_metrics.h"
+#include "sei_bench.h"
+#include "video_profile.h"
+#include "webrtc_stats.h"
+#include "token_cache.h"
+#include "sensor_sampler.h"
+#include "thread_placement.h"
+#include "latency_probe.h"
+#include "telemetry_log.h"
 #include "esp_capture.h"
 #include "driver/gpio.h"
 #include "esp_timer.h"
+#include "freertos/event_groups.h"
 #if SEI_ENABLE_DHT11
-#include "dht.h"
+#include "dht_rmt.h"
 #endif
 
 // clang-format on
@@ -48,51 +55,106 @@
 
 #define BUTTON_GPIO GPIO_NUM_35 // Use GPIO 35 (BOOT button)
 #define BUTTON_ACTIVE_LEVEL 0   // 0 for pull-up (pressed = LOW)
+#define BUTTON_DEBOUNCE_MS 30   // Level must still be pressed after this
+#define BUTTON_HOLDOFF_MS 300   // Presses ignored after a toggle
 
 // DHT-11 Configuration
 #define DHT11_GPIO GPIO_NUM_23  // GPIO23 (J1 Pin 7)
 #define DHT11_READ_INTERVAL_MS 5000  // Read every 5 seconds
 
-// Token API configuration
-// clang-format off
-#define TOKEN_REQUEST_BODY                                                     \
-  "{\"stageArn\": \"" STAGE_ARN "\", \"capabilities\": [\"PUBLISH\"]," \
-  "\"attributes\": {\"username\": \"" PARTICIPANT_NAME "\"}}"
-// clang-format on
+// Replay a logged reading only while the SEI queue holds fewer messages than this
+#define TELEMETRY_REPLAY_MAX_QUEUED 2
+
+// How long a stream start waits for a token when none is cached yet
+#define TOKEN_WAIT_MS 10000
+
+// How long a stream start waits for the camera and encoders to come up
+#define MEDIA_READY_WAIT_MS 10000
+
+// How long the first console start waits for the clock to be set over SNTP
+#define CLOCK_SYNC_WAIT_MS 10000
+#define MEDIA_READY_BIT BIT0
 
 static const char *TAG = "IVS_WHIP_DEMO";
 static bool publishing_active = false;
-static bool last_button_state = true;  // Assume released initially (pull-up)
-static char *current_token = NULL;     // Dynamically fetched token
+static TaskHandle_t button_task_handle; // Woken by the button interrupt
+static char current_token[TOKEN_CACHE_MAX_LEN]; // Token of the latest stream
 static bool sei_system_active = false; // Track SEI system state
+static EventGroupHandle_t media_events; // MEDIA_READY_BIT once media_sys is built
 
 #if SEI_ENABLE_DHT11
 static bool dht11_initialized = false;
-static float last_temperature = 0.0;
-static float last_humidity = 0.0;
+static int16_t last_temp_deci = 0;   // Tenths of a degree Celsius
+static uint16_t last_hum_deci = 0;   // Tenths of a percent
+
+// Tenths printed as "-12.3" without float formatting
+#define DECI_FMT "%s%d.%d"
+#define DECI_ARGS(v) ((v) < 0 ? "-" : ""), abs(v) / 10, abs(v) % 10
 #endif
 
 // Forward declarations
-static bool fetch_token(void);
+static bool take_token(void);
 static void sei_message_task(void *arg); 
 #if SEI_ENABLE_DHT11
-static bool dht11_init(void);
-static bool dht11_read(float *temperature, float *humidity);
-static void dht11_task(void *arg);
+static bool dht11_init(void *ctx);
+static bool dht11_read(int16_t *temp_deci, uint16_t *hum_deci);
+static bool dht11_sample(void *ctx);
+static bool replay_telemetry(const telemetry_record_t *record, void *ctx);
 #endif
 
-static int start_publish(int argc, char **argv) {
-  static bool sntp_synced = false;
-  if (sntp_synced == false) {
-    if (0 == webrtc_utils_time_sync_init()) {
-      sntp_synced = true;
+// Camera and encoders come up on their own task, next to Wi-Fi association
+static void media_init_task(void *arg) {
+  int64_t start_us = esp_timer_get_time();
+  media_sys_buildup();
+  int64_t now_us = esp_timer_get_time();
+  ESP_LOGI(TAG, "🎥 Media system ready in %" PRId64 " ms (%" PRId64 " ms after boot)",
+           (now_us - start_us) / 1000, now_us / 1000);
+  xEventGroupSetBits(media_events, MEDIA_READY_BIT);
+  vTaskDelete(NULL);
+}
+
+static void start_media_init(void) {
+  media_events = xEventGroupCreate();
+  if (!media_events ||
+      xTaskCreatePinnedToCore(media_init_task, "media_init", 8192, NULL, 5,
+                              NULL, 1) != pdPASS) {
+    // Build it here instead, nothing waits then
+    ESP_LOGW(TAG, "⚠️ Building media system synchronously");
+    if (media_events) {
+      vEventGroupDelete(media_events);
+      media_events = NULL;
     }
+    media_sys_buildup();
+  }
+}
+
+static bool wait_media_ready(void) {
+  if (!media_events) {
+    return true;
+  }
+  EventBits_t bits =
+      xEventGroupWaitBits(media_events, MEDIA_READY_BIT, pdFALSE, pdTRUE,
+                          pdMS_TO_TICKS(MEDIA_READY_WAIT_MS));
+  if (!(bits & MEDIA_READY_BIT)) {
+    ESP_LOGE(TAG, "❌ Media system not ready after %d ms", MEDIA_READY_WAIT_MS);
+    return false;
+  }
+  return true;
+}
+
+static int start_publish(int argc, char **argv) {
+  if (!wait_media_ready()) {
+    return -1;
+  }
+  // SNTP runs from boot (see latency_probe_init), only the first start waits for it
+  if (!latency_probe_wait_clock(CLOCK_SYNC_WAIT_MS)) {
+    ESP_LOGW(TAG, "⚠️ Clock not set yet, starting anyway");
   }
   if (argc == 1) {
-    // Fetch fresh token and use it
-    if (fetch_token() && current_token) {
+    // Use the prefetched token
+    if (take_token()) {
       ESP_LOGI(TAG, "🚀 Starting WHIP stream with fresh token via console");
-      start_webrtc(WHIP_SERVER, current_token);
+      start_webrtc_with_cached_token(WHIP_SERVER, current_token);
     } else {
       ESP_LOGE(TAG, "❌ Failed to fetch token, using fallback token");
       start_webrtc(WHIP_SERVER, WHIP_TOKEN);
@@ -128,6 +190,9 @@ static int wifi_cli(int argc, char **argv) {
 }
 
 static int capture_to_player_cli(int argc, char **argv) {
+  if (!wait_media_ready()) {
+    return -1;
+  }
   return test_capture_to_player();
 }
 
@@ -159,6 +224,26 @@ static int sei_text_cli(int argc, char **argv) {
   return 0;
 }
 
+static int sei_cue_cli(int argc, char **argv) {
+  if (argc < 3) {
+    printf("Usage: sei_cue <delay_ms> <message>\n");
+    return -1;
+  }
+
+  if (!sei_system_active) {
+    printf("SEI system not active\n");
+    return -1;
+  }
+
+  uint32_t delay_ms = (uint32_t)atoi(argv[1]);
+  if (sei_send_text_cue(argv[2], delay_ms)) {
+    printf("SEI text cue queued %" PRIu32 " ms ahead: %s\n", delay_ms, argv[2]);
+  } else {
+    printf("Failed to queue SEI text cue\n");
+  }
+  return 0;
+}
+
 static int sei_json_cli(int argc, char **argv) {
   if (argc < 3) {
     printf("Usage: sei_json <role> <content>\n");
@@ -195,6 +280,23 @@ static int sei_status_cli(int argc, char **argv) {
     printf("Video hook stats: %" PRIu32 " frames, %" PRIu32
            " SEI units, %" PRIu32 " bytes\n",
            frames_processed, sei_units_inserted, total_sei_bytes);
+
+    video_sei_channel_t channels[VIDEO_SEI_HOOK_MAX_PUBLISHERS];
+    int channel_count =
+        video_sei_hook_get_publishers(channels, VIDEO_SEI_HOOK_MAX_PUBLISHERS);
+    for (int i = 0; i < channel_count; i++) {
+      printf("  publisher %-10s priority %3d, %d pending\n", channels[i].name,
+             channels[i].priority,
+             sei_publisher_get_queue_size(channels[i].publisher));
+    }
+
+    video_sei_hook_stage_info_t stages[VIDEO_SEI_HOOK_MAX_STAGES];
+    int stage_count =
+        video_sei_hook_get_stages(stages, VIDEO_SEI_HOOK_MAX_STAGES);
+    for (int i = 0; i < stage_count; i++) {
+      printf("  stage %d %-10s %" PRIu32 " failures, max %" PRIu32 " us\n",
+             i, stages[i].name, stages[i].failures, stages[i].max_us);
+    }
   } else {
     printf("Failed to get SEI queue status\n");
   }
@@ -233,7 +335,9 @@ static int sei_test_hook_cli(int argc, char **argv) {
     } else {
       printf("ℹ️  No SEI data added (no messages queued)\n");
     }
-    free(output_data);
+    video_frame_pool_release(output_data);
+  } else if (!result && !output_data) {
+    printf("ℹ️  Frame passed through unchanged (no messages queued)\n");
   } else {
     printf("❌ SEI hook test failed\n");
   }
@@ -241,6 +345,290 @@ static int sei_test_hook_cli(int argc, char **argv) {
   return 0;
 }
 
+static int sei_metrics_cli(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+    sei_metrics_reset();
+    printf("SEI metrics reset\n");
+    return 0;
+  }
+
+  // Everything the hook does per frame has to fit in one frame interval
+  const uint32_t frame_budget_us = 1000000 / video_profile_current()->fps;
+  printf("%-14s %8s %8s %8s %8s %8s\n", "stage", "count", "avg_us", "p50_us",
+         "p99_us", "max_us");
+  for (int i = 0; i < SEI_STAGE_COUNT; i++) {
+    sei_metrics_summary_t summary;
+    sei_metrics_get_summary(i, &summary);
+    uint32_t avg_us =
+        summary.count ? (uint32_t)(summary.total_us / summary.count) : 0;
+    printf("%-14s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32
+           " %8" PRIu32 "\n",
+           sei_metrics_stage_name(i), summary.count, avg_us, summary.p50_us,
+           summary.p99_us, summary.max_us);
+  }
+  for (int i = 0; i < SEI_EVENT_COUNT; i++) {
+    printf("%-14s %8" PRIu32 "\n", sei_metrics_event_name(i),
+           sei_metrics_get_count(i));
+  }
+
+  sei_metrics_summary_t hook;
+  sei_metrics_get_summary(SEI_STAGE_HOOK_FRAME, &hook);
+  if (hook.count == 0) {
+    printf("ℹ️  No frames through the hook yet\n");
+  } else if (hook.max_us < frame_budget_us) {
+    printf("✅ Hook max %" PRIu32 " us is within the %" PRIu32
+           " us frame budget\n",
+           hook.max_us, frame_budget_us);
+  } else {
+    printf("⚠️ Hook max %" PRIu32 " us exceeds the %" PRIu32
+           " us frame budget\n",
+           hook.max_us, frame_budget_us);
+  }
+  return 0;
+}
+
+static int sei_bench_cli(int argc, char **argv) {
+  sei_bench_config_t config = {
+      .iterations = argc > 1 ? atoi(argv[1]) : SEI_BENCH_DEFAULT_ITERATIONS,
+      .payload_size = argc > 2 ? (size_t)atoi(argv[2]) : 128,
+      .repeat_count = argc > 3 ? atoi(argv[3]) : SEI_DEFAULT_REPEAT_COUNT,
+  };
+  return sei_bench_run(&config) ? 0 : -1;
+}
+
+static int video_profile_cli(int argc, char **argv) {
+  if (argc > 1) {
+    int index = strcmp(argv[1], "auto") == 0 ? -1 : atoi(argv[1]);
+    if (set_webrtc_video_profile(index) != 0) {
+      printf("❌ Failed to select video profile %s\n", argv[1]);
+      return -1;
+    }
+  }
+
+  printf("Video profile selection: %s\n",
+         video_profile_is_auto() ? "auto" : "pinned");
+  for (int i = 0; i < video_profile_count(); i++) {
+    const video_profile_t *profile = video_profile_get(i);
+    printf("%s %d: %-7s %4dx%-4d @ %2d fps\n",
+           i == video_profile_current_index() ? "*" : " ", i, profile->name,
+           profile->width, profile->height, profile->fps);
+  }
+  return 0;
+}
+
+static int webrtc_stats_cli(int argc, char **argv) {
+  static webrtc_stats_sample_t samples[WEBRTC_STATS_HISTORY];
+  int max_count = argc > 1 ? atoi(argv[1]) : 10;
+  if (max_count <= 0 || max_count > WEBRTC_STATS_HISTORY) {
+    max_count = WEBRTC_STATS_HISTORY;
+  }
+  int count = webrtc_stats_get_recent(samples, max_count);
+  if (count == 0) {
+    printf("ℹ️  No WebRTC stats yet (sampled every 2 s while streaming)\n");
+    return 0;
+  }
+
+  printf("%10s %6s %6s %8s %6s %5s %5s %5s %6s %6s %5s %4s %8s %4s\n",
+         "time_ms", "int_ms", "fps", "kbps", "dly_ms", "idr", "miss", "late",
+         "sei_pt", "sei_dr", "sei_q", "pool", "heap", "prof");
+  for (int i = 0; i < count; i++) {
+    const webrtc_stats_sample_t *s = &samples[i];
+    uint32_t fps_x10 = webrtc_stats_fps_x10(s);
+    printf("%10" PRIu32 " %6" PRIu32 " %4" PRIu32 ".%" PRIu32 " %8" PRIu32
+           " %6" PRIu32 " %5" PRIu32 " %5" PRIu32 " %5" PRIu32 " %6" PRIu32
+           " %6" PRIu32 " %5u %4u %8" PRIu32 " %4u\n",
+           s->timestamp_ms, s->interval_ms, fps_x10 / 10, fps_x10 % 10,
+           s->send_kbps, s->max_send_delay_ms, s->keyframes, s->frames_missed,
+           s->frames_late, s->sei_passthrough, s->sei_dropped,
+           (unsigned)s->sei_queue_depth, (unsigned)s->frame_pool_in_use,
+           s->free_heap, (unsigned)s->profile_index);
+  }
+  return 0;
+}
+
+static int latency_cli(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "off") == 0) {
+    latency_probe_set_interval(0);
+    printf("Latency probes stopped\n");
+    return 0;
+  }
+  if (argc > 1 && strcmp(argv[1], "every") == 0) {
+    if (argc < 3 || atoi(argv[2]) <= 0) {
+      printf("Usage: latency every <interval_ms>\n");
+      return -1;
+    }
+    latency_probe_set_interval((uint32_t)atoi(argv[2]));
+    printf("Latency probe every %d ms\n", atoi(argv[2]));
+    return 0;
+  }
+
+  latency_frame_t frames[LATENCY_PROBE_RING_SIZE];
+  int max_count = argc > 1 ? atoi(argv[1]) : 8;
+  if (max_count <= 0 || max_count > LATENCY_PROBE_RING_SIZE) {
+    max_count = LATENCY_PROBE_RING_SIZE;
+  }
+  latency_probe_stats_t stats;
+  latency_probe_get_stats(&stats);
+  uint32_t interval_ms = latency_probe_get_interval();
+  printf("Probes: %" PRIu32 " sent, %" PRIu32 " unmatched frames, every %" PRIu32
+         " ms%s, wall clock %s\n",
+         stats.probes, stats.unmatched, interval_ms, interval_ms ? "" : " (off)",
+         stats.clock_set ? "set" : "not set");
+
+  int count = latency_probe_get_recent(frames, max_count);
+  if (count == 0) {
+    printf("ℹ️  No frames captured yet\n");
+    return 0;
+  }
+  // Stage deltas in microseconds, '-' for a stage the frame hasn't reached
+  printf("%10s %10s %10s %10s\n", "pts", "enc_us", "send_us", "total_us");
+  for (int i = 0; i < count; i++) {
+    const latency_frame_t *f = &frames[i];
+    int64_t capture = f->stage_us[LATENCY_STAGE_CAPTURE];
+    int64_t encoded = f->stage_us[LATENCY_STAGE_ENCODED];
+    int64_t sent = f->stage_us[LATENCY_STAGE_SEND];
+    char enc[12] = "-", send[12] = "-", total[12] = "-";
+    if (encoded) {
+      snprintf(enc, sizeof(enc), "%" PRId64, encoded - capture);
+    }
+    if (sent) {
+      snprintf(send, sizeof(send), "%" PRId64, encoded ? sent - encoded : sent - capture);
+      snprintf(total, sizeof(total), "%" PRId64, sent - capture);
+    }
+    printf("%10" PRIu32 " %10s %10s %10s\n", f->pts, enc, send, total);
+  }
+  return 0;
+}
+
+static int sensors_cli(int argc, char **argv) {
+  int count = sensor_sampler_count();
+  if (count == 0) {
+    printf("ℹ️  No sensors registered\n");
+    return 0;
+  }
+  printf("%-10s %8s %6s %8s %8s %8s\n", "sensor", "every_ms", "ready",
+         "samples", "failures", "last_us");
+  for (int i = 0; i < count; i++) {
+    sensor_sampler_stats_t stats;
+    if (sensor_sampler_get_stats(i, &stats)) {
+      printf("%-10s %8" PRIu32 " %6s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n",
+             stats.name, stats.interval_ms, stats.ready ? "yes" : "no",
+             stats.samples, stats.failures, stats.last_duration_us);
+    }
+  }
+  return 0;
+}
+
+static int threads_cli(int argc, char **argv) {
+  static thread_usage_t threads[THREAD_PLACEMENT_MAX_THREADS];
+  int count = thread_placement_get_usage(threads, THREAD_PLACEMENT_MAX_THREADS);
+  if (count == 0) {
+    printf("ℹ️  No media threads created yet\n");
+  } else {
+    printf("%-15s %8s %8s %6s %4s %4s %5s\n", "thread", "stack", "min_free",
+           "used%", "prio", "core", "where");
+    for (int i = 0; i < count; i++) {
+      const thread_usage_t *t = &threads[i];
+      uint32_t used = t->stack_size > t->min_free ? t->stack_size - t->min_free : 0;
+      printf("%-15s %8" PRIu32 " %8" PRIu32 " %5" PRIu32 "%% %4u %4d %5s%s\n",
+             t->name, t->stack_size, t->min_free,
+             t->stack_size ? used * 100 / t->stack_size : 0,
+             (unsigned)t->priority, (int)t->core_id,
+             t->stack_in_ext ? "psram" : "int", t->running ? "" : " (exited)");
+    }
+  }
+
+  static thread_placement_t table[16];
+  static bool is_override[16];
+  int entries = thread_placement_get_table(table, is_override, 16);
+  printf("\nPlacement table (- keeps the library value):\n");
+  for (int i = 0; i < entries; i++) {
+    const thread_placement_t *p = &table[i];
+    char stack[12] = "-", prio[8] = "-", core[8] = "-";
+    if (p->stack_size != THREAD_PLACEMENT_KEEP) {
+      snprintf(stack, sizeof(stack), "%d", (int)p->stack_size);
+    }
+    if (p->priority != THREAD_PLACEMENT_KEEP) {
+      snprintf(prio, sizeof(prio), "%d", p->priority);
+    }
+    if (p->core_id != THREAD_PLACEMENT_KEEP) {
+      snprintf(core, sizeof(core), "%d", p->core_id);
+    }
+    printf("  %-15s stack %-7s prio %-3s core %-2s %s%s\n", p->name, stack,
+           prio, core,
+           p->stack_in_ext == THREAD_PLACEMENT_KEEP ? ""
+           : p->stack_in_ext                        ? "psram"
+                                                    : "int",
+           is_override[i] ? " (override)" : "");
+  }
+  return 0;
+}
+
+// A thread_cfg field: '-' keeps the library value, anything else must be a
+// number in range, checked before it is narrowed into thread_placement_t
+static bool parse_thread_field(const char *text, long min, long max,
+                               int *out) {
+  if (strcmp(text, "-") == 0) {
+    *out = THREAD_PLACEMENT_KEEP;
+    return true;
+  }
+  char *end;
+  long value = strtol(text, &end, 0);
+  if (end == text || *end != '\0' || value < min || value > max) {
+    return false;
+  }
+  *out = (int)value;
+  return true;
+}
+
+static int thread_cfg_cli(int argc, char **argv) {
+  if (argc == 3 && strcmp(argv[2], "clear") == 0) {
+    if (!thread_placement_clear_override(argv[1])) {
+      printf("❌ No stored override for %s\n", argv[1]);
+      return -1;
+    }
+    printf("✅ Override for %s removed, applies to threads created from now on\n",
+           argv[1]);
+    return 0;
+  }
+  if (argc < 5 || strlen(argv[1]) >= THREAD_PLACEMENT_NAME_LEN) {
+    printf("Usage: thread_cfg <name|prefix*> <stack|-> <prio|-> <core|-> "
+           "[ext|int]\n       thread_cfg <name|prefix*> clear\n");
+    return -1;
+  }
+  int stack_size, priority, core_id;
+  if (!parse_thread_field(argv[2], 1024, 1024 * 1024, &stack_size) ||
+      !parse_thread_field(argv[3], 0, configMAX_PRIORITIES - 1, &priority) ||
+      !parse_thread_field(argv[4], 0, portNUM_PROCESSORS - 1, &core_id)) {
+    printf("❌ Invalid stack, priority or core\n");
+    return -1;
+  }
+  thread_placement_t placement = {
+      .stack_size = stack_size,
+      .priority = (int8_t)priority,
+      .core_id = (int8_t)core_id,
+      .stack_in_ext = THREAD_PLACEMENT_KEEP,
+  };
+  strcpy(placement.name, argv[1]);
+  if (argc > 5) {
+    if (strcmp(argv[5], "ext") == 0) {
+      placement.stack_in_ext = 1;
+    } else if (strcmp(argv[5], "int") == 0) {
+      placement.stack_in_ext = 0;
+    } else {
+      printf("❌ Stack memory must be ext or int\n");
+      return -1;
+    }
+  }
+  if (!thread_placement_set_override(&placement)) {
+    printf("❌ Failed to store override\n");
+    return -1;
+  }
+  printf("✅ Override for %s stored, applies to threads created from now on\n",
+         argv[1]);
+  return 0;
+}
+
 #if SEI_ENABLE_DHT11
 static int dht11_read_cli(int argc, char **argv) {
   if (!dht11_initialized) {
@@ -248,17 +636,19 @@ static int dht11_read_cli(int argc, char **argv) {
     return -1;
   }
 
-  float temperature, humidity;
-  if (dht11_read(&temperature, &humidity)) {
-    printf("🌡️ DHT-11 Reading: Temperature: %.1f°C, Humidity: %.1f%%\n", temperature, humidity);
+  int16_t temp_deci;
+  uint16_t hum_deci;
+  if (dht11_read(&temp_deci, &hum_deci)) {
+    printf("🌡️ DHT-11 Reading: Temperature: " DECI_FMT "°C, Humidity: " DECI_FMT "%%\n",
+           DECI_ARGS(temp_deci), DECI_ARGS(hum_deci));
     
     // Also send via SEI if system is active
     if (sei_system_active) {
       char json_message[250];
       uint32_t timestamp = esp_timer_get_time() / 1000; // Convert to milliseconds
       snprintf(json_message, sizeof(json_message),
-              "{\"sensor\":\"DHT11\",\"temperature_c\":%.1f,\"humidity_percent\":%.1f,\"timestamp\":%" PRIu32 ",\"status\":\"manual_read\",\"type\":\"sensor_data\"}",
-              temperature, humidity, timestamp);
+              "{\"sensor\":\"DHT11\",\"temperature_c\":" DECI_FMT ",\"humidity_percent\":" DECI_FMT ",\"timestamp\":%" PRIu32 ",\"status\":\"manual_read\",\"type\":\"sensor_data\"}",
+              DECI_ARGS(temp_deci), DECI_ARGS(hum_deci), timestamp);
       
       if (sei_send_raw_json(json_message)) {
         printf("📤 DHT-11 data sent via SEI as raw JSON\n");
@@ -275,11 +665,47 @@ static int dht11_status_cli(int argc, char **argv) {
   printf("  Initialized: %s\n", dht11_initialized ? "Yes" : "No");
   printf("  GPIO Pin: %d\n", DHT11_GPIO);
   printf("  Read Interval: %d seconds\n", DHT11_READ_INTERVAL_MS / 1000);
-  printf("  Last Temperature: %.1f°C\n", last_temperature);
-  printf("  Last Humidity: %.1f%%\n", last_humidity);
+  printf("  Last Temperature: " DECI_FMT "°C\n", DECI_ARGS(last_temp_deci));
+  printf("  Last Humidity: " DECI_FMT "%%\n", DECI_ARGS(last_hum_deci));
   printf("  SEI Publishing: %s\n", (sei_system_active && publishing_active) ? "Active" : "Inactive");
   return 0;
 }
+
+static int telemetry_cli(int argc, char **argv) {
+  if (argc >= 2 && strcmp(argv[1], "flush") == 0) {
+    telemetry_log_flush();
+    printf(telemetry_log_is_online()
+               ? "Telemetry batch is written once the stream is down\n"
+               : "Telemetry batch flushed\n");
+    return 0;
+  }
+  if (argc >= 2 && strcmp(argv[1], "discard") == 0) {
+    telemetry_log_discard();
+    printf("Telemetry backlog discarded\n");
+    return 0;
+  }
+  if (argc >= 2) {
+    printf("Usage: telemetry [flush|discard]\n");
+    return -1;
+  }
+
+  telemetry_log_stats_t stats;
+  telemetry_log_get_stats(&stats);
+  if (!stats.mounted) {
+    printf("Telemetry log not mounted\n");
+    return -1;
+  }
+  printf("🗃️ Telemetry log: %s, %" PRIu32 " sectors (%" PRIu32 " readings)\n",
+         stats.online ? "online, replaying" : "offline, logging", stats.sectors,
+         stats.capacity);
+  printf("  Backlog: %" PRIu32 " readings\n", stats.backlog);
+  printf("  Since boot: %" PRIu32 " logged, %" PRIu32 " replayed, %" PRIu32
+         " overwritten\n",
+         stats.appended, stats.replayed, stats.overwritten);
+  printf("  Flash: %" PRIu32 " batch writes, %" PRIu32 " sector erases\n",
+         stats.flash_writes, stats.sector_erases);
+  return 0;
+}
 #endif
 
 static int sei_clear_cli(int argc, char **argv) {
@@ -376,6 +802,11 @@ static int init_console() {
           .help = "Send SEI text message: sei_text <message>\r\n",
           .func = sei_text_cli,
       },
+      {
+          .command = "sei_cue",
+          .help = "Send SEI text timed to a frame ahead: sei_cue <delay_ms> <message>\r\n",
+          .func = sei_cue_cli,
+      },
       {
           .command = "sei_json",
           .help = "Send SEI JSON message: sei_json <role> <content>\r\n",
@@ -396,6 +827,46 @@ static int init_console() {
           .help = "Test SEI hook with fake frame\r\n",
           .func = sei_test_hook_cli,
       },
+      {
+          .command = "sei_metrics",
+          .help = "Show SEI latency histograms and counters: sei_metrics [reset]\r\n",
+          .func = sei_metrics_cli,
+      },
+      {
+          .command = "sei_bench",
+          .help = "Benchmark the SEI path: sei_bench [frames] [payload_bytes] [repeat]\r\n",
+          .func = sei_bench_cli,
+      },
+      {
+          .command = "video_profile",
+          .help = "Show or pin the video profile: video_profile [auto|<index>]\r\n",
+          .func = video_profile_cli,
+      },
+      {
+          .command = "webrtc_stats",
+          .help = "Show recent WebRTC stream stats, newest first: webrtc_stats [count]\r\n",
+          .func = webrtc_stats_cli,
+      },
+      {
+          .command = "latency",
+          .help = "Show per-frame capture/encode/send latency or set probing: latency [count|off|every <ms>]\r\n",
+          .func = latency_cli,
+      },
+      {
+          .command = "sensors",
+          .help = "Show registered sensors and their sample counters\r\n",
+          .func = sensors_cli,
+      },
+      {
+          .command = "threads",
+          .help = "Show media thread stacks (high-water mark) and the placement table\r\n",
+          .func = threads_cli,
+      },
+      {
+          .command = "thread_cfg",
+          .help = "Store a thread placement override: thread_cfg <name> <stack|-> <prio|-> <core|-> [ext|int] | thread_cfg <name> clear\r\n",
+          .func = thread_cfg_cli,
+      },
       {
           .command = "sei_raw_json",
           .help = "Send raw JSON message via SEI: sei_raw_json <json>\r\n",
@@ -412,6 +883,12 @@ static int init_console() {
           .help = "Show DHT-11 sensor status\r\n",
           .func = dht11_status_cli,
       },
+      {
+          .command = "telemetry",
+          .help = "Show the offline telemetry log, or flush/discard it: "
+                  "telemetry [flush|discard]\r\n",
+          .func = telemetry_cli,
+      },
 #endif
   };
   for (int i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
@@ -421,52 +898,40 @@ static int init_console() {
   return 0;
 }
 
-static void thread_scheduler(const char *thread_name,
-                             media_lib_thread_cfg_t *schedule_cfg) {
-  ESP_LOGI(TAG, "Thread name: %s", thread_name);
-  if (strcmp(thread_name, "venc_0") == 0) {
-    // For H264 may need huge stack if use hardware encoder can set it to small
-    // value
-    schedule_cfg->priority = 10;
-#if CONFIG_IDF_TARGET_ESP32S3
-    schedule_cfg->stack_size = 20 * 1024;
-#endif
-  }
-#ifdef WEBRTC_SUPPORT_OPUS
-  else if (strcmp(thread_name, "aenc_0") == 0) {
-    ESP_LOGI(TAG,
-             "🎵 Configuring aenc_0 with OPUS support - setting 128KB stack");
-    // For OPUS encoder it need huge stack, especially on ESP32-P4
-    schedule_cfg->stack_size = 128 * 1024; // Increased from 40KB to 128KB
-    schedule_cfg->priority = 10;
-    schedule_cfg->core_id = 1;
-  }
-#else
-  else if (strcmp(thread_name, "aenc_0") == 0) {
-    ESP_LOGW(TAG, "⚠️  OPUS support NOT enabled - using default aenc_0 config");
-  }
-#endif
-  else if (strcmp(thread_name, "AUD_SRC") == 0) {
-    schedule_cfg->priority = 15;
-  } else if (strcmp(thread_name, "pc_task") == 0) {
-    schedule_cfg->stack_size = 25 * 1024;
-    schedule_cfg->priority = 18;
-    schedule_cfg->core_id = 1;
-  } else if (strcmp(thread_name, "start") == 0) {
-    schedule_cfg->stack_size = 6 * 1024;
-  } else {
-    // Catch any audio-related threads and give them large stacks
-    if (strstr(thread_name, "aenc") || strstr(thread_name, "audio") ||
-        strstr(thread_name, "opus")) {
-      ESP_LOGI(TAG, "🎵 Found audio thread '%s' - setting 128KB stack",
-               thread_name);
-      schedule_cfg->stack_size = 128 * 1024;
-      schedule_cfg->priority = 10;
-      schedule_cfg->core_id = 1;
-    } else {
-      ESP_LOGW(TAG, "⚠️  Unhandled thread: '%s'", thread_name);
+// Apply the placement table (see thread_placement.c). stack_in_ext is NULL
+// for media_lib threads, which can't choose where their stack goes
+static void place_thread(const char *thread_name,
+                         media_lib_thread_cfg_t *schedule_cfg,
+                         bool *stack_in_ext) {
+  thread_placement_t placement;
+  if (thread_placement_lookup(thread_name, &placement)) {
+    if (placement.stack_size != THREAD_PLACEMENT_KEEP) {
+      schedule_cfg->stack_size = placement.stack_size;
+    }
+    if (placement.priority != THREAD_PLACEMENT_KEEP) {
+      schedule_cfg->priority = placement.priority;
+    }
+    if (placement.core_id != THREAD_PLACEMENT_KEEP) {
+      schedule_cfg->core_id = placement.core_id;
     }
+    if (stack_in_ext && placement.stack_in_ext != THREAD_PLACEMENT_KEEP) {
+      *stack_in_ext = placement.stack_in_ext;
+    }
+  } else {
+    ESP_LOGW(TAG, "⚠️  Unhandled thread: '%s'", thread_name);
   }
+  ESP_LOGI(TAG, "🧵 Thread %s: %d bytes, priority %d, core %d%s", thread_name,
+           (int)schedule_cfg->stack_size, (int)schedule_cfg->priority,
+           (int)schedule_cfg->core_id,
+           stack_in_ext && *stack_in_ext ? ", PSRAM stack" : "");
+  thread_placement_record(thread_name, schedule_cfg->stack_size,
+                          schedule_cfg->priority, schedule_cfg->core_id,
+                          stack_in_ext && *stack_in_ext);
+}
+
+static void thread_scheduler(const char *thread_name,
+                             media_lib_thread_cfg_t *schedule_cfg) {
+  place_thread(thread_name, schedule_cfg, NULL);
 }
 
 static void capture_scheduler(const char *name,
@@ -476,119 +941,37 @@ static void capture_scheduler(const char *name,
       .priority = schedule_cfg->priority,
       .core_id = schedule_cfg->core_id,
   };
-  schedule_cfg->stack_in_ext = true;
-  thread_scheduler(name, &cfg);
+  bool stack_in_ext = true;
+  place_thread(name, &cfg, &stack_in_ext);
+  schedule_cfg->stack_in_ext = stack_in_ext;
   schedule_cfg->stack_size = cfg.stack_size;
   schedule_cfg->priority = cfg.priority;
   schedule_cfg->core_id = cfg.core_id;
 }
 
-// HTTP event handler for token API response
-static esp_err_t token_http_event_handler(esp_http_client_event_t *evt) {
-  static char *response_buffer = NULL;
-  static int response_len = 0;
-
-  switch (evt->event_id) {
-  case HTTP_EVENT_ON_DATA:
-    // Allocate buffer for response data
-    if (response_buffer == NULL) {
-      response_buffer = malloc(2048); // Allocate 2KB for JSON response
-      response_len = 0;
-    }
-    if (response_buffer && response_len + evt->data_len < 2048) {
-      memcpy(response_buffer + response_len, evt->data, evt->data_len);
-      response_len += evt->data_len;
-      response_buffer[response_len] = '\0';
-    }
-    break;
-
-  case HTTP_EVENT_ON_FINISH:
-    if (response_buffer) {
-      ESP_LOGI(TAG, "🔑 Token API Response: %s", response_buffer);
-
-      // Parse JSON to extract token
-      cJSON *json = cJSON_Parse(response_buffer);
-      if (json) {
-        cJSON *token_item = cJSON_GetObjectItem(json, "token");
-        if (token_item && cJSON_IsString(token_item)) {
-          // Free old token and store new one
-          if (current_token) {
-            free(current_token);
-          }
-          current_token = strdup(token_item->valuestring);
-          ESP_LOGI(TAG, "✅ Token extracted successfully (length: %d)",
-                   strlen(current_token));
-        } else {
-          ESP_LOGE(TAG, "❌ Failed to extract token from JSON response");
-        }
-        cJSON_Delete(json);
-      } else {
-        ESP_LOGE(TAG, "❌ Failed to parse JSON response");
-      }
-
-      free(response_buffer);
-      response_buffer = NULL;
-      response_len = 0;
-    }
-    break;
-
-  default:
-    break;
-  }
-  return ESP_OK;
-}
-
-// Fetch fresh token from API
-static bool fetch_token(void) {
-  ESP_LOGI(TAG, "🔄 Fetching fresh token from API...");
-
-  esp_http_client_config_t config = {
-      .url = TOKEN_API_URL,
-      .event_handler = token_http_event_handler,
-      .timeout_ms = 10000, // 10 second timeout
-      .crt_bundle_attach =
-          esp_crt_bundle_attach, // Use certificate bundle for HTTPS
-      .skip_cert_common_name_check = false,
-  };
-
-  esp_http_client_handle_t client = esp_http_client_init(&config);
-  if (!client) {
-    ESP_LOGE(TAG, "❌ Failed to initialize HTTP client");
+// Take the prefetched participant token, the cache starts fetching the next one
+static bool take_token(void) {
+  if (!token_cache_get(current_token, sizeof(current_token), TOKEN_WAIT_MS)) {
     return false;
   }
+  token_cache_consume();
+  return true;
+}
 
-  // Set POST method and headers
-  esp_http_client_set_method(client, HTTP_METHOD_POST);
-  esp_http_client_set_header(client, "Content-Type", "application/json");
-  esp_http_client_set_post_field(client, TOKEN_REQUEST_BODY,
-                                 strlen(TOKEN_REQUEST_BODY));
-
-  // Perform the request
-  esp_err_t err = esp_http_client_perform(client);
-  int status_code = esp_http_client_get_status_code(client);
-
-  esp_http_client_cleanup(client);
-
-  if (err == ESP_OK && status_code == 200) {
-    ESP_LOGI(TAG, "✅ Token fetch successful (HTTP %d)", status_code);
-    return (current_token != NULL);
-  } else {
-    ESP_LOGE(TAG, "❌ Token fetch failed: %s (HTTP %d)", esp_err_to_name(err),
-             status_code);
-    return false;
-  }
+static void IRAM_ATTR button_isr_handler(void *arg) {
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(button_task_handle, &woken);
+  portYIELD_FROM_ISR(woken);
 }
 
-// Button task for manual publish control
+// Button task for manual publish control, sleeps until the button interrupt
 static void button_task(void *arg) {
-  bool current_state;
-
   while (1) {
-    current_state = gpio_get_level(BUTTON_GPIO);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-    // Detect button press (transition from released to pressed)
-    if (last_button_state != current_state &&
-        current_state == BUTTON_ACTIVE_LEVEL) {
+    // Debounce: the press must still be there once the contacts settle
+    vTaskDelay(pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS));
+    if (gpio_get_level(BUTTON_GPIO) == BUTTON_ACTIVE_LEVEL) {
       // Button just pressed - toggle publishing state
       if (publishing_active) {
         ESP_LOGI(TAG, "🔴 Button pressed - Stopping WHIP stream");
@@ -601,10 +984,13 @@ static void button_task(void *arg) {
         ESP_LOGI(TAG, "🟢 Button pressed - Starting WHIP stream");
         // Use async task to avoid stack overflow
         RUN_ASYNC(start, {
-          // Fetch fresh token before starting
-          if (fetch_token() && current_token) {
+          // Token was prefetched when the network came up
+          if (!wait_media_ready()) {
+            ESP_LOGE(TAG, "❌ Camera not ready, cannot start stream");
+          } else if (take_token()) {
             ESP_LOGI(TAG, "🚀 Starting WHIP stream with fresh token");
-            if (start_webrtc(WHIP_SERVER, current_token) == 0) {
+            if (start_webrtc_with_cached_token(WHIP_SERVER, current_token) ==
+                0) {
               publishing_active = true;
             } else {
               ESP_LOGE(TAG, "Failed to start WHIP stream");
@@ -615,105 +1001,115 @@ static void button_task(void *arg) {
         });
       }
 
-      // Debounce delay
-      vTaskDelay(pdMS_TO_TICKS(300));
+      // Ignore bounces and repeats until the hold-off has passed
+      vTaskDelay(pdMS_TO_TICKS(BUTTON_HOLDOFF_MS));
     }
-
-    last_button_state = current_state;
-    vTaskDelay(pdMS_TO_TICKS(50)); // Check every 50ms
+    ulTaskNotifyTake(pdTRUE, 0);
   }
 }
 
 #if SEI_ENABLE_DHT11
-// DHT-11 sensor functions
-static bool dht11_init(void) {
-  // The esp-idf-lib DHT library handles GPIO configuration internally
+// DHT-11 sensor functions, run on the sensor sampling task
+static bool dht11_init(void *ctx) {
+  if (!dht_rmt_init(DHT11_GPIO)) {
+    return false;
+  }
   dht11_initialized = true;
-  ESP_LOGI(TAG, "🌡️  DHT-11 sensor initialized on GPIO%d using esp-idf-lib", DHT11_GPIO);
-  
+  ESP_LOGI(TAG, "🌡️  DHT-11 sensor initialized on GPIO%d", DHT11_GPIO);
+
   // Wait a bit for sensor to stabilize
-  vTaskDelay(pdMS_TO_TICKS(2000));
-  
-  // Test initial read
-  float test_temp, test_hum;
-  if (dht11_read(&test_temp, &test_hum)) {
-    ESP_LOGI(TAG, "✅ DHT-11 initial test successful: %.1f°C, %.1f%%", test_temp, test_hum);
-  } else {
-    ESP_LOGW(TAG, "⚠️ DHT-11 initial test failed - sensor may need more time to stabilize");
-  }
-  
+  vTaskDelay(pdMS_TO_TICKS(DHT_RMT_MIN_INTERVAL_MS));
   return true;
 }
 
-static bool dht11_read(float *temperature, float *humidity) {
+static bool dht11_read(int16_t *temp_deci, uint16_t *hum_deci) {
   if (!dht11_initialized) {
     ESP_LOGW(TAG, "DHT-11 not initialized");
     return false;
   }
 
-  int16_t temp_raw, hum_raw;
-  esp_err_t result = dht_read_data(DHT_TYPE_DHT11, DHT11_GPIO, &hum_raw, &temp_raw);
-  
-  if (result == ESP_OK) {
-    *temperature = (float)temp_raw / 10.0;
-    *humidity = (float)hum_raw / 10.0;
-    
-    // Sanity check values
-    if (*humidity < 0 || *humidity > 100 || *temperature < -40 || *temperature > 80) {
-      ESP_LOGW(TAG, "DHT-11 values out of range: T=%.1f°C, H=%.1f%%", *temperature, *humidity);
-      return false;
-    }
-    
-    ESP_LOGD(TAG, "DHT-11 read successful: T=%.1f°C, H=%.1f%%", *temperature, *humidity);
-    return true;
-  } else {
-    ESP_LOGW(TAG, "DHT-11 read failed: %s", esp_err_to_name(result));
+  if (!dht_rmt_read(temp_deci, hum_deci)) {
+    ESP_LOGW(TAG, "DHT-11 read failed");
+    return false;
+  }
+
+  // Sanity check values
+  if (*hum_deci > 1000 || *temp_deci < -400 || *temp_deci > 800) {
+    ESP_LOGW(TAG, "DHT-11 values out of range: T=" DECI_FMT "°C, H=" DECI_FMT "%%",
+             DECI_ARGS(*temp_deci), DECI_ARGS(*hum_deci));
     return false;
   }
+
+  ESP_LOGD(TAG, "DHT-11 read successful: T=" DECI_FMT "°C, H=" DECI_FMT "%%",
+           DECI_ARGS(*temp_deci), DECI_ARGS(*hum_deci));
+  return true;
 }
 
-static void dht11_task(void *arg) {
-  ESP_LOGI(TAG, "🌡️  DHT-11 task started - reading sensor every %d seconds", DHT11_READ_INTERVAL_MS / 1000);
-  
-  while (1) {
-    if (dht11_initialized && publishing_active && sei_system_active) {
-      float temperature, humidity;
-      
-      if (dht11_read(&temperature, &humidity)) {
-        last_temperature = temperature;
-        last_humidity = humidity;
-        
-        ESP_LOGI(TAG, "🌡️  DHT-11: Temperature: %.1f°C, Humidity: %.1f%%", temperature, humidity);
-        
-        // Create complete JSON message for SEI
-        char json_message[300];
-        uint32_t timestamp = esp_timer_get_time() / 1000; // Convert to milliseconds
-        
-        snprintf(json_message, sizeof(json_message),
-                "{\"sensor\":\"DHT11\",\"temperature_c\":%.1f,\"humidity_percent\":%.1f,\"timestamp\":%" PRIu32 ",\"status\":\"ok\",\"type\":\"sensor_data\"}",
-                temperature, humidity, timestamp);
-        
-        if (sei_send_raw_json(json_message)) {
-          ESP_LOGI(TAG, "📤 DHT-11 data published via SEI as raw JSON");
-        } else {
-          ESP_LOGW(TAG, "⚠️ Failed to publish DHT-11 data via SEI");
-        }
-      } else {
-        ESP_LOGW(TAG, "⚠️ Failed to read DHT-11 sensor");
-        
-        // Send error status via SEI
-        char error_message[150];
-        uint32_t timestamp = esp_timer_get_time() / 1000; // Convert to milliseconds
-        snprintf(error_message, sizeof(error_message),
-                "{\"sensor\":\"DHT11\",\"timestamp\":%" PRIu32 ",\"status\":\"read_error\",\"type\":\"sensor_error\"}", timestamp);
-        sei_send_raw_json(error_message);
-      }
+static bool dht11_sample(void *ctx) {
+  int16_t temp_deci = 0;
+  uint16_t hum_deci = 0;
+  bool ok = dht11_read(&temp_deci, &hum_deci);
+  if (ok) {
+    last_temp_deci = temp_deci;
+    last_hum_deci = hum_deci;
+  } else {
+    temp_deci = 0;
+    hum_deci = 0;
+  }
+  if (!sei_system_active) {
+    return ok;
+  }
+
+  if (!telemetry_log_is_online()) {
+    // Stream stopped or reconnecting: keep the reading for replay once it is back
+    telemetry_record_t record = {
+        .kind = TELEMETRY_KIND_DHT11,
+        .status = ok ? 0 : 1,
+        .value = {temp_deci, hum_deci},
+    };
+    if (!telemetry_log_append(&record)) {
+      ESP_LOGD(TAG, "DHT-11 reading not logged");
     }
-    
-    // Wait for next reading interval
-    vTaskDelay(pdMS_TO_TICKS(DHT11_READ_INTERVAL_MS));
+    return ok;
+  }
+  if (!publishing_active) {
+    return ok;
+  }
+
+  if (ok) {
+    ESP_LOGI(TAG, "🌡️  DHT-11: Temperature: " DECI_FMT "°C, Humidity: " DECI_FMT "%%",
+             DECI_ARGS(temp_deci), DECI_ARGS(hum_deci));
+
+    // Latest reading is pinned to keyframes so late joiners see it immediately
+    if (sei_send_sensor_reading(temp_deci, hum_deci, true)) {
+      ESP_LOGI(TAG, "📤 DHT-11 data published via SEI");
+    } else {
+      ESP_LOGW(TAG, "⚠️ Failed to publish DHT-11 data via SEI");
+    }
+  } else {
+    ESP_LOGW(TAG, "⚠️ Failed to read DHT-11 sensor");
+
+    // Send error status via SEI
+    sei_send_sensor_reading(0, 0, false);
+  }
+  return ok;
+}
+
+// Publishes logged readings on the telemetry log task, a few at a time so
+// live messages keep the frame budget
+static bool replay_telemetry(const telemetry_record_t *record, void *ctx) {
+  if (sei_get_queue_status() >= TELEMETRY_REPLAY_MAX_QUEUED) {
+    return false;
   }
+  return sei_send_logged_reading(record);
 }
+
+static const sensor_driver_t dht11_driver = {
+    .name = "dht11",
+    .interval_ms = DHT11_READ_INTERVAL_MS,
+    .init = dht11_init,
+    .sample = dht11_sample,
+};
 #endif
 
 // SEI message task - sends test messages every 3 seconds (if enabled)
@@ -730,13 +1126,15 @@ static void sei_message_task(void *arg) {
       // Send different types of test messages
       switch (message_counter % 3) {
       case 0:
-        if (sei_send_text("Periodic test message from ESP32-P4")) {
+        if (sei_send_text_priority("Periodic test message from ESP32-P4",
+                                   SEI_PRIORITY_BULK)) {
           ESP_LOGI(TAG, "📤 Sent SEI text message #%d", message_counter);
         }
         break;
 
       case 1:
-        if (sei_send_json("system", "ESP32-P4 streaming active")) {
+        if (sei_send_json_priority("system", "ESP32-P4 streaming active",
+                                   SEI_PRIORITY_BULK)) {
           ESP_LOGI(TAG, "📤 Sent SEI JSON message #%d", message_counter);
         }
         break;
@@ -765,12 +1163,15 @@ static int network_event_handler(bool connected) {
                   "streaming");
     // Don't auto-start anymore - wait for button press
     // RUN_ASYNC(start, { start_webrtc(WHIP_SERVER, WHIP_TOKEN); });
+    // Fetch the token now so a button press goes straight to signaling
+    token_cache_set_network_connected(true);
+    set_webrtc_network_state(true);
   } else {
-    ESP_LOGI(TAG, "📶 Network disconnected - Stopping WHIP stream");
-    if (publishing_active) {
-      stop_webrtc();
-      publishing_active = false;
-    }
+    token_cache_set_network_connected(false);
+    // A running stream is kept and reconnects once the network is back
+    ESP_LOGI(TAG, "📶 Network disconnected%s",
+             publishing_active ? " - WHIP stream will reconnect" : "");
+    set_webrtc_network_state(false);
   }
   return 0;
 }
@@ -787,11 +1188,17 @@ void app_main(void) {
   ESP_LOGW(TAG, "⚠️  WEBRTC_SUPPORT_OPUS is NOT defined");
 #endif
 
+  // Before any media thread is created
+  thread_placement_init();
+  video_profile_init();
+
   media_lib_add_default_adapter();
   esp_capture_set_thread_scheduler(capture_scheduler);
   media_lib_thread_set_schedule_cb(thread_scheduler);
   init_board();
-  media_sys_buildup();
+  // Camera and encoder bring-up overlaps with Wi-Fi, decoders and the player
+  // are built on first use
+  start_media_init();
   init_console();
 
   // Configure button GPIO
@@ -800,7 +1207,7 @@ void app_main(void) {
       .mode = GPIO_MODE_INPUT,
       .pull_up_en = GPIO_PULLUP_ENABLE, // Enable pull-up for BOOT button
       .pull_down_en = GPIO_PULLDOWN_DISABLE,
-      .intr_type = GPIO_INTR_DISABLE};
+      .intr_type = GPIO_INTR_NEGEDGE}; // Press pulls the line low
   gpio_config(&button_config);
 
   ESP_LOGI(TAG,
@@ -825,19 +1232,14 @@ void app_main(void) {
     sei_system_active = false;
   }
 
-#if SEI_ENABLE_DHT11
-  // Initialize DHT-11 sensor
-  if (dht11_init()) {
-    ESP_LOGI(TAG, "🌡️  DHT-11 sensor ready - readings will be published via SEI every %d seconds", DHT11_READ_INTERVAL_MS / 1000);
+  // Create button task, woken by the button interrupt
+  xTaskCreate(button_task, "button_task", 2048, NULL, 5, &button_task_handle);
+  esp_err_t isr_err = gpio_install_isr_service(0);
+  if (isr_err == ESP_OK || isr_err == ESP_ERR_INVALID_STATE) { // Shared service may exist
+    gpio_isr_handler_add(BUTTON_GPIO, button_isr_handler, NULL);
   } else {
-    ESP_LOGE(TAG, "❌ DHT-11 sensor initialization failed");
+    ESP_LOGE(TAG, "❌ Failed to install GPIO ISR service: %s", esp_err_to_name(isr_err));
   }
-#else
-  ESP_LOGI(TAG, "🌡️  DHT-11 sensor support disabled in settings");
-#endif
-
-  // Create button monitoring task with larger stack
-  xTaskCreate(button_task, "button_task", 2048, NULL, 5, NULL);
 
   // Create SEI message publishing task with larger stack and lower priority
   if (sei_system_active) {
@@ -850,17 +1252,34 @@ void app_main(void) {
   }
 
 #if SEI_ENABLE_DHT11
-  // Create DHT-11 sensor task
-  if (dht11_initialized && sei_system_active) {
-    xTaskCreate(dht11_task, "dht11_task", 4096, NULL, 4, NULL);
-    ESP_LOGI(TAG, "🌡️  DHT-11 sensor task created successfully");
+  // Readings taken while the stream is down go to flash and are replayed later
+  if (sei_system_active && !telemetry_log_init(replay_telemetry, NULL)) {
+    ESP_LOGW(TAG, "⚠️ Telemetry log unavailable, offline readings are dropped");
+  }
+  // DHT-11 is sampled on the sensor task, off the core running pc_task
+  if (sei_system_active && sensor_sampler_register(&dht11_driver) >= 0) {
+    ESP_LOGI(TAG, "🌡️  DHT-11 readings will be published via SEI every %d seconds",
+             DHT11_READ_INTERVAL_MS / 1000);
   }
+#else
+  ESP_LOGI(TAG, "🌡️  DHT-11 sensor support disabled in settings");
 #endif
+  if (sensor_sampler_count() > 0 && !sensor_sampler_start()) {
+    ESP_LOGE(TAG, "❌ Failed to start sensor sampling");
+  }
+
+  // Token fetching starts once the network is up
+  if (!token_cache_init()) {
+    ESP_LOGE(TAG, "❌ Failed to start token cache, streams will use WHIP_TOKEN");
+  }
 
   // Re-enable WiFi to test without SEI code
   network_init(WIFI_SSID, WIFI_PASSWORD, network_event_handler);
+  // The one SNTP client, for TLS and the latency probes' wall-clock capture times
+  latency_probe_init();
   while (1) {
     media_lib_thread_sleep(2000);
     query_webrtc();
+    update_webrtc_stats();
   }
 }
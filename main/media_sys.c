@@ -15,6 +15,7 @@
 #include "av_render.h"
 #include "av_render_default.h"
 #include "common.h"
+#include "latency_probe.h"
 #include "esp_log.h"
 #include "settings.h"
 #include "media_lib_os.h"
@@ -25,9 +26,33 @@
 #include "esp_audio_dec_default.h"
 #include "esp_capture_defaults.h"
 #include "esp_capture_sink.h"
+#include <stdatomic.h>
 
 #define TAG "MEDIA_SYS"
 
+// Upper bound for SPS + PPS ahead of an IDR slice from the H.264 encoder
+#define VIDEO_ENC_PARAM_SET_WINDOW 256
+
+// Camera frame buffers: a third one lets the P4 camera keep filling while
+// one frame is encoded and another waits behind a slow send
+#ifndef VIDEO_CAPTURE_BUF_COUNT
+#if CONFIG_IDF_TARGET_ESP32P4
+#define VIDEO_CAPTURE_BUF_COUNT 3
+#else
+#define VIDEO_CAPTURE_BUF_COUNT 2
+#endif
+#endif
+
+#if VIDEO_CAPTURE_BUF_COUNT < 2 || VIDEO_CAPTURE_BUF_COUNT > 6
+#error "VIDEO_CAPTURE_BUF_COUNT must be between 2 and 6"
+#endif
+
+// The WHIP session is send-only, so the player (and its I2S and LCD renders)
+// is only built when something plays locally
+#ifndef MEDIA_PLAYER_AT_BOOT
+#define MEDIA_PLAYER_AT_BOOT false
+#endif
+
 #define RET_ON_NULL(ptr, v) do {                                \
     if (ptr == NULL) {                                          \
         ESP_LOGE(TAG, "Memory allocate fail on %d", __LINE__);  \
@@ -98,17 +123,20 @@ static esp_capture_video_src_if_t *create_video_source(void)
         ESP_LOGE(TAG, "Camera init failed with error 0x%x", ret);
         return NULL;
     }
+    // The source hands the mmap'ed V4L2 buffers to the encoder as they are,
+    // so the buffer count also sets how many frames can be in flight
     esp_capture_video_v4l2_src_cfg_t v4l2_cfg = {
         .dev_name = "/dev/video0",
-        .buf_count = 2,
+        .buf_count = VIDEO_CAPTURE_BUF_COUNT,
     };
+    ESP_LOGI(TAG, "Camera uses %d V4L2 buffers", VIDEO_CAPTURE_BUF_COUNT);
     return esp_capture_new_video_v4l2_src(&v4l2_cfg);
 #endif
 
 #if CONFIG_IDF_TARGET_ESP32S3
     if (cam_pin_cfg.type == CAMERA_TYPE_DVP) {
         esp_capture_video_dvp_src_cfg_t dvp_config = { 0 };
-        dvp_config.buf_count = 2;
+        dvp_config.buf_count = VIDEO_CAPTURE_BUF_COUNT;
         dvp_config.reset_pin = cam_pin_cfg.reset;
         dvp_config.pwr_pin = cam_pin_cfg.pwr;
         dvp_config.data[0] = cam_pin_cfg.data[0];
@@ -130,10 +158,71 @@ static esp_capture_video_src_if_t *create_video_source(void)
     return NULL;
 }
 
+// Frame callbacks of the camera source, wrapped to timestamp frames for the
+// latency probe and to thin them out to the video profile's frame rate
+static esp_capture_err_t (*source_acquire_frame)(esp_capture_video_src_if_t *src, esp_capture_stream_frame_t *frame);
+static esp_capture_err_t (*source_release_frame)(esp_capture_video_src_if_t *src, esp_capture_stream_frame_t *frame);
+
+// Time between frames handed to the encoder, 0 keeps every camera frame
+static _Atomic uint32_t video_frame_interval_ms;
+static uint32_t         video_next_pts;
+
+static bool keep_video_frame(uint32_t pts)
+{
+    uint32_t interval = atomic_load_explicit(&video_frame_interval_ms, memory_order_relaxed);
+    if (interval == 0) {
+        return true;
+    }
+    // Positive while the frame is ahead of its slot. A quarter interval of
+    // slack absorbs camera jitter
+    int32_t early = (int32_t)(video_next_pts - pts);
+    if (early > (int32_t)(interval / 4) && early <= (int32_t)interval) {
+        return false;
+    }
+    // Keep the schedule while on it, restart it after a gap or when the
+    // capture clock starts over with a new session
+    bool on_schedule = early >= -(int32_t)interval && early <= (int32_t)interval;
+    video_next_pts = (on_schedule ? video_next_pts : pts) + interval;
+    return true;
+}
+
+static esp_capture_err_t stamped_acquire_frame(esp_capture_video_src_if_t *src, esp_capture_stream_frame_t *frame)
+{
+    for (;;) {
+        esp_capture_err_t ret = source_acquire_frame(src, frame);
+        if (ret != ESP_CAPTURE_ERR_OK) {
+            return ret;
+        }
+        if (keep_video_frame(frame->pts)) {
+            latency_probe_mark(LATENCY_STAGE_CAPTURE, frame->pts);
+            return ret;
+        }
+        // Dropped before encoding, so the encoder only sees the profile rate
+        source_release_frame(src, frame);
+    }
+}
+
+static esp_capture_err_t stamped_release_frame(esp_capture_video_src_if_t *src, esp_capture_stream_frame_t *frame)
+{
+    // The encoder hands the camera buffer back once it has consumed it
+    latency_probe_mark(LATENCY_STAGE_ENCODED, frame->pts);
+    return source_release_frame(src, frame);
+}
+
+static void stamp_video_source(esp_capture_video_src_if_t *src)
+{
+    // The callbacks live in the source object itself, so they are swapped in place
+    source_acquire_frame = src->acquire_frame;
+    source_release_frame = src->release_frame;
+    src->acquire_frame = stamped_acquire_frame;
+    src->release_frame = stamped_release_frame;
+}
+
 static int build_capture_system(void)
 {
     capture_sys.vid_src = create_video_source();
     RET_ON_NULL(capture_sys.vid_src, -1);
+    stamp_video_source(capture_sys.vid_src);
 
     esp_capture_audio_dev_src_cfg_t codec_cfg = {
         .record_handle = get_record_handle(),
@@ -150,13 +239,27 @@ static int build_capture_system(void)
     return 0;
 }
 
-static int build_player_system()
+static int build_player_system(void)
 {
+    if (player_sys.player) {
+        return 0;
+    }
+    ESP_LOGI(TAG, "Building player for local playback");
+    // Decoders only serve the player, so they are registered with it
+    static bool decoders_registered = false;
+    if (!decoders_registered) {
+        esp_video_dec_register_default();
+        esp_audio_dec_register_default();
+        decoders_registered = true;
+    }
     i2s_render_cfg_t i2s_cfg = {
         .fixed_clock = true,
         .play_handle = get_playback_handle(),
     };
-    player_sys.audio_render = av_render_alloc_i2s_render(&i2s_cfg);
+    // Renders survive a failed attempt, so a retry doesn't allocate them twice
+    if (player_sys.audio_render == NULL) {
+        player_sys.audio_render = av_render_alloc_i2s_render(&i2s_cfg);
+    }
     if (player_sys.audio_render == NULL) {
         ESP_LOGE(TAG, "Fail to create audio render");
         return -1;
@@ -164,7 +267,9 @@ static int build_player_system()
     lcd_render_cfg_t lcd_cfg = {
         .lcd_handle = board_get_lcd_handle(),
     };
-    player_sys.video_render = av_render_alloc_lcd_render(&lcd_cfg);
+    if (player_sys.video_render == NULL) {
+        player_sys.video_render = av_render_alloc_lcd_render(&lcd_cfg);
+    }
     if (player_sys.video_render == NULL) {
         ESP_LOGE(TAG, "Fail to create video render");
         return -1;
@@ -188,27 +293,64 @@ static int build_player_system()
 
 int media_sys_buildup(void)
 {
-    // Register for default audio and video codecs
+    // Register for default audio and video encoders, decoders come with the player
     esp_video_enc_register_default();
     esp_audio_enc_register_default();
-    esp_video_dec_register_default();
-    esp_audio_dec_register_default();
     // Build capture system
     build_capture_system();
-    // Build player system
-    build_player_system();
+    // Build player system, otherwise left to the first local playback
+    if (MEDIA_PLAYER_AT_BOOT) {
+        build_player_system();
+    }
     return 0;
 }
 
+void media_sys_set_video_fps(int fps)
+{
+    uint32_t interval = fps > 0 && fps < VIDEO_FPS ? 1000 / fps : 0;
+    atomic_store(&video_frame_interval_ms, interval);
+    ESP_LOGI(TAG, "Camera frames to the encoder: %d fps", interval ? fps : VIDEO_FPS);
+}
+
+int media_sys_describe_video_frame(const uint8_t *data, size_t size, nal_index_t *index)
+{
+    if (size < 5 || data[0] != 0x00 || data[1] != 0x00 || data[2] != 0x00 || data[3] != 0x01) {
+        return -1;
+    }
+    uint8_t nal_type = data[4] & 0x1F;
+    if (nal_type == NAL_TYPE_SLICE || nal_type == NAL_TYPE_IDR) {
+        // P-frame (or bare IDR): the only NAL is the slice at offset 0
+        index->entries[0].offset = 0;
+        index->entries[0].start_code_len = 4;
+        index->entries[0].nal_type = nal_type;
+        index->count = 1;
+        index->first_slice = 0;
+        index->is_keyframe = (nal_type == NAL_TYPE_IDR);
+        index->complete = false;
+        return 0;
+    }
+    if (nal_type == NAL_TYPE_SPS) {
+        // Keyframe: only the parameter-set prefix needs to be indexed
+        size_t window = size < VIDEO_ENC_PARAM_SET_WINDOW ? size : VIDEO_ENC_PARAM_SET_WINDOW;
+        nal_index_build(data, window, true, index);
+        return index->first_slice >= 0 ? 0 : -1;
+    }
+    return -1;
+}
+
 int media_sys_get_provider(esp_webrtc_media_provider_t *provide)
 {
     provide->capture = capture_sys.capture_handle;
+    // NULL unless something played locally; the send-only session doesn't render
     provide->player = player_sys.player;
     return 0;
 }
 
 int test_capture_to_player(void)
 {
+    if (build_player_system() != 0) {
+        return -1;
+    }
     esp_capture_sink_cfg_t sink_cfg = {
         .audio_info = {
             .format_id = ESP_CAPTURE_FMT_ID_G711A,
@@ -330,6 +472,9 @@ int play_music(const uint8_t *data, int size, int duration)
         ESP_LOGE(TAG, "Music is playing, stop automatically");
         stop_music();
     }
+    if (build_player_system() != 0) {
+        return -1;
+    }
     music_playing = true;
     music_to_play = data;
     music_size = size;
@@ -0,0 +1,101 @@
+/* H.264 NAL Unit Indexer Implementation
+ * 
+ * Scans an Annex-B access unit once and records where each NAL unit starts,
+ * so every consumer of the frame can reuse the same table instead of
+ * walking the bitstream again.
+ */
+
+#include "nal_index.h"
+#include <string.h>
+
+/**
+ * @brief Test whether any byte of a 32-bit word is zero
+ */
+static inline bool word_has_zero_byte(uint32_t v) {
+    return ((v - 0x01010101u) & ~v & 0x80808080u) != 0;
+}
+
+/**
+ * @brief Check for a 3-byte start code at pos and record the NAL unit
+ * 
+ * @return true to stop scanning
+ */
+static bool check_start_code(const uint8_t *data, size_t size, size_t pos,
+                             bool stop_at_first_slice, nal_index_t *index) {
+    if (pos + 3 >= size || data[pos] != 0x00 || data[pos + 1] != 0x00 || data[pos + 2] != 0x01) {
+        return false;
+    }
+    
+    if (index->count >= NAL_INDEX_MAX_ENTRIES) {
+        // Table is full, the rest of the frame is not indexed
+        index->complete = false;
+        return true;
+    }
+    
+    nal_index_entry_t *entry = &index->entries[index->count];
+    bool long_start_code = pos > 0 && data[pos - 1] == 0x00;
+    entry->offset = long_start_code ? pos - 1 : pos;
+    entry->start_code_len = long_start_code ? 4 : 3;
+    entry->nal_type = data[pos + 3] & 0x1F;
+    
+    if (entry->nal_type == NAL_TYPE_IDR || entry->nal_type == NAL_TYPE_SPS || entry->nal_type == NAL_TYPE_PPS) {
+        index->is_keyframe = true;
+    }
+    
+    bool is_slice = entry->nal_type >= NAL_TYPE_SLICE && entry->nal_type <= NAL_TYPE_IDR;
+    if (is_slice && index->first_slice < 0) {
+        index->first_slice = index->count;
+    }
+    index->count++;
+    
+    if (is_slice && stop_at_first_slice) {
+        index->complete = false;
+        return true;
+    }
+    return false;
+}
+
+int nal_index_build(const uint8_t *data, size_t size, bool stop_at_first_slice, nal_index_t *index) {
+    index->count = 0;
+    index->first_slice = -1;
+    index->is_keyframe = false;
+    index->complete = true;
+    
+    if (!data || size < 4) {
+        return 0;
+    }
+    
+    size_t pos = 0;
+    
+    // Byte-wise until the scan pointer is word aligned
+    while (pos < size && ((uintptr_t)(data + pos) & 3) != 0) {
+        if (check_start_code(data, size, pos, stop_at_first_slice, index)) {
+            return index->count;
+        }
+        pos++;
+    }
+    
+    // A start code begins with a zero byte, so words without one are skipped
+    while (pos + 4 <= size) {
+        // memcpy instead of a cast keeps clear of strict aliasing; on the
+        // aligned pointer it compiles to a single load
+        uint32_t word;
+        memcpy(&word, data + pos, sizeof(word));
+        if (word_has_zero_byte(word)) {
+            for (size_t i = pos; i < pos + 4; i++) {
+                if (check_start_code(data, size, i, stop_at_first_slice, index)) {
+                    return index->count;
+                }
+            }
+        }
+        pos += 4;
+    }
+    
+    // Remaining tail bytes
+    for (; pos < size; pos++) {
+        if (check_start_code(data, size, pos, stop_at_first_slice, index)) {
+            return index->count;
+        }
+    }
+    return index->count;
+}
@@ -0,0 +1,75 @@
+/* H.264 NAL Unit Indexer
+ * 
+ * Scans an Annex-B access unit once and records where each NAL unit starts,
+ * so every consumer of the frame can reuse the same table instead of
+ * walking the bitstream again.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum number of NAL units recorded per frame
+#define NAL_INDEX_MAX_ENTRIES 32
+
+// H.264 NAL unit types used by the SEI path
+#define NAL_TYPE_SLICE      1
+#define NAL_TYPE_IDR        5
+#define NAL_TYPE_SEI        6
+#define NAL_TYPE_SPS        7
+#define NAL_TYPE_PPS        8
+#define NAL_TYPE_AUD        9
+
+/**
+ * @brief One NAL unit in a frame
+ */
+typedef struct {
+    uint32_t offset;            /*!< Offset of the start code in the frame */
+    uint8_t start_code_len;     /*!< Start code length (3 or 4 bytes) */
+    uint8_t nal_type;           /*!< nal_unit_type (low 5 bits of the header) */
+} nal_index_entry_t;
+
+/**
+ * @brief NAL unit table of one frame
+ */
+typedef struct {
+    nal_index_entry_t entries[NAL_INDEX_MAX_ENTRIES]; /*!< NAL units in bitstream order */
+    int count;                  /*!< Number of valid entries */
+    int first_slice;            /*!< Entry of the first slice NAL (types 1-5), or -1 */
+    bool is_keyframe;           /*!< Frame carries an IDR slice, SPS or PPS */
+    bool complete;              /*!< Whole frame was scanned and every NAL recorded */
+} nal_index_t;
+
+/**
+ * @brief Index the NAL units of an Annex-B frame
+ * 
+ * Uses a word-at-a-time zero-byte test so only words that contain a zero
+ * byte are examined byte by byte.
+ * 
+ * @param data Frame data
+ * @param size Frame size in bytes
+ * @param stop_at_first_slice Stop scanning once the first slice NAL is found
+ * @param index Table to fill
+ * @return Number of NAL units recorded
+ */
+int nal_index_build(const uint8_t *data, size_t size, bool stop_at_first_slice, nal_index_t *index);
+
+/**
+ * @brief Get the offset where SEI units should be inserted
+ * 
+ * @param index Indexed frame
+ * @return Start code offset of the first slice NAL, or -1 if there is none
+ */
+static inline int nal_index_insert_offset(const nal_index_t *index) {
+    return index->first_slice >= 0 ? (int)index->entries[index->first_slice].offset : -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+/* NVS Storage Implementation
+ */
+
+#include "nvs_storage.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+
+static const char *TAG = "NVS_STORAGE";
+
+bool nvs_storage_init(void) {
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "⚠️ NVS partition unusable (%s), erasing it", esp_err_to_name(err));
+        err = nvs_flash_erase();
+        if (err == ESP_OK) {
+            err = nvs_flash_init();
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Failed to initialize NVS: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+/* NVS Storage
+ *
+ * Shared bring-up of the default NVS partition for the modules that keep
+ * settings or state in it before Wi-Fi starts
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the default NVS partition
+ *
+ * Safe to call from every user and again from network_init. Like
+ * network_init, a partition that is full or was written by a newer NVS
+ * version is erased and initialized again, since it can't be used as is.
+ *
+ * @return true if NVS is ready
+ */
+bool nvs_storage_init(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,6 +4,9 @@
  */
 
 #include "sei.h"
+#include "sei_tlv.h"
+#include "video_sei_hook.h"
+#include "settings.h"
 #include <stdio.h>
 #include <string.h>
 #include "esp_log.h"
@@ -12,9 +15,28 @@
 #include "esp_system.h"
 #include <inttypes.h>
 
+#ifndef SEI_PAYLOAD_BINARY
+#define SEI_PAYLOAD_BINARY false
+#endif
+
 static const char *TAG = "SEI";
 static sei_publisher_handle_t g_sei_publisher = NULL;
 
+/**
+ * @brief Queue an encoded TLV payload
+ */
+static bool publish_tlv(const sei_tlv_writer_t *writer, const sei_publish_opts_t *opts) {
+    size_t payload_size = sei_tlv_finish(writer);
+    if (payload_size == 0) {
+        ESP_LOGW(TAG, "Binary SEI payload does not fit in %d bytes", SEI_MAX_PAYLOAD_SIZE);
+        return false;
+    }
+    
+    sei_publish_opts_t tlv_opts = *opts;
+    tlv_opts.format = SEI_PAYLOAD_TLV;
+    return sei_publisher_publish(g_sei_publisher, writer->buf, payload_size, &tlv_opts);
+}
+
 bool sei_init(void) {
     if (g_sei_publisher) {
         ESP_LOGW(TAG, "SEI system already initialized");
@@ -35,6 +57,12 @@ bool sei_init(void) {
         ESP_LOGE(TAG, "Failed to initialize SEI publisher");
         return false;
     }
+    // Other components can register publishers of their own next to this one
+    if (!video_sei_hook_register_publisher(g_sei_publisher, "default", VIDEO_SEI_HOOK_DEFAULT_PRIORITY)) {
+        sei_publisher_deinit(g_sei_publisher);
+        g_sei_publisher = NULL;
+        return false;
+    }
     
     ESP_LOGI(TAG, "✅ SEI system initialized");
     return true;
@@ -42,6 +70,7 @@ bool sei_init(void) {
 
 void sei_deinit(void) {
     if (g_sei_publisher) {
+        video_sei_hook_unregister_publisher(g_sei_publisher);
         sei_publisher_deinit(g_sei_publisher);
         g_sei_publisher = NULL;
         ESP_LOGI(TAG, "✅ SEI system deinitialized");
@@ -49,6 +78,10 @@ void sei_deinit(void) {
 }
 
 bool sei_send_text(const char *text) {
+    return sei_send_text_priority(text, SEI_PRIORITY_CONTROL);
+}
+
+bool sei_send_text_priority(const char *text, sei_priority_t priority) {
     if (!g_sei_publisher) {
         ESP_LOGE(TAG, "SEI publisher not initialized");
         return false;
@@ -59,7 +92,11 @@ bool sei_send_text(const char *text) {
         return false;
     }
     
-    bool result = sei_publisher_publish_text(g_sei_publisher, text, SEI_DEFAULT_REPEAT_COUNT);
+    sei_publish_opts_t opts = {
+        .repeat_count = SEI_DEFAULT_REPEAT_COUNT,
+        .priority = priority,
+    };
+    bool result = sei_publisher_publish_text_opts(g_sei_publisher, text, &opts);
     if (result) {
         ESP_LOGI(TAG, "📤 Queued text message: \"%.50s%s\"", 
                  text, strlen(text) > 50 ? "..." : "");
@@ -70,7 +107,45 @@ bool sei_send_text(const char *text) {
     return result;
 }
 
+bool sei_send_text_cue(const char *text, uint32_t delay_ms) {
+    if (!g_sei_publisher) {
+        ESP_LOGE(TAG, "SEI publisher not initialized");
+        return false;
+    }
+    
+    if (!text) {
+        ESP_LOGE(TAG, "Text parameter is NULL");
+        return false;
+    }
+    
+    uint32_t last_pts;
+    if (!sei_publisher_get_last_pts(g_sei_publisher, &last_pts)) {
+        ESP_LOGE(TAG, "❌ No video frame sent yet, can't time a cue");
+        return false;
+    }
+    
+    sei_publish_opts_t opts = {
+        .repeat_count = SEI_DEFAULT_REPEAT_COUNT,
+        .priority = SEI_PRIORITY_CONTROL,
+        .has_target_pts = true,
+        .target_pts = last_pts + delay_ms,
+    };
+    bool result = sei_publisher_publish_text_opts(g_sei_publisher, text, &opts);
+    if (result) {
+        ESP_LOGI(TAG, "📤 Queued text cue for PTS %" PRIu32 ": \"%.50s%s\"",
+                 opts.target_pts, text, strlen(text) > 50 ? "..." : "");
+    } else {
+        ESP_LOGE(TAG, "❌ Failed to queue text cue");
+    }
+    
+    return result;
+}
+
 bool sei_send_json(const char *role, const char *content) {
+    return sei_send_json_priority(role, content, SEI_PRIORITY_CONTROL);
+}
+
+bool sei_send_json_priority(const char *role, const char *content, sei_priority_t priority) {
     if (!g_sei_publisher) {
         ESP_LOGE(TAG, "SEI publisher not initialized");
         return false;
@@ -81,10 +156,31 @@ bool sei_send_json(const char *role, const char *content) {
         return false;
     }
     
-    // Create JSON message
-    char json_buffer[SEI_MAX_PAYLOAD_SIZE];
     uint32_t timestamp = esp_timer_get_time() / 1000; // Convert to milliseconds
+    sei_publish_opts_t opts = {
+        .repeat_count = SEI_DEFAULT_REPEAT_COUNT,
+        .priority = priority,
+    };
+    
+    if (SEI_PAYLOAD_BINARY) {
+        uint8_t payload[SEI_MAX_PAYLOAD_SIZE];
+        sei_tlv_writer_t writer;
+        sei_tlv_init(&writer, payload, sizeof(payload), SEI_TLV_SCHEMA_CHAT);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_TIMESTAMP, timestamp);
+        sei_tlv_put_string(&writer, SEI_TLV_FIELD_ROLE, role);
+        sei_tlv_put_string(&writer, SEI_TLV_FIELD_CONTENT, content);
+        
+        bool result = publish_tlv(&writer, &opts);
+        if (result) {
+            ESP_LOGI(TAG, "📤 Queued binary chat message: %s (%zu bytes)", role, writer.len);
+        } else {
+            ESP_LOGE(TAG, "❌ Failed to queue binary chat message");
+        }
+        return result;
+    }
     
+    // Create JSON message
+    char json_buffer[SEI_MAX_PAYLOAD_SIZE];
     int json_len = snprintf(json_buffer, sizeof(json_buffer),
                            "{\"role\":\"%s\",\"content\":\"%s\",\"timestamp\":%" PRIu32 ",\"type\":\"chat_message\"}", 
                            role, content, timestamp);
@@ -95,7 +191,7 @@ bool sei_send_json(const char *role, const char *content) {
         json_buffer[json_len] = '\0';
     }
     
-    bool result = sei_publisher_publish_json(g_sei_publisher, json_buffer, SEI_DEFAULT_REPEAT_COUNT);
+    bool result = sei_publisher_publish(g_sei_publisher, (const uint8_t *)json_buffer, json_len, &opts);
     if (result) {
         ESP_LOGI(TAG, "📤 Queued JSON message: %s - \"%.30s%s\"", 
                  role, content, strlen(content) > 30 ? "..." : "");
@@ -118,12 +214,19 @@ bool sei_send_raw_json(const char *json_data) {
     }
     
     size_t json_len = strlen(json_data);
-    if (json_len >= SEI_MAX_PAYLOAD_SIZE) {
-        ESP_LOGW(TAG, "Raw JSON message too large (%zu bytes), truncating to %d", 
-                 json_len, SEI_MAX_PAYLOAD_SIZE - 1);
+    if (json_len > SEI_MAX_FRAGMENTED_PAYLOAD_SIZE) {
+        ESP_LOGE(TAG, "Raw JSON message too large (%zu bytes, max %d)", 
+                 json_len, SEI_MAX_FRAGMENTED_PAYLOAD_SIZE);
+        return false;
     }
     
-    bool result = sei_publisher_publish_json(g_sei_publisher, json_data, SEI_DEFAULT_REPEAT_COUNT);
+    // Large documents are fragmented over several frames; send them as bulk
+    // so they don't hold up chat and control messages
+    sei_publish_opts_t opts = {
+        .repeat_count = SEI_DEFAULT_REPEAT_COUNT,
+        .priority = json_len > SEI_MAX_PAYLOAD_SIZE ? SEI_PRIORITY_BULK : SEI_PRIORITY_CONTROL,
+    };
+    bool result = sei_publisher_publish(g_sei_publisher, (const uint8_t *)json_data, json_len, &opts);
     if (result) {
         ESP_LOGI(TAG, "📤 Queued raw JSON message: \"%.50s%s\"", 
                  json_data, json_len > 50 ? "..." : "");
@@ -134,6 +237,34 @@ bool sei_send_raw_json(const char *json_data) {
     return result;
 }
 
+bool sei_send_state_json(const char *key, const char *json_data) {
+    if (!g_sei_publisher) {
+        ESP_LOGE(TAG, "SEI publisher not initialized");
+        return false;
+    }
+    
+    if (!key || !json_data) {
+        ESP_LOGE(TAG, "Key or JSON data parameter is NULL");
+        return false;
+    }
+    
+    // Latest value wins per key, so keyframes never re-send a stale state
+    sei_publish_opts_t opts = {
+        .repeat_count = SEI_DEFAULT_REPEAT_COUNT,
+        .sticky = true,
+        .topic = key,
+    };
+    bool result = sei_publisher_publish(g_sei_publisher, (const uint8_t *)json_data, strlen(json_data), &opts);
+    if (result) {
+        ESP_LOGI(TAG, "📤 Queued state JSON message for %s: \"%.50s%s\"", 
+                 key, json_data, strlen(json_data) > 50 ? "..." : "");
+    } else {
+        ESP_LOGE(TAG, "❌ Failed to queue state JSON message");
+    }
+    
+    return result;
+}
+
 bool sei_send_status(const char *status, int value) {
     if (!g_sei_publisher) {
         ESP_LOGE(TAG, "SEI publisher not initialized");
@@ -145,10 +276,34 @@ bool sei_send_status(const char *status, int value) {
         return false;
     }
     
-    // Create status JSON message
-    char json_buffer[SEI_MAX_PAYLOAD_SIZE];
     uint32_t timestamp = esp_timer_get_time() / 1000; // Convert to milliseconds
     
+    // Status values are periodic telemetry, latest-value-wins per status name
+    sei_publish_opts_t opts = {
+        .repeat_count = SEI_DEFAULT_REPEAT_COUNT,
+        .priority = SEI_PRIORITY_BULK,
+        .topic = status,
+    };
+    
+    if (SEI_PAYLOAD_BINARY) {
+        uint8_t payload[SEI_MAX_PAYLOAD_SIZE];
+        sei_tlv_writer_t writer;
+        sei_tlv_init(&writer, payload, sizeof(payload), SEI_TLV_SCHEMA_STATUS);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_TIMESTAMP, timestamp);
+        sei_tlv_put_string(&writer, SEI_TLV_FIELD_STATUS, status);
+        sei_tlv_put_int(&writer, SEI_TLV_FIELD_VALUE, value);
+        
+        bool result = publish_tlv(&writer, &opts);
+        if (result) {
+            ESP_LOGI(TAG, "📤 Queued binary status message: %s = %d (%zu bytes)", status, value, writer.len);
+        } else {
+            ESP_LOGE(TAG, "❌ Failed to queue binary status message");
+        }
+        return result;
+    }
+    
+    // Create status JSON message
+    char json_buffer[SEI_MAX_PAYLOAD_SIZE];
     int json_len = snprintf(json_buffer, sizeof(json_buffer),
                            "{\"status\":\"%s\",\"value\":%d,\"timestamp\":%" PRIu32 ",\"type\":\"status_update\"}", 
                            status, value, timestamp);
@@ -159,7 +314,7 @@ bool sei_send_status(const char *status, int value) {
         json_buffer[json_len] = '\0';
     }
     
-    bool result = sei_publisher_publish_json(g_sei_publisher, json_buffer, SEI_DEFAULT_REPEAT_COUNT);
+    bool result = sei_publisher_publish(g_sei_publisher, (const uint8_t *)json_buffer, strlen(json_buffer), &opts);
     if (result) {
         ESP_LOGI(TAG, "📤 Queued status message: %s = %d", status, value);
     } else {
@@ -169,6 +324,250 @@ bool sei_send_status(const char *status, int value) {
     return result;
 }
 
+bool sei_send_sensor_reading(int16_t temperature_deci_c, uint16_t humidity_deci, bool ok) {
+    if (!g_sei_publisher) {
+        ESP_LOGE(TAG, "SEI publisher not initialized");
+        return false;
+    }
+    
+    uint32_t timestamp = esp_timer_get_time() / 1000; // Convert to milliseconds
+    bool result;
+    
+    // Each reading replaces the pending one; only good readings are pinned to keyframes
+    sei_publish_opts_t opts = {
+        .repeat_count = SEI_DEFAULT_REPEAT_COUNT,
+        .sticky = ok,
+        .priority = SEI_PRIORITY_BULK,
+        .topic = SEI_TOPIC_DHT11,
+    };
+    
+    if (SEI_PAYLOAD_BINARY) {
+        uint8_t payload[32];
+        sei_tlv_writer_t writer;
+        sei_tlv_init(&writer, payload, sizeof(payload), SEI_TLV_SCHEMA_SENSOR);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_TIMESTAMP, timestamp);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_SENSOR_ID, SEI_TLV_SENSOR_DHT11);
+        if (ok) {
+            sei_tlv_put_int(&writer, SEI_TLV_FIELD_TEMP_DECI_C, temperature_deci_c);
+            sei_tlv_put_uint(&writer, SEI_TLV_FIELD_HUMIDITY_DECI, humidity_deci);
+        }
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_SENSOR_STATUS, ok ? 0 : 1);
+        result = publish_tlv(&writer, &opts);
+    } else if (ok) {
+        // Fixed-point formatting, no float printf on the sensor path
+        char json_buffer[160];
+        int temp_abs = temperature_deci_c < 0 ? -temperature_deci_c : temperature_deci_c;
+        snprintf(json_buffer, sizeof(json_buffer),
+                 "{\"sensor\":\"DHT11\",\"temperature_c\":%s%d.%d,\"humidity_percent\":%d.%d,\"timestamp\":%" PRIu32 ",\"status\":\"ok\",\"type\":\"sensor_data\"}",
+                 temperature_deci_c < 0 ? "-" : "", temp_abs / 10, temp_abs % 10,
+                 humidity_deci / 10, humidity_deci % 10, timestamp);
+        result = sei_publisher_publish(g_sei_publisher, (const uint8_t *)json_buffer, strlen(json_buffer), &opts);
+    } else {
+        char json_buffer[128];
+        snprintf(json_buffer, sizeof(json_buffer),
+                 "{\"sensor\":\"DHT11\",\"timestamp\":%" PRIu32 ",\"status\":\"read_error\",\"type\":\"sensor_error\"}", timestamp);
+        result = sei_publisher_publish(g_sei_publisher, (const uint8_t *)json_buffer, strlen(json_buffer), &opts);
+    }
+    
+    if (!result) {
+        ESP_LOGE(TAG, "❌ Failed to queue sensor reading");
+    }
+    return result;
+}
+
+/**
+ * @brief Report a replayed reading sent once its frame is written, on the video thread
+ */
+static void logged_reading_sent(void *ctx, uint32_t seq) {
+    telemetry_log_mark_replayed(seq);
+}
+
+bool sei_send_logged_reading(const telemetry_record_t *record) {
+    if (!g_sei_publisher) {
+        ESP_LOGE(TAG, "SEI publisher not initialized");
+        return false;
+    }
+    
+    if (!record) {
+        ESP_LOGE(TAG, "Record parameter is NULL");
+        return false;
+    }
+    
+    if (record->kind != TELEMETRY_KIND_DHT11) {
+        // Nothing to send it as; skip it so the replay moves on
+        ESP_LOGW(TAG, "⚠️ Skipping logged reading %" PRIu32 " of unknown kind %d", record->seq, record->kind);
+        telemetry_log_mark_replayed(record->seq);
+        return true;
+    }
+    
+    // The log only moves past the reading once it is in a frame on its way out
+    sei_publish_opts_t opts = {
+        .repeat_count = 1,
+        .priority = SEI_PRIORITY_BULK,
+        .on_sent = logged_reading_sent,
+        .on_sent_tag = record->seq,
+    };
+    bool ok = record->status == 0;
+    int32_t temperature_deci_c = record->value[0];
+    uint32_t humidity_deci = (uint32_t)record->value[1];
+    bool result;
+    
+    if (SEI_PAYLOAD_BINARY) {
+        uint8_t payload[40];
+        sei_tlv_writer_t writer;
+        sei_tlv_init(&writer, payload, sizeof(payload), SEI_TLV_SCHEMA_SENSOR);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_TIMESTAMP, record->uptime_ms);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_SENSOR_ID, SEI_TLV_SENSOR_DHT11);
+        if (ok) {
+            sei_tlv_put_int(&writer, SEI_TLV_FIELD_TEMP_DECI_C, temperature_deci_c);
+            sei_tlv_put_uint(&writer, SEI_TLV_FIELD_HUMIDITY_DECI, humidity_deci);
+        }
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_SENSOR_STATUS, ok ? 0 : 1);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_LOG_SEQ, record->seq);
+        if (record->unix_s) {
+            sei_tlv_put_uint(&writer, SEI_TLV_FIELD_READING_UNIX_S, record->unix_s);
+        }
+        result = publish_tlv(&writer, &opts);
+    } else {
+        char unix_field[24] = "";
+        if (record->unix_s) {
+            snprintf(unix_field, sizeof(unix_field), ",\"unix_s\":%" PRIu32, record->unix_s);
+        }
+        char json_buffer[200];
+        if (ok) {
+            int32_t temp_abs = temperature_deci_c < 0 ? -temperature_deci_c : temperature_deci_c;
+            snprintf(json_buffer, sizeof(json_buffer),
+                     "{\"sensor\":\"DHT11\",\"temperature_c\":%s%" PRId32 ".%" PRId32 ",\"humidity_percent\":%" PRIu32 ".%" PRIu32
+                     ",\"timestamp\":%" PRIu32 "%s,\"log_seq\":%" PRIu32 ",\"status\":\"ok\",\"type\":\"sensor_backlog\"}",
+                     temperature_deci_c < 0 ? "-" : "", temp_abs / 10, temp_abs % 10,
+                     humidity_deci / 10, humidity_deci % 10, record->uptime_ms, unix_field, record->seq);
+        } else {
+            snprintf(json_buffer, sizeof(json_buffer),
+                     "{\"sensor\":\"DHT11\",\"timestamp\":%" PRIu32 "%s,\"log_seq\":%" PRIu32
+                     ",\"status\":\"read_error\",\"type\":\"sensor_backlog\"}",
+                     record->uptime_ms, unix_field, record->seq);
+        }
+        result = sei_publisher_publish(g_sei_publisher, (const uint8_t *)json_buffer, strlen(json_buffer), &opts);
+    }
+    
+    if (!result) {
+        ESP_LOGE(TAG, "❌ Failed to queue logged reading %" PRIu32, record->seq);
+    }
+    return result;
+}
+
+bool sei_send_webrtc_stats(const webrtc_stats_sample_t *sample) {
+    if (!g_sei_publisher) {
+        ESP_LOGE(TAG, "SEI publisher not initialized");
+        return false;
+    }
+    
+    if (!sample) {
+        ESP_LOGE(TAG, "Stats sample parameter is NULL");
+        return false;
+    }
+    
+    sei_publish_opts_t opts = {
+        .repeat_count = 1,
+        .priority = SEI_PRIORITY_BULK,
+        .topic = SEI_TOPIC_WEBRTC_STATS,
+    };
+    uint32_t fps_x10 = webrtc_stats_fps_x10(sample);
+    bool result;
+    
+    if (SEI_PAYLOAD_BINARY) {
+        uint8_t payload[96];
+        sei_tlv_writer_t writer;
+        sei_tlv_init(&writer, payload, sizeof(payload), SEI_TLV_SCHEMA_STATS);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_TIMESTAMP, sample->timestamp_ms);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_INTERVAL_MS, sample->interval_ms);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_FPS_X10, fps_x10);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_SEND_KBPS, sample->send_kbps);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_SEND_DELAY_MS, sample->max_send_delay_ms);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_KEYFRAMES, sample->keyframes);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_SEI_DROPPED, sample->sei_dropped);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_SEI_QUEUE, sample->sei_queue_depth);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_FREE_HEAP, sample->free_heap);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_PROFILE, sample->profile_index);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_FRAMES_MISSED, sample->frames_missed);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_FRAMES_LATE, sample->frames_late);
+        result = publish_tlv(&writer, &opts);
+    } else {
+        char json_buffer[320];
+        snprintf(json_buffer, sizeof(json_buffer),
+                 "{\"interval_ms\":%" PRIu32 ",\"fps\":%" PRIu32 ".%" PRIu32 ",\"send_kbps\":%" PRIu32
+                 ",\"send_delay_ms\":%" PRIu32 ",\"keyframes\":%" PRIu32 ",\"frames_missed\":%" PRIu32
+                 ",\"frames_late\":%" PRIu32 ",\"sei_dropped\":%" PRIu32
+                 ",\"sei_queue\":%u,\"free_heap\":%" PRIu32 ",\"profile\":%u,\"timestamp\":%" PRIu32
+                 ",\"type\":\"webrtc_stats\"}",
+                 sample->interval_ms, fps_x10 / 10, fps_x10 % 10, sample->send_kbps,
+                 sample->max_send_delay_ms, sample->keyframes, sample->frames_missed, sample->frames_late,
+                 sample->sei_dropped, (unsigned)sample->sei_queue_depth, sample->free_heap,
+                 (unsigned)sample->profile_index, sample->timestamp_ms);
+        result = sei_publisher_publish(g_sei_publisher, (const uint8_t *)json_buffer, strlen(json_buffer), &opts);
+    }
+    
+    if (!result) {
+        ESP_LOGE(TAG, "❌ Failed to queue WebRTC stats");
+    }
+    return result;
+}
+
+bool sei_send_latency_probe(const latency_probe_t *probe) {
+    if (!g_sei_publisher) {
+        ESP_LOGE(TAG, "SEI publisher not initialized");
+        return false;
+    }
+    
+    if (!probe) {
+        ESP_LOGE(TAG, "Probe parameter is NULL");
+        return false;
+    }
+    
+    sei_publish_opts_t opts = {
+        .repeat_count = 1,
+        .priority = SEI_PRIORITY_CONTROL,
+    };
+    uint32_t capture_ms = (uint32_t)(probe->capture_us / 1000);
+    bool result;
+    
+    if (SEI_PAYLOAD_BINARY) {
+        uint8_t payload[48];
+        sei_tlv_writer_t writer;
+        sei_tlv_init(&writer, payload, sizeof(payload), SEI_TLV_SCHEMA_PROBE);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_TIMESTAMP, capture_ms);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_PROBE_SEQ, probe->seq);
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_PROBE_PTS, probe->pts);
+        if (probe->capture_unix_us) {
+            sei_tlv_put_uint(&writer, SEI_TLV_FIELD_CAPTURE_UNIX_S, (uint32_t)(probe->capture_unix_us / 1000000));
+            sei_tlv_put_uint(&writer, SEI_TLV_FIELD_CAPTURE_UNIX_US, (uint32_t)(probe->capture_unix_us % 1000000));
+        }
+        if (probe->encode_us) {
+            sei_tlv_put_uint(&writer, SEI_TLV_FIELD_ENCODE_US, probe->encode_us);
+        }
+        sei_tlv_put_uint(&writer, SEI_TLV_FIELD_SEND_US, probe->send_us);
+        result = publish_tlv(&writer, &opts);
+    } else {
+        // Wall-clock milliseconds need more than 32 bits, so they are printed as 64-bit
+        char json_buffer[200];
+        char unix_field[40] = "";
+        if (probe->capture_unix_us) {
+            snprintf(unix_field, sizeof(unix_field), ",\"capture_unix_ms\":%" PRId64 ".%03d",
+                     probe->capture_unix_us / 1000, (int)(probe->capture_unix_us % 1000));
+        }
+        snprintf(json_buffer, sizeof(json_buffer),
+                 "{\"seq\":%" PRIu32 ",\"pts\":%" PRIu32 ",\"capture_ms\":%" PRIu32 "%s,\"encode_us\":%" PRIu32
+                 ",\"send_us\":%" PRIu32 ",\"type\":\"latency_probe\"}",
+                 probe->seq, probe->pts, capture_ms, unix_field, probe->encode_us, probe->send_us);
+        result = sei_publisher_publish(g_sei_publisher, (const uint8_t *)json_buffer, strlen(json_buffer), &opts);
+    }
+    
+    if (!result) {
+        ESP_LOGE(TAG, "❌ Failed to queue latency probe %" PRIu32, probe->seq);
+    }
+    return result;
+}
+
 int sei_get_queue_status(void) {
     if (!g_sei_publisher) {
         ESP_LOGE(TAG, "SEI publisher not initialized");
@@ -6,6 +6,15 @@
 #pragma once
 
 #include "sei_publisher.h"
+#include "webrtc_stats.h"
+#include "latency_probe.h"
+#include "telemetry_log.h"
+
+// Topic of DHT-11 readings, each reading replaces the pending one
+#define SEI_TOPIC_DHT11 "dht11"
+
+// Topic of WebRTC stats samples
+#define SEI_TOPIC_WEBRTC_STATS "webrtc_stats"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +40,27 @@ void sei_deinit(void);
  */
 bool sei_send_text(const char *text);
 
+/**
+ * @brief Send a text message via SEI in the given priority class
+ * 
+ * @param text Text message to send
+ * @param priority SEI_PRIORITY_BULK for periodic or test traffic that may be shed first
+ * @return true if message queued successfully, false otherwise
+ */
+bool sei_send_text_priority(const char *text, sei_priority_t priority);
+
+/**
+ * @brief Send a text message timed to a frame a given delay ahead
+ * 
+ * The message is held until the first frame whose PTS is at least delay_ms
+ * past the last frame sent, for overlays that must line up with the video.
+ * 
+ * @param text Text message to send
+ * @param delay_ms Delay from the last frame's PTS (at most SEI_MAX_TARGET_AHEAD_MS)
+ * @return true if message queued successfully, false otherwise (also before the first frame)
+ */
+bool sei_send_text_cue(const char *text, uint32_t delay_ms);
+
 /**
  * @brief Send a JSON message via SEI
  * 
@@ -40,23 +70,109 @@ bool sei_send_text(const char *text);
  */
 bool sei_send_json(const char *role, const char *content);
 
+/**
+ * @brief Send a JSON message via SEI in the given priority class
+ * 
+ * @param role Message role (e.g., "user", "assistant")
+ * @param content Message content
+ * @param priority SEI_PRIORITY_BULK for periodic or test traffic that may be shed first
+ * @return true if message queued successfully, false otherwise
+ */
+bool sei_send_json_priority(const char *role, const char *content, sei_priority_t priority);
+
 /**
  * @brief Send raw JSON data via SEI without additional wrapping
  * 
+ * JSON longer than SEI_MAX_PAYLOAD_SIZE (up to SEI_MAX_FRAGMENTED_PAYLOAD_SIZE)
+ * is fragmented and sent as bulk traffic over the following frames.
+ * 
  * @param json_data Complete JSON string to send as-is
  * @return true if message queued successfully, false otherwise
  */
 bool sei_send_raw_json(const char *json_data);
 
+/**
+ * @brief Send a JSON state message that is repeated on every keyframe
+ * 
+ * Use for the latest value of a slowly changing state (sensor readings,
+ * device status) so viewers joining mid-stream receive it on their first
+ * keyframe. Each key is a sticky topic, so a new value replaces the old one
+ * and keyframes only ever carry the latest value of every key.
+ * 
+ * @param key State name, up to SEI_MAX_TOPIC_LEN - 1 characters
+ * @param json_data Complete JSON string to send as-is
+ * @return true if message queued successfully, false otherwise
+ */
+bool sei_send_state_json(const char *key, const char *json_data);
+
 /**
  * @brief Send a status message via SEI
  * 
+ * Statuses are bulk telemetry and latest-value-wins per status name, a new
+ * value replaces the one still being repeated.
+ * 
  * @param status Status string
  * @param value Numeric value
  * @return true if message queued successfully, false otherwise
  */
 bool sei_send_status(const char *status, int value);
 
+/**
+ * @brief Send a DHT-11 reading via SEI
+ * 
+ * Readings are bulk telemetry on the SEI_TOPIC_DHT11 topic, so a new reading
+ * replaces the pending one, and good readings are re-sent on keyframes.
+ * With SEI_PAYLOAD_BINARY they use the TLV sensor schema from sei_tlv.h,
+ * otherwise the sensor_data JSON.
+ * 
+ * @param temperature_deci_c Temperature in tenths of a degree Celsius
+ * @param humidity_deci Relative humidity in tenths of a percent
+ * @param ok false to report a read error (values are ignored)
+ * @return true if message queued successfully, false otherwise
+ */
+bool sei_send_sensor_reading(int16_t temperature_deci_c, uint16_t humidity_deci, bool ok);
+
+/**
+ * @brief Send a reading replayed from the telemetry log via SEI
+ * 
+ * Sent once as bulk telemetry, outside any topic so replayed readings
+ * don't replace each other or the live one. The payload is the live
+ * reading's plus the log seq and, when known, the wall-clock time of
+ * the reading; the timestamp is the uptime of the boot that took it.
+ * The reading is reported to telemetry_log_mark_replayed once the frame
+ * carrying it is written, never if it is dropped from the queue.
+ * 
+ * @param record Logged reading
+ * @return true if message queued successfully, false otherwise
+ */
+bool sei_send_logged_reading(const telemetry_record_t *record);
+
+/**
+ * @brief Send a WebRTC stats window via SEI
+ * 
+ * Stats are low-rate bulk telemetry on the SEI_TOPIC_WEBRTC_STATS topic,
+ * sent once (a lost sample is superseded by the next). With
+ * SEI_PAYLOAD_BINARY they use the TLV stats schema from sei_tlv.h,
+ * otherwise the webrtc_stats JSON.
+ * 
+ * @param sample Stats window to send
+ * @return true if message queued successfully, false otherwise
+ */
+bool sei_send_webrtc_stats(const webrtc_stats_sample_t *sample);
+
+/**
+ * @brief Send a latency probe via SEI
+ * 
+ * Sent once as a control message, so it lands in the next frame spliced,
+ * which is the one it describes when queued from the send callback. With
+ * SEI_PAYLOAD_BINARY it uses the TLV probe schema from sei_tlv.h,
+ * otherwise the latency_probe JSON.
+ * 
+ * @param probe Probe to send
+ * @return true if message queued successfully, false otherwise
+ */
+bool sei_send_latency_probe(const latency_probe_t *probe);
+
 /**
  * @brief Get current SEI queue status
  * 
@@ -0,0 +1,192 @@
+/* SEI Pipeline Benchmark Implementation
+ * 
+ * Replays synthetic H.264 access units through sei_publisher_process_frame
+ * on a private publisher, so SEI path changes can be measured on the device
+ */
+
+#include "sei_bench.h"
+#include "sei_publisher.h"
+#include "sei_metrics.h"
+#include "video_frame_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <inttypes.h>
+
+static const char *TAG = "SEI_BENCH";
+
+// Synthetic access unit sizes, roughly what the encoder emits for 1080p
+#define SEI_BENCH_IDR_SIZE          (120 * 1024)
+#define SEI_BENCH_P_SIZE            (16 * 1024)
+#define SEI_BENCH_SLICE_COUNT       4
+
+typedef struct {
+    const char *name;
+    uint8_t *data;
+    size_t size;
+} sei_bench_frame_t;
+
+/**
+ * @brief Append a NAL unit with a 4-byte start code and pseudo-random body
+ *
+ * Body bytes are never zero, so the body can't contain a start code.
+ */
+static size_t append_nal(uint8_t *out, size_t pos, uint8_t header, size_t body_size, uint32_t *seed) {
+    out[pos++] = 0x00;
+    out[pos++] = 0x00;
+    out[pos++] = 0x00;
+    out[pos++] = 0x01;
+    out[pos++] = header;
+    for (size_t i = 0; i < body_size; i++) {
+        *seed = *seed * 1664525u + 1013904223u;
+        out[pos++] = (uint8_t)((*seed >> 24) | 0x01);
+    }
+    return pos;
+}
+
+/**
+ * @brief Build the IDR, P-frame and multi-slice access units
+ */
+static bool build_frames(sei_bench_frame_t *frames) {
+    uint32_t seed = 0x5e1b3c4d;
+    size_t pos;
+    
+    frames[0].name = "idr_1080p";
+    frames[1].name = "p_frame";
+    frames[2].name = "multi_slice";
+    frames[0].data = heap_caps_malloc(SEI_BENCH_IDR_SIZE + 64, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    frames[1].data = heap_caps_malloc(SEI_BENCH_P_SIZE + 64, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    frames[2].data = heap_caps_malloc(SEI_BENCH_P_SIZE + 64, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!frames[0].data || !frames[1].data || !frames[2].data) {
+        return false;
+    }
+    
+    // SPS, PPS and one IDR slice, as the encoder emits for keyframes
+    pos = append_nal(frames[0].data, 0, 0x67, 12, &seed);
+    pos = append_nal(frames[0].data, pos, 0x68, 4, &seed);
+    frames[0].size = append_nal(frames[0].data, pos, 0x65, SEI_BENCH_IDR_SIZE, &seed);
+    
+    frames[1].size = append_nal(frames[1].data, 0, 0x41, SEI_BENCH_P_SIZE, &seed);
+    
+    pos = 0;
+    for (int i = 0; i < SEI_BENCH_SLICE_COUNT; i++) {
+        pos = append_nal(frames[2].data, pos, 0x41, SEI_BENCH_P_SIZE / SEI_BENCH_SLICE_COUNT, &seed);
+    }
+    frames[2].size = pos;
+    return true;
+}
+
+/**
+ * @brief Replay one frame at one queue depth and print the result row
+ */
+static void run_scenario(sei_publisher_handle_t publisher, const sei_bench_frame_t *frame, int depth,
+                         const sei_bench_config_t *config, const uint8_t *payload) {
+    sei_publish_opts_t opts = {
+        .repeat_count = config->repeat_count,
+    };
+    uint64_t process_us = 0;
+    uint64_t enqueue_us = 0;
+    uint64_t bytes_copied = 0;
+    uint32_t fallback_before, fallback_after;
+    video_frame_pool_get_stats(NULL, &fallback_before);
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t free_min = free_before;
+    
+    for (int i = 0; i < config->iterations; i++) {
+        // Start every frame with exactly depth messages pending; messages still
+        // scheduled from the last frame are dropped on the next build, so run
+        // an untimed build to free their slots first
+        sei_publisher_clear_queue(publisher);
+        sei_splice_t flush;
+        sei_publisher_build_splice(publisher, frame->data, frame->size, &flush);
+        int64_t enqueue_start = esp_timer_get_time();
+        for (int m = 0; m < depth; m++) {
+            sei_publisher_publish(publisher, payload, config->payload_size, &opts);
+        }
+        int64_t process_start = esp_timer_get_time();
+        enqueue_us += process_start - enqueue_start;
+        
+        uint8_t *output = NULL;
+        size_t output_size = 0;
+        bool modified = sei_publisher_process_frame(publisher, frame->data, frame->size, &output, &output_size);
+        process_us += esp_timer_get_time() - process_start;
+        
+        size_t free_now = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        if (free_now < free_min) {
+            free_min = free_now;
+        }
+        if (modified) {
+            // SEI block assembly plus the full output frame
+            bytes_copied += 2 * output_size - frame->size;
+            video_frame_pool_release(output);
+        }
+    }
+    video_frame_pool_get_stats(NULL, &fallback_after);
+    
+    int n = config->iterations;
+    printf("%-12s %5d %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10zu %9.2f\n",
+           frame->name, depth, process_us * 1000 / n, depth ? enqueue_us * 1000 / (n * depth) : 0,
+           bytes_copied / n, free_before - free_min, (double)(fallback_after - fallback_before) / n);
+}
+
+/**
+ * @brief Free the synthetic access units
+ */
+static void free_frames(sei_bench_frame_t *frames) {
+    for (int f = 0; f < 3; f++) {
+        heap_caps_free(frames[f].data);
+        frames[f].data = NULL;
+    }
+}
+
+bool sei_bench_run(const sei_bench_config_t *config) {
+    if (!config || config->iterations <= 0 || config->payload_size > SEI_MAX_PAYLOAD_SIZE ||
+        config->repeat_count < 1) {
+        ESP_LOGE(TAG, "Invalid benchmark config");
+        return false;
+    }
+    
+    sei_bench_frame_t frames[3] = { 0 };
+    if (!build_frames(frames)) {
+        ESP_LOGE(TAG, "Failed to allocate benchmark frames");
+        free_frames(frames);
+        return false;
+    }
+    
+    // Private publisher so the live queue is left untouched. The queue is
+    // cleared before every frame, so repeats must all land in the measured one
+    sei_publisher_config_t publisher_config = SEI_PUBLISHER_DEFAULT_CONFIG();
+    publisher_config.spread_repeats = false;
+    sei_publisher_handle_t publisher = sei_publisher_init_with_config(&publisher_config);
+    if (!publisher) {
+        ESP_LOGE(TAG, "Failed to create benchmark publisher");
+        free_frames(frames);
+        return false;
+    }
+    
+    // Printable filler keeps the payload JSON-like
+    uint8_t payload[SEI_MAX_PAYLOAD_SIZE];
+    memset(payload, 'x', sizeof(payload));
+    
+    // The bench frames go through the shared histograms; keep the live figures
+    static sei_metrics_snapshot_t metrics;
+    sei_metrics_save(&metrics);
+    
+    printf("SEI bench: %d frames per scenario, %zu byte payloads, repeat %d\n",
+           config->iterations, config->payload_size, config->repeat_count);
+    printf("%-12s %5s %10s %10s %10s %10s %9s\n",
+           "frame", "depth", "ns/frame", "ns/msg", "copied/f", "heap_drop", "pool_fb/f");
+    const int depths[] = { 0, 1, 4, SEI_MAX_QUEUE_SIZE };
+    for (int f = 0; f < 3; f++) {
+        for (int d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+            run_scenario(publisher, &frames[f], depths[d], config, payload);
+        }
+    }
+    
+    sei_publisher_deinit(publisher);
+    sei_metrics_restore(&metrics);
+    free_frames(frames);
+    return true;
+}
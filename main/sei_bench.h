@@ -0,0 +1,46 @@
+/* SEI Pipeline Benchmark
+ * 
+ * Replays synthetic H.264 access units through sei_publisher_process_frame
+ * on a private publisher, so SEI path changes can be measured on the device
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default number of frames replayed per scenario
+#define SEI_BENCH_DEFAULT_ITERATIONS 200
+
+/**
+ * @brief Benchmark parameters
+ */
+typedef struct {
+    int iterations;             /*!< Frames replayed per scenario */
+    size_t payload_size;        /*!< Payload bytes per message (at most SEI_MAX_PAYLOAD_SIZE) */
+    int repeat_count;           /*!< Repeat count of every message, all copies sent in the same frame */
+} sei_bench_config_t;
+
+/**
+ * @brief Run every scenario and print one result row per scenario
+ * 
+ * Scenarios cover a 1080p IDR access unit (SPS, PPS, IDR), a P-frame and a
+ * four-slice P-frame at queue depths of 0, 1, 4 and SEI_MAX_QUEUE_SIZE
+ * messages. Rows report ns per frame, ns per enqueued message, bytes copied
+ * per frame, the largest drop in free heap sampled between frames (memory
+ * freed again within a frame is not seen) and frame pool heap fallbacks per
+ * frame. The global SEI metrics are restored afterwards.
+ * 
+ * @param config Benchmark parameters
+ * @return true if the benchmark ran, false if its buffers could not be allocated
+ */
+bool sei_bench_run(const sei_bench_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,158 @@
+/* SEI Pipeline Metrics Implementation
+ * 
+ * Lock-free latency histograms and event counters for the SEI path, so the
+ * per-frame cost of the hook can be checked against the frame interval
+ */
+
+#include "sei_metrics.h"
+#include <stdatomic.h>
+#include <string.h>
+
+// Bucket upper bounds in microseconds; the last bucket catches everything above
+static const uint32_t s_bucket_limits_us[SEI_METRICS_BUCKET_COUNT] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 40000, 50000, UINT32_MAX,
+};
+
+typedef struct {
+    _Atomic uint32_t buckets[SEI_METRICS_BUCKET_COUNT];
+    _Atomic uint32_t max_us;
+    _Atomic uint64_t total_us;
+} sei_histogram_t;
+
+static sei_histogram_t s_histograms[SEI_STAGE_COUNT];
+static _Atomic uint32_t s_events[SEI_EVENT_COUNT];
+
+static const char *s_stage_names[SEI_STAGE_COUNT] = {
+    [SEI_STAGE_HOOK_FRAME] = "hook_frame",
+    [SEI_STAGE_NAL_INDEX] = "nal_index",
+    [SEI_STAGE_SPLICE_BUILD] = "splice_build",
+    [SEI_STAGE_FRAME_COPY] = "frame_copy",
+    [SEI_STAGE_NAL_ENCODE] = "nal_encode",
+};
+
+static const char *s_event_names[SEI_EVENT_COUNT] = {
+    [SEI_EVENT_CHAIN_BUSY] = "chain_busy",
+    [SEI_EVENT_LOW_HEAP_WIPE] = "low_heap_wipe",
+    [SEI_EVENT_BULK_SHED] = "bulk_shed",
+    [SEI_EVENT_DROPPED_OLDEST] = "dropped_oldest",
+    [SEI_EVENT_DROPPED_NEW] = "dropped_new",
+};
+
+void sei_metrics_record(sei_metrics_stage_t stage, uint32_t elapsed_us) {
+    if (stage >= SEI_STAGE_COUNT) return;
+    
+    sei_histogram_t *hist = &s_histograms[stage];
+    int bucket = 0;
+    while (elapsed_us > s_bucket_limits_us[bucket]) {
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&hist->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->total_us, elapsed_us, memory_order_relaxed);
+    
+    uint32_t max_us = atomic_load_explicit(&hist->max_us, memory_order_relaxed);
+    while (elapsed_us > max_us &&
+           !atomic_compare_exchange_weak_explicit(&hist->max_us, &max_us, elapsed_us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void sei_metrics_count(sei_metrics_event_t event) {
+    if (event >= SEI_EVENT_COUNT) return;
+    atomic_fetch_add_explicit(&s_events[event], 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Upper bound of the bucket holding the given rank
+ */
+static uint32_t bucket_percentile(const uint32_t *buckets, uint32_t count, uint32_t max_us, int percent) {
+    uint32_t rank = (uint32_t)(((uint64_t)count * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (int i = 0; i < SEI_METRICS_BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // Never report more than the largest sample
+            return s_bucket_limits_us[i] < max_us ? s_bucket_limits_us[i] : max_us;
+        }
+    }
+    return max_us;
+}
+
+void sei_metrics_get_summary(sei_metrics_stage_t stage, sei_metrics_summary_t *summary) {
+    if (!summary) return;
+    memset(summary, 0, sizeof(*summary));
+    if (stage >= SEI_STAGE_COUNT) return;
+    
+    // Snapshot the buckets; samples landing meanwhile only skew this one report
+    sei_histogram_t *hist = &s_histograms[stage];
+    uint32_t buckets[SEI_METRICS_BUCKET_COUNT];
+    uint32_t count = 0;
+    for (int i = 0; i < SEI_METRICS_BUCKET_COUNT; i++) {
+        buckets[i] = atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+        count += buckets[i];
+    }
+    
+    summary->count = count;
+    summary->max_us = atomic_load_explicit(&hist->max_us, memory_order_relaxed);
+    summary->total_us = atomic_load_explicit(&hist->total_us, memory_order_relaxed);
+    if (count > 0) {
+        summary->p50_us = bucket_percentile(buckets, count, summary->max_us, 50);
+        summary->p99_us = bucket_percentile(buckets, count, summary->max_us, 99);
+    }
+}
+
+uint32_t sei_metrics_get_count(sei_metrics_event_t event) {
+    if (event >= SEI_EVENT_COUNT) return 0;
+    return atomic_load_explicit(&s_events[event], memory_order_relaxed);
+}
+
+const char *sei_metrics_stage_name(sei_metrics_stage_t stage) {
+    return stage < SEI_STAGE_COUNT ? s_stage_names[stage] : "unknown";
+}
+
+const char *sei_metrics_event_name(sei_metrics_event_t event) {
+    return event < SEI_EVENT_COUNT ? s_event_names[event] : "unknown";
+}
+
+void sei_metrics_reset(void) {
+    for (int s = 0; s < SEI_STAGE_COUNT; s++) {
+        sei_histogram_t *hist = &s_histograms[s];
+        for (int i = 0; i < SEI_METRICS_BUCKET_COUNT; i++) {
+            atomic_store_explicit(&hist->buckets[i], 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&hist->max_us, 0, memory_order_relaxed);
+        atomic_store_explicit(&hist->total_us, 0, memory_order_relaxed);
+    }
+    for (int e = 0; e < SEI_EVENT_COUNT; e++) {
+        atomic_store_explicit(&s_events[e], 0, memory_order_relaxed);
+    }
+}
+
+void sei_metrics_save(sei_metrics_snapshot_t *snapshot) {
+    if (!snapshot) return;
+    for (int s = 0; s < SEI_STAGE_COUNT; s++) {
+        sei_histogram_t *hist = &s_histograms[s];
+        for (int i = 0; i < SEI_METRICS_BUCKET_COUNT; i++) {
+            snapshot->buckets[s][i] = atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+        }
+        snapshot->max_us[s] = atomic_load_explicit(&hist->max_us, memory_order_relaxed);
+        snapshot->total_us[s] = atomic_load_explicit(&hist->total_us, memory_order_relaxed);
+    }
+    for (int e = 0; e < SEI_EVENT_COUNT; e++) {
+        snapshot->events[e] = atomic_load_explicit(&s_events[e], memory_order_relaxed);
+    }
+}
+
+void sei_metrics_restore(const sei_metrics_snapshot_t *snapshot) {
+    if (!snapshot) return;
+    for (int s = 0; s < SEI_STAGE_COUNT; s++) {
+        sei_histogram_t *hist = &s_histograms[s];
+        for (int i = 0; i < SEI_METRICS_BUCKET_COUNT; i++) {
+            atomic_store_explicit(&hist->buckets[i], snapshot->buckets[s][i], memory_order_relaxed);
+        }
+        atomic_store_explicit(&hist->max_us, snapshot->max_us[s], memory_order_relaxed);
+        atomic_store_explicit(&hist->total_us, snapshot->total_us[s], memory_order_relaxed);
+    }
+    for (int e = 0; e < SEI_EVENT_COUNT; e++) {
+        atomic_store_explicit(&s_events[e], snapshot->events[e], memory_order_relaxed);
+    }
+}
@@ -0,0 +1,127 @@
+/* SEI Pipeline Metrics
+ * 
+ * Lock-free latency histograms and event counters for the SEI path, so the
+ * per-frame cost of the hook can be checked against the frame interval
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of latency histogram buckets (1-2-5 series from 1 us to 50 ms, plus overflow)
+#define SEI_METRICS_BUCKET_COUNT 17
+
+/**
+ * @brief Timed stages of the SEI pipeline
+ */
+typedef enum {
+    SEI_STAGE_HOOK_FRAME = 0,   /*!< Whole video_sei_hook_process_frame_desc call */
+    SEI_STAGE_NAL_INDEX,        /*!< Locating the insert position (nal_index_build) */
+    SEI_STAGE_SPLICE_BUILD,     /*!< Scheduling and copying SEI units into the block */
+    SEI_STAGE_FRAME_COPY,       /*!< Flattening the splice into the output buffer */
+    SEI_STAGE_NAL_ENCODE,       /*!< Encoding a message into a SEI NAL unit at enqueue */
+    SEI_STAGE_COUNT,
+} sei_metrics_stage_t;
+
+/**
+ * @brief Counted SEI pipeline events
+ */
+typedef enum {
+    SEI_EVENT_CHAIN_BUSY = 0,   /*!< Frame arrived while another was in the hook, passed through */
+    SEI_EVENT_LOW_HEAP_WIPE,    /*!< Every queue cleared because free heap was critically low */
+    SEI_EVENT_BULK_SHED,        /*!< Bulk messages dropped because free heap was low */
+    SEI_EVENT_DROPPED_OLDEST,   /*!< Oldest queued message evicted by a new one */
+    SEI_EVENT_DROPPED_NEW,      /*!< New message rejected because the queue was full */
+    SEI_EVENT_COUNT,
+} sei_metrics_event_t;
+
+/**
+ * @brief Latency summary of one stage
+ */
+typedef struct {
+    uint32_t count;             /*!< Number of samples */
+    uint32_t p50_us;            /*!< Median, as the upper bound of its bucket */
+    uint32_t p99_us;            /*!< 99th percentile, as the upper bound of its bucket */
+    uint32_t max_us;            /*!< Largest sample */
+    uint64_t total_us;          /*!< Sum of all samples */
+} sei_metrics_summary_t;
+
+/**
+ * @brief Raw copy of every histogram and counter
+ */
+typedef struct {
+    uint32_t buckets[SEI_STAGE_COUNT][SEI_METRICS_BUCKET_COUNT];
+    uint32_t max_us[SEI_STAGE_COUNT];
+    uint64_t total_us[SEI_STAGE_COUNT];
+    uint32_t events[SEI_EVENT_COUNT];
+} sei_metrics_snapshot_t;
+
+/**
+ * @brief Record one latency sample
+ * 
+ * Safe to call from any task.
+ * 
+ * @param stage Pipeline stage
+ * @param elapsed_us Duration in microseconds
+ */
+void sei_metrics_record(sei_metrics_stage_t stage, uint32_t elapsed_us);
+
+/**
+ * @brief Count one pipeline event
+ * 
+ * @param event Event to count
+ */
+void sei_metrics_count(sei_metrics_event_t event);
+
+/**
+ * @brief Summarize the latency histogram of a stage
+ * 
+ * @param stage Pipeline stage
+ * @param summary Pointer to store the summary
+ */
+void sei_metrics_get_summary(sei_metrics_stage_t stage, sei_metrics_summary_t *summary);
+
+/**
+ * @brief Get the number of times an event occurred
+ * 
+ * @param event Event
+ * @return Event count since boot or the last reset
+ */
+uint32_t sei_metrics_get_count(sei_metrics_event_t event);
+
+/**
+ * @brief Get the display name of a stage or event
+ */
+const char *sei_metrics_stage_name(sei_metrics_stage_t stage);
+const char *sei_metrics_event_name(sei_metrics_event_t event);
+
+/**
+ * @brief Clear all histograms and counters
+ */
+void sei_metrics_reset(void);
+
+/**
+ * @brief Copy all histograms and counters
+ * 
+ * @param snapshot Pointer to store the copy
+ */
+void sei_metrics_save(sei_metrics_snapshot_t *snapshot);
+
+/**
+ * @brief Overwrite all histograms and counters with a saved copy
+ * 
+ * Samples recorded since the copy was taken are lost.
+ * 
+ * @param snapshot Copy from sei_metrics_save
+ */
+void sei_metrics_restore(const sei_metrics_snapshot_t *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
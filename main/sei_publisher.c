@@ -6,11 +6,19 @@
  */
 
 #include "sei_publisher.h"
+#include "sei_ring.h"
+#include "video_frame_pool.h"
+#include "sei_tlv.h"
+#include "sei_metrics.h"
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <stdio.h>
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "esp_rom_crc.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include <inttypes.h>
@@ -28,16 +36,133 @@ static const uint8_t SEND_SEI_UUID[16] = {
     0x81, 0x92, 0xA3, 0xB4, 0xC5, 0xD6, 0xE7, 0xF8
 };
 
+// UUID for fragments of larger payloads (3f8a2b1c-4d5e-6f70-8192-a3b4c5d6e702)
+static const uint8_t SEI_FRAGMENT_UUID[16] = {
+    0x3F, 0x8A, 0x2B, 0x1C, 0x4D, 0x5E, 0x6F, 0x70,
+    0x81, 0x92, 0xA3, 0xB4, 0xC5, 0xD6, 0xE7, 0x02
+};
+
+#define SEI_FRAGMENT_VERSION 1
+
+// UUID for the per-frame timing message (3f8a2b1c-4d5e-6f70-8192-a3b4c5d6e703)
+static const uint8_t SEI_TIMING_UUID[16] = {
+    0x3F, 0x8A, 0x2B, 0x1C, 0x4D, 0x5E, 0x6F, 0x70,
+    0x81, 0x92, 0xA3, 0xB4, 0xC5, 0xD6, 0xE7, 0x03
+};
+
+#define SEI_TIMING_VERSION 1
+
+_Static_assert(SEI_MAX_FRAGMENTS <= SEI_MAX_QUEUE_SIZE, "a fragmented message must fit in one queue");
+_Static_assert(SEI_TIMING_PAYLOAD_SIZE <= SEI_MAX_PAYLOAD_SIZE, "timing message must fit in one SEI message");
+_Static_assert(SEI_TIMING_MAX_ENTRIES <= 255, "timing entry count is one byte");
+
+// Bytes of an encoded SEI NAL around its sei_message(): start code + NAL header, trailing bits
+#define SEI_NAL_PREFIX_SIZE 5
+#define SEI_NAL_TRAILER_SIZE 1
+#define SEI_NO_BATCH SIZE_MAX
+
+// Topics are triple-buffered: one buffer being written, one latest, one being sent
+#define SEI_TOPIC_BUFFERS 3
+#define SEI_TOPIC_INDEX_MASK 0x3u
+#define SEI_TOPIC_DIRTY 0x4u
+
+_Static_assert(SEI_MAX_TOPICS <= 32, "topics sent per frame are tracked in a 32-bit mask");
+
+// Free heap below which bulk messages are shed, and below which everything is dropped
+#define SEI_LOW_HEAP_THRESHOLD 100000
+#define SEI_CRITICAL_HEAP_THRESHOLD 50000
+
+#define SEI_ALL_PRIORITIES ((1u << SEI_PRIORITY_COUNT) - 1)
+
+// Message slab: ring slots of every class, the sticky message store, then topic buffers
+#define SEI_STICKY_SLAB_OFFSET (SEI_PRIORITY_COUNT * SEI_RING_SLAB_SIZE)
+#define SEI_TOPIC_SLAB_OFFSET (SEI_STICKY_SLAB_OFFSET + SEI_MAX_STICKY_MESSAGES * SEI_MAX_NAL_SIZE)
+#define SEI_PUBLISHER_SLAB_SIZE (SEI_TOPIC_SLAB_OFFSET + SEI_MAX_TOPICS * SEI_TOPIC_BUFFERS * SEI_MAX_NAL_SIZE)
+
+/**
+ * @brief Claimed message that still has copies to send
+ */
+typedef struct {
+    uint32_t pos;               // Claimed ring position
+    int remaining;              // Copies still to send
+} sei_active_msg_t;
+
+/**
+ * @brief Message ring and schedule of one priority class
+ */
+typedef struct {
+    sei_ring_t ring;            // Lock-free message ring, producers never block the video thread
+    sei_active_msg_t active[SEI_MAX_QUEUE_SIZE]; // Claimed messages, owned by the video thread
+    int active_count;
+} sei_class_queue_t;
+
+/**
+ * @brief Latest-value-wins topic
+ *
+ * Producers (serialized by topic_lock) encode into the back buffer and swap
+ * it in as the latest value; the video thread swaps the latest value out as
+ * its front buffer without ever blocking. A newer value replaces the one
+ * being repeated instead of taking another queue slot.
+ */
+typedef struct {
+    char name[SEI_MAX_TOPIC_LEN];
+    sei_message_t buffers[SEI_TOPIC_BUFFERS];
+    _Atomic uint32_t latest;    // Latest buffer index, SEI_TOPIC_DIRTY if not yet taken
+    uint8_t back;               // Buffer producers write next, owned under topic_lock
+    
+    // Owned by the video thread
+    uint8_t front;              // Buffer being sent
+    bool has_value;             // Front buffer holds a live value
+    int remaining;              // Copies of the front buffer still to send
+} sei_topic_t;
+
 /**
  * @brief SEI publisher internal structure
  */
 typedef struct sei_publisher_s {
-    int max_retry_attempts;
-    sei_message_t message_queue[SEI_MAX_QUEUE_SIZE];
-    int queue_head;
-    int queue_tail;
-    int queue_count;
-    SemaphoreHandle_t mutex;
+    sei_publisher_config_t config;
+    uint8_t uuid[16];           // Copy of config.uuid
+    sei_class_queue_t queues[SEI_PRIORITY_COUNT];
+    uint8_t *message_slab;      // Encoded NAL storage for ring slots, sticky messages and topics
+    uint8_t *sei_block;         // Encoded SEI NAL units for the frame being spliced
+    size_t sei_block_len;
+    size_t batch_start;         // Offset of the open batched NAL in sei_block, SEI_NO_BATCH if none
+    atomic_bool clear_requested; // Set by sei_publisher_clear_queue, handled on the video thread
+    _Atomic int scheduled_messages; // Claimed messages with copies left, published by the video thread
+    _Atomic uint32_t scheduled_topics; // Topics with copies left, one bit each, published by the video thread
+    _Atomic size_t frame_byte_budget; // Current budgets, start from the config and may change at runtime
+    _Atomic size_t bulk_byte_budget;
+    
+    // Scheduler state, owned by the video thread
+    uint8_t *sticky_nal[SEI_MAX_STICKY_MESSAGES];
+    size_t sticky_size[SEI_MAX_STICKY_MESSAGES];
+    uint32_t sticky_timestamp[SEI_MAX_STICKY_MESSAGES];
+    int sticky_count;
+    int sticky_next;            // Sticky entry replaced next when the store is full
+    
+    // Topics; entries below topic_count are initialized and never removed
+    sei_topic_t topics[SEI_MAX_TOPICS];
+    _Atomic int topic_count;
+    SemaphoreHandle_t topic_lock; // Serializes topic producers, never taken by the video thread
+    
+    _Atomic uint32_t next_fragment_id; // Message id of the next fragmented payload
+    
+    // Timing of the frame being spliced, owned by the video thread
+    bool frame_has_pts;
+    bool frame_timed;           // The block ends with a timing message, so it holds at most SEI_TIMING_MAX_ENTRIES units
+    uint32_t frame_pts;
+    uint32_t frame_time_ms;     // When the frame was spliced
+    uint16_t timing_latency[SEI_TIMING_MAX_ENTRIES]; // Enqueue-to-insert latency of each message in the block
+    int timing_count;
+    uint8_t timing_nal[SEI_TIMING_NAL_SIZE];
+    
+    // Copies left before the last splice, restored if it is cancelled
+    bool splice_pending;
+    int saved_remaining[SEI_PRIORITY_COUNT][SEI_MAX_QUEUE_SIZE];
+    int saved_topic_remaining[SEI_MAX_TOPICS];
+    
+    _Atomic uint32_t last_pts;  // PTS of the last frame spliced with one, for producers targeting a PTS
+    atomic_bool has_last_pts;
 } sei_publisher_t;
 
 /**
@@ -82,28 +207,19 @@ static size_t create_header(const uint8_t *uuid, size_t payload_length, uint8_t
 }
 
 /**
- * @brief Apply emulation prevention to avoid start code conflicts
+ * @brief Append bytes with emulation prevention to avoid start code conflicts
+ * 
+ * Works on the bytes already written to output, so a NAL unit can be
+ * emulation-prevented piece by piece directly into its final location.
  */
-static size_t do_emulation_prevention(const uint8_t *input, size_t input_size, uint8_t *output) {
-    size_t output_pos = 0;
-    
-    // Copy start code (first 4 bytes) as-is without emulation prevention
-    size_t start_bytes = (input_size >= 4) ? 4 : input_size;
-    for (size_t i = 0; i < start_bytes; i++) {
-        output[output_pos++] = input[i];
-    }
-    
-    if (input_size <= 4) {
-        return output_pos;
-    }
-    
-    // Process remaining bytes with emulation prevention (skip start code)
-    for (size_t i = 4; i < input_size; i++) {
+static size_t append_emulation_prevented(const uint8_t *input, size_t input_size,
+                                         uint8_t *output, size_t output_pos) {
+    for (size_t i = 0; i < input_size; i++) {
         // Check for potential start code emulation in payload data
         if (output_pos >= 2 && 
             output[output_pos - 2] == 0x00 && 
             output[output_pos - 1] == 0x00 && 
-            (input[i] == 0x00 || input[i] == 0x01 || input[i] == 0x02 || input[i] == 0x03)) {
+            input[i] <= 0x03) {
             // Insert emulation prevention byte
             output[output_pos++] = 0x03;
         }
@@ -115,111 +231,129 @@ static size_t do_emulation_prevention(const uint8_t *input, size_t input_size, u
 
 /**
  * @brief Create a complete SEI NAL unit
+ * 
+ * Writes straight into output, which must hold SEI_MAX_NAL_SIZE bytes.
  */
 static size_t create_sei_nal_unit(const uint8_t *uuid, const uint8_t *payload, size_t payload_size, uint8_t *output) {
-    uint8_t temp_buffer[SEI_MAX_PAYLOAD_SIZE + 100]; // Extra space for header and termination
-    size_t pos = 0;
+    uint8_t header[32];
+    size_t header_size = create_header(uuid, payload_size, header);
     
-    // Create header
-    pos += create_header(uuid, payload_size, &temp_buffer[pos]);
-    
-    // Add payload
-    memcpy(&temp_buffer[pos], payload, payload_size);
-    pos += payload_size;
+    // Copy start code (first 4 bytes) as-is, everything after it is emulation-prevented
+    memcpy(output, header, 4);
+    size_t pos = append_emulation_prevented(header + 4, header_size - 4, output, 4);
+    pos = append_emulation_prevented(payload, payload_size, output, pos);
     
     // Add termination
-    temp_buffer[pos++] = SEI_PAYLOAD_TERMINATION;
-    
-    // Apply emulation prevention
-    size_t final_size = do_emulation_prevention(temp_buffer, pos, output);
+    const uint8_t termination = SEI_PAYLOAD_TERMINATION;
+    pos = append_emulation_prevented(&termination, 1, output, pos);
     
     // Debug: Log the created SEI NAL unit
-    ESP_LOGV(TAG, "Created SEI NAL unit: %zu bytes", final_size);
+    ESP_LOGV(TAG, "Created SEI NAL unit: %zu bytes", pos);
     
-    return final_size;
+    return pos;
 }
 
-/**
- * @brief Find position to insert SEI NAL unit (before first video slice)
- */
-static int find_insert_position(const uint8_t *frame_data, size_t frame_size) {
-    for (size_t i = 0; i < frame_size - 4; i++) {
-        // Check for 3-byte start code
-        if (frame_data[i] == 0x00 && frame_data[i + 1] == 0x00 && frame_data[i + 2] == 0x01) {
-            uint8_t nal_unit_type = frame_data[i + 3] & 0x1F;
-            // Insert before video slice NAL units (types 1-5)
-            if (nal_unit_type >= 1 && nal_unit_type <= 5) {
-                return i;
-            }
-            i += 3;
-        }
-        // Check for 4-byte start code
-        else if (i < frame_size - 5 && 
-                 frame_data[i] == 0x00 && frame_data[i + 1] == 0x00 && 
-                 frame_data[i + 2] == 0x00 && frame_data[i + 3] == 0x01) {
-            uint8_t nal_unit_type = frame_data[i + 4] & 0x1F;
-            // Insert before video slice NAL units (types 1-5)
-            if (nal_unit_type >= 1 && nal_unit_type <= 5) {
-                return i;
-            }
-            i += 4;
-        }
-    }
-    return -1; // Not found, will prepend to beginning
-}
+// Public API implementations
 
 /**
- * @brief Insert SEI unit into frame data at optimal position
+ * @brief Allocate the message slab in the requested memory
  */
-static bool insert_sei_unit(const uint8_t *frame_data, size_t frame_size, 
-                           const uint8_t *sei_unit, size_t sei_size,
-                           uint8_t **output_data, size_t *output_size) {
-    int insert_position = find_insert_position(frame_data, frame_size);
-    
-    *output_size = frame_size + sei_size;
-    *output_data = malloc(*output_size);
-    if (!*output_data) {
-        ESP_LOGE(TAG, "Failed to allocate memory for modified frame");
-        return false;
+static uint8_t *alloc_message_slab(sei_slab_location_t location) {
+    switch (location) {
+    case SEI_SLAB_INTERNAL:
+        return heap_caps_calloc(1, SEI_PUBLISHER_SLAB_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    case SEI_SLAB_PSRAM:
+        return heap_caps_calloc(1, SEI_PUBLISHER_SLAB_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    case SEI_SLAB_AUTO:
+    default:
+        return heap_caps_calloc_prefer(1, SEI_PUBLISHER_SLAB_SIZE, 2,
+                                       MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+                                       MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
     }
-    
-    if (insert_position >= 0) {
-        // Insert SEI unit before the found NAL unit
-        memcpy(*output_data, frame_data, insert_position);
-        memcpy(*output_data + insert_position, sei_unit, sei_size);
-        memcpy(*output_data + insert_position + sei_size, 
-               frame_data + insert_position, frame_size - insert_position);
-    } else {
-        // Fallback: prepend to beginning of frame
-        memcpy(*output_data, sei_unit, sei_size);
-        memcpy(*output_data + sei_size, frame_data, frame_size);
-    }
-    
-    return true;
 }
 
-// Public API implementations
-
 sei_publisher_handle_t sei_publisher_init(int max_retry_attempts) {
-    sei_publisher_t *publisher = calloc(1, sizeof(sei_publisher_t));
+    sei_publisher_config_t config = SEI_PUBLISHER_DEFAULT_CONFIG();
+    config.max_retry_attempts = max_retry_attempts;
+    return sei_publisher_init_with_config(&config);
+}
+
+sei_publisher_handle_t sei_publisher_init_with_config(const sei_publisher_config_t *config) {
+    if (!config) return NULL;
+    
+    // Keep the ring in internal RAM, atomics are not reliable on PSRAM
+    sei_publisher_t *publisher = heap_caps_calloc(1, sizeof(sei_publisher_t),
+                                                  MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
     if (!publisher) {
         ESP_LOGE(TAG, "Failed to allocate SEI publisher");
         return NULL;
     }
     
-    publisher->max_retry_attempts = max_retry_attempts;
-    publisher->queue_head = 0;
-    publisher->queue_tail = 0;
-    publisher->queue_count = 0;
+    publisher->config = *config;
+    if (config->uuid) {
+        // The caller's UUID may not outlive the call
+        memcpy(publisher->uuid, config->uuid, sizeof(publisher->uuid));
+        publisher->config.uuid = publisher->uuid;
+    }
     
-    publisher->mutex = xSemaphoreCreateMutex();
-    if (!publisher->mutex) {
-        ESP_LOGE(TAG, "Failed to create mutex");
-        free(publisher);
+    // Every encoded message lives in this slab; enqueue and dequeue never touch the heap
+    publisher->message_slab = alloc_message_slab(config->slab_location);
+    if (!publisher->message_slab) {
+        ESP_LOGE(TAG, "Failed to allocate message slab (%d bytes)", SEI_PUBLISHER_SLAB_SIZE);
+        heap_caps_free(publisher);
+        return NULL;
+    }
+    for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+        sei_ring_init(&publisher->queues[c].ring, publisher->message_slab + c * SEI_RING_SLAB_SIZE);
+    }
+    for (int i = 0; i < SEI_MAX_STICKY_MESSAGES; i++) {
+        publisher->sticky_nal[i] = publisher->message_slab + SEI_STICKY_SLAB_OFFSET + i * SEI_MAX_NAL_SIZE;
+    }
+    for (int t = 0; t < SEI_MAX_TOPICS; t++) {
+        sei_topic_t *topic = &publisher->topics[t];
+        for (int b = 0; b < SEI_TOPIC_BUFFERS; b++) {
+            topic->buffers[b].nal = publisher->message_slab + SEI_TOPIC_SLAB_OFFSET +
+                                    (t * SEI_TOPIC_BUFFERS + b) * SEI_MAX_NAL_SIZE;
+        }
+        topic->front = 0;
+        atomic_init(&topic->latest, 1);
+        topic->back = 2;
+    }
+    atomic_init(&publisher->topic_count, 0);
+    atomic_init(&publisher->clear_requested, false);
+    atomic_init(&publisher->next_fragment_id, 0);
+    atomic_init(&publisher->last_pts, 0);
+    atomic_init(&publisher->has_last_pts, false);
+    atomic_init(&publisher->frame_byte_budget, config->frame_byte_budget);
+    atomic_init(&publisher->bulk_byte_budget, config->bulk_byte_budget);
+    
+    publisher->topic_lock = xSemaphoreCreateMutex();
+    if (!publisher->topic_lock) {
+        ESP_LOGE(TAG, "Failed to create topic mutex");
+        heap_caps_free(publisher->message_slab);
+        heap_caps_free(publisher);
         return NULL;
     }
     
-    ESP_LOGI(TAG, "📡 SEI Publisher initialized with UUID: 3f8a2b1c-4d5e-6f70-8192-a3b4c5d6e7f8");
+    // SEI block is reused for every frame; prefer PSRAM to keep internal RAM free
+    publisher->sei_block = heap_caps_malloc_prefer(SEI_BLOCK_CAPACITY, 2,
+                                                   MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+    if (!publisher->sei_block) {
+        ESP_LOGE(TAG, "Failed to allocate SEI block (%d bytes)", SEI_BLOCK_CAPACITY);
+        vSemaphoreDelete(publisher->topic_lock);
+        heap_caps_free(publisher->message_slab);
+        heap_caps_free(publisher);
+        return NULL;
+    }
+    
+    if (config->uuid) {
+        const uint8_t *u = publisher->uuid;
+        ESP_LOGI(TAG, "📡 SEI Publisher initialized with UUID: %02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-"
+                 "%02x%02x%02x%02x%02x%02x", u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7],
+                 u[8], u[9], u[10], u[11], u[12], u[13], u[14], u[15]);
+    } else {
+        ESP_LOGI(TAG, "📡 SEI Publisher initialized with UUID: 3f8a2b1c-4d5e-6f70-8192-a3b4c5d6e7f8");
+    }
     return publisher;
 }
 
@@ -228,18 +362,31 @@ void sei_publisher_deinit(sei_publisher_handle_t handle) {
     
     sei_publisher_t *publisher = (sei_publisher_t *)handle;
     
-    // Clear queue and free any allocated payloads
+    // Drop any queued messages and free the claimed ones
     sei_publisher_clear_queue(handle);
-    
-    if (publisher->mutex) {
-        vSemaphoreDelete(publisher->mutex);
+    for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+        sei_class_queue_t *queue = &publisher->queues[c];
+        for (int i = 0; i < queue->active_count; i++) {
+            sei_ring_release(&queue->ring, queue->active[i].pos);
+        }
     }
     
-    free(publisher);
+    vSemaphoreDelete(publisher->topic_lock);
+    heap_caps_free(publisher->sei_block);
+    heap_caps_free(publisher->message_slab);
+    heap_caps_free(publisher);
     ESP_LOGI(TAG, "📡 SEI Publisher deinitialized");
 }
 
 bool sei_publisher_publish_text(sei_publisher_handle_t handle, const char *text, int repeat_count) {
+    sei_publish_opts_t opts = {
+        .repeat_count = repeat_count,
+    };
+    return sei_publisher_publish_text_opts(handle, text, &opts);
+}
+
+bool sei_publisher_publish_text_opts(sei_publisher_handle_t handle, const char *text,
+                                     const sei_publish_opts_t *opts) {
     if (!handle || !text) return false;
     
     // Create JSON payload with timestamp
@@ -255,198 +402,965 @@ bool sei_publisher_publish_text(sei_publisher_handle_t handle, const char *text,
         json_len = sizeof(json_buffer) - 1;
     }
     
-    return sei_publisher_publish_json(handle, json_buffer, repeat_count);
+    return sei_publisher_publish(handle, (const uint8_t *)json_buffer, json_len, opts);
 }
 
 bool sei_publisher_publish_json(sei_publisher_handle_t handle, const char *json_str, int repeat_count) {
     if (!handle || !json_str) return false;
     
-    sei_publisher_t *publisher = (sei_publisher_t *)handle;
-    size_t json_len = strlen(json_str);
+    sei_publish_opts_t opts = {
+        .repeat_count = repeat_count,
+    };
+    return sei_publisher_publish(handle, (const uint8_t *)json_str, strlen(json_str), &opts);
+}
+
+/**
+ * @brief Encode a payload and its options into a message slot
+ */
+static void encode_message(sei_message_t *msg, const uint8_t *uuid, const uint8_t *payload,
+                           size_t payload_size, const sei_publish_opts_t *opts) {
+    int64_t encode_start = esp_timer_get_time();
+    msg->nal_size = create_sei_nal_unit(uuid, payload, payload_size, msg->nal);
+    sei_metrics_record(SEI_STAGE_NAL_ENCODE, (uint32_t)(esp_timer_get_time() - encode_start));
+    msg->payload_size = payload_size;
+    msg->repeat_count = opts->repeat_count > 0 ? opts->repeat_count : SEI_DEFAULT_REPEAT_COUNT;
+    msg->timestamp = esp_timer_get_time() / 1000;
+    msg->has_target_pts = opts->has_target_pts;
+    msg->target_pts = opts->target_pts;
+    msg->flags = opts->sticky ? SEI_MSG_FLAG_STICKY : 0;
+    msg->priority = opts->priority;
+    msg->on_sent = opts->on_sent;
+    msg->on_sent_ctx = opts->on_sent_ctx;
+    msg->on_sent_tag = opts->on_sent_tag;
+}
+
+/**
+ * @brief UUID a payload in the given format is sent with
+ *
+ * A publisher with its own UUID sends everything under it; the format is
+ * then up to the publisher and its viewers.
+ */
+static const uint8_t *payload_uuid(const sei_publisher_t *publisher, sei_payload_format_t format) {
+    if (publisher->config.uuid) {
+        return publisher->config.uuid;
+    }
+    return format == SEI_PAYLOAD_TLV ? SEI_TLV_UUID_V1 : SEND_SEI_UUID;
+}
+
+/**
+ * @brief Find a topic by name, adding it if there is room
+ *
+ * Must be called with topic_lock held.
+ */
+static sei_topic_t *find_or_add_topic(sei_publisher_t *publisher, const char *name) {
+    int count = atomic_load_explicit(&publisher->topic_count, memory_order_relaxed);
+    for (int t = 0; t < count; t++) {
+        // Names are stored truncated, so compare the truncated form
+        if (strncmp(publisher->topics[t].name, name, SEI_MAX_TOPIC_LEN - 1) == 0) {
+            return &publisher->topics[t];
+        }
+    }
     
-    if (json_len > SEI_MAX_PAYLOAD_SIZE) {
-        ESP_LOGE(TAG, "JSON payload too large: %zu bytes (max %d)", json_len, SEI_MAX_PAYLOAD_SIZE);
+    if (count >= SEI_MAX_TOPICS) {
+        return NULL;
+    }
+    sei_topic_t *topic = &publisher->topics[count];
+    strncpy(topic->name, name, SEI_MAX_TOPIC_LEN - 1);
+    topic->name[SEI_MAX_TOPIC_LEN - 1] = '\0';
+    
+    // Publish the entry only once it is initialized
+    atomic_store_explicit(&publisher->topic_count, count + 1, memory_order_release);
+    return topic;
+}
+
+/**
+ * @brief Replace the latest value of a topic
+ *
+ * @return false if the topic table is full and the message should be queued instead
+ */
+static bool publish_topic(sei_publisher_t *publisher, const uint8_t *payload, size_t payload_size,
+                          const sei_publish_opts_t *opts) {
+    if (xSemaphoreTake(publisher->topic_lock, pdMS_TO_TICKS(100)) != pdTRUE) {
+        ESP_LOGW(TAG, "Topic lock busy, queueing \"%s\" message instead", opts->topic);
         return false;
     }
     
-    if (xSemaphoreTake(publisher->mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire mutex");
+    sei_topic_t *topic = find_or_add_topic(publisher, opts->topic);
+    if (!topic) {
+        xSemaphoreGive(publisher->topic_lock);
+        ESP_LOGW(TAG, "Topic table full (%d), queueing \"%s\" message instead", SEI_MAX_TOPICS, opts->topic);
         return false;
     }
     
-    // Check if queue is full
-    if (publisher->queue_count >= SEI_MAX_QUEUE_SIZE) {
-        ESP_LOGW(TAG, "SEI message queue full, dropping oldest message");
-        // Free the oldest message payload
-        if (publisher->message_queue[publisher->queue_head].payload) {
-            free(publisher->message_queue[publisher->queue_head].payload);
+    sei_message_t *msg = &topic->buffers[topic->back];
+    encode_message(msg, payload_uuid(publisher, opts->format), payload, payload_size, opts);
+    
+    // Swap the new value in; whatever was latest becomes the next back buffer
+    uint32_t previous = atomic_exchange_explicit(&topic->latest, topic->back | SEI_TOPIC_DIRTY,
+                                                 memory_order_acq_rel);
+    topic->back = previous & SEI_TOPIC_INDEX_MASK;
+    xSemaphoreGive(publisher->topic_lock);
+    
+    ESP_LOGD(TAG, "📡 Updated SEI topic \"%s\": %zu bytes (%zu byte NAL), repeat: %d%s%s",
+             opts->topic, payload_size, msg->nal_size, msg->repeat_count,
+             opts->sticky ? ", sticky" : "", (previous & SEI_TOPIC_DIRTY) ? ", replaced unsent value" : "");
+    return true;
+}
+
+/**
+ * @brief Encode a message into the ring of its priority class
+ * 
+ * @param make_room Drop the oldest queued message if the ring is full
+ * @param nal_size Pointer to store the encoded NAL size, may be NULL
+ */
+static bool enqueue_message(sei_publisher_t *publisher, const uint8_t *uuid, const uint8_t *payload,
+                            size_t payload_size, const sei_publish_opts_t *opts, bool make_room,
+                            size_t *nal_size) {
+    // Classes have separate rings, so a flood of one never evicts the other
+    sei_ring_t *ring = &publisher->queues[opts->priority].ring;
+    uint32_t pos;
+    sei_message_t *msg = sei_ring_reserve(ring, &pos);
+    if (!msg && make_room) {
+        // Queue is full, make room by dropping the oldest committed message
+        if (sei_ring_drop_oldest(ring)) {
+            ESP_LOGW(TAG, "SEI message queue full, dropping oldest message");
+            sei_metrics_count(SEI_EVENT_DROPPED_OLDEST);
+            msg = sei_ring_reserve(ring, &pos);
         }
-        publisher->queue_head = (publisher->queue_head + 1) % SEI_MAX_QUEUE_SIZE;
-        publisher->queue_count--;
+    }
+    if (!msg) {
+        ESP_LOGW(TAG, "SEI message queue full, dropping new message");
+        sei_metrics_count(SEI_EVENT_DROPPED_NEW);
+        return false;
     }
     
-    // Allocate and copy payload
-    sei_message_t *msg = &publisher->message_queue[publisher->queue_tail];
-    
-    // Add extra byte for null terminator safety
-    msg->payload = malloc(json_len + 1);
-    if (!msg->payload) {
-        ESP_LOGE(TAG, "Failed to allocate payload memory");
-        xSemaphoreGive(publisher->mutex);
+    // Encode the complete NAL unit on the producer's thread, straight into
+    // the slot, so the video thread only has to copy it
+    encode_message(msg, uuid, payload, payload_size, opts);
+    if (nal_size) {
+        *nal_size = msg->nal_size;
+    }
+    sei_ring_commit(ring, pos);
+    return true;
+}
+
+static void put_be16(uint8_t *out, uint16_t value) {
+    out[0] = value >> 8;
+    out[1] = value & 0xFF;
+}
+
+static void put_be32(uint8_t *out, uint32_t value) {
+    put_be16(out, value >> 16);
+    put_be16(out + 2, value & 0xFFFF);
+}
+
+/**
+ * @brief Split a payload into fragments and queue all of them
+ * 
+ * Each fragment carries the message id, its index, the fragment count, the
+ * total length and a CRC-32 of the whole payload, so viewers can reassemble
+ * fragments arriving over several frames and discard incomplete messages.
+ */
+static bool publish_fragmented(sei_publisher_t *publisher, const uint8_t *payload, size_t payload_size,
+                               const sei_publish_opts_t *opts) {
+    if (payload_size > SEI_MAX_FRAGMENTED_PAYLOAD_SIZE) {
+        ESP_LOGE(TAG, "SEI payload too large: %zu bytes (max %d)", payload_size, SEI_MAX_FRAGMENTED_PAYLOAD_SIZE);
         return false;
     }
     
-    // Clear the allocated memory
-    memset(msg->payload, 0, json_len + 1);
+    if (opts->topic || opts->sticky || opts->on_sent) {
+        ESP_LOGE(TAG, "Payloads over %d bytes can't be sent as topics, sticky or with a sent callback",
+                 SEI_MAX_PAYLOAD_SIZE);
+        return false;
+    }
     
-    memcpy(msg->payload, json_str, json_len);
-    msg->payload_size = json_len;
-    msg->repeat_count = repeat_count > 0 ? repeat_count : SEI_DEFAULT_REPEAT_COUNT;
-    msg->timestamp = esp_timer_get_time() / 1000;
+    if (publisher->config.uuid) {
+        ESP_LOGE(TAG, "Payloads over %d bytes can't be sent by a publisher with its own UUID", SEI_MAX_PAYLOAD_SIZE);
+        return false;
+    }
     
-    publisher->queue_tail = (publisher->queue_tail + 1) % SEI_MAX_QUEUE_SIZE;
-    publisher->queue_count++;
+    // Fragments never make room by evicting each other, so only start
+    // when the whole message fits
+    int count = (payload_size + SEI_FRAGMENT_CHUNK_SIZE - 1) / SEI_FRAGMENT_CHUNK_SIZE;
+    sei_ring_t *ring = &publisher->queues[opts->priority].ring;
+    if (SEI_MAX_QUEUE_SIZE - sei_ring_count(ring) < count) {
+        ESP_LOGW(TAG, "SEI message queue too full for %d fragments, dropping new message", count);
+        sei_metrics_count(SEI_EVENT_DROPPED_NEW);
+        return false;
+    }
     
-    ESP_LOGI(TAG, "📡 Queued SEI message: %zu bytes, queue: %d/%d, repeat: %d", 
-             json_len, publisher->queue_count, SEI_MAX_QUEUE_SIZE, msg->repeat_count);
+    uint16_t msg_id = (uint16_t)atomic_fetch_add_explicit(&publisher->next_fragment_id, 1, memory_order_relaxed);
+    uint32_t crc = esp_rom_crc32_le(0, payload, payload_size);
+    uint8_t fragment[SEI_MAX_PAYLOAD_SIZE];
+    fragment[0] = SEI_FRAGMENT_VERSION;
+    fragment[1] = (uint8_t)opts->format;
+    put_be16(fragment + 2, msg_id);
+    put_be16(fragment + 6, (uint16_t)count);
+    put_be32(fragment + 8, (uint32_t)payload_size);
+    put_be32(fragment + 12, crc);
+    
+    for (int i = 0; i < count; i++) {
+        size_t offset = (size_t)i * SEI_FRAGMENT_CHUNK_SIZE;
+        size_t chunk_size = payload_size - offset < SEI_FRAGMENT_CHUNK_SIZE ?
+                            payload_size - offset : SEI_FRAGMENT_CHUNK_SIZE;
+        put_be16(fragment + 4, (uint16_t)i);
+        memcpy(fragment + SEI_FRAGMENT_HEADER_SIZE, payload + offset, chunk_size);
+        if (!enqueue_message(publisher, SEI_FRAGMENT_UUID, fragment, SEI_FRAGMENT_HEADER_SIZE + chunk_size,
+                             opts, false, NULL)) {
+            // Fragments already queued still go out, viewers drop the incomplete message
+            ESP_LOGW(TAG, "SEI queue filled up after %d of %d fragments of message %u", i, count, msg_id);
+            return false;
+        }
+    }
     
-    xSemaphoreGive(publisher->mutex);
+    ESP_LOGD(TAG, "📡 Queued fragmented SEI message %u: %zu bytes in %d fragments, queue: %d/%d, repeat: %d%s",
+             msg_id, payload_size, count, sei_ring_count(ring), SEI_MAX_QUEUE_SIZE,
+             opts->repeat_count > 0 ? opts->repeat_count : SEI_DEFAULT_REPEAT_COUNT,
+             opts->priority == SEI_PRIORITY_BULK ? ", bulk" : "");
     return true;
 }
 
-bool sei_publisher_process_frame(sei_publisher_handle_t handle, 
-                                const uint8_t *frame_data, size_t frame_size,
-                                uint8_t **output_data, size_t *output_size) {
-    if (!handle || !frame_data || !output_data || !output_size) return false;
+bool sei_publisher_publish(sei_publisher_handle_t handle, const uint8_t *payload, size_t payload_size,
+                           const sei_publish_opts_t *opts) {
+    if (!handle || !payload) return false;
     
     sei_publisher_t *publisher = (sei_publisher_t *)handle;
+    sei_publish_opts_t default_opts = { 0 };
+    if (!opts) {
+        opts = &default_opts;
+    }
     
-
+    if (opts->priority >= SEI_PRIORITY_COUNT) {
+        ESP_LOGE(TAG, "Invalid SEI priority %d", opts->priority);
+        return false;
+    }
     
-    if (xSemaphoreTake(publisher->mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        // If we can't get the mutex quickly, just return original frame
-        *output_size = frame_size;
-        *output_data = malloc(frame_size);
-        if (*output_data) {
-            memcpy(*output_data, frame_data, frame_size);
-            return true;
+    if (opts->topic && opts->on_sent) {
+        // A newer value may replace it before it is sent
+        ESP_LOGE(TAG, "Topic SEI messages can't have a sent callback");
+        return false;
+    }
+    
+    if (opts->has_target_pts) {
+        // Sticky copies go out on every keyframe, which can't honor a target
+        if (opts->sticky) {
+            ESP_LOGE(TAG, "Sticky SEI messages can't target a PTS");
+            return false;
         }
+        uint32_t last_pts;
+        if (sei_publisher_get_last_pts(handle, &last_pts) &&
+            (int32_t)(opts->target_pts - last_pts) > SEI_MAX_TARGET_AHEAD_MS) {
+            ESP_LOGE(TAG, "SEI target PTS %" PRIu32 " is more than %d ms ahead of %" PRIu32,
+                     opts->target_pts, SEI_MAX_TARGET_AHEAD_MS, last_pts);
+            return false;
+        }
+    }
+    
+    if (payload_size > SEI_MAX_PAYLOAD_SIZE) {
+        return publish_fragmented(publisher, payload, payload_size, opts);
+    }
+    
+    if (opts->topic && publish_topic(publisher, payload, payload_size, opts)) {
+        return true;
+    }
+    
+    size_t nal_size;
+    if (!enqueue_message(publisher, payload_uuid(publisher, opts->format), payload, payload_size, opts, true, &nal_size)) {
         return false;
     }
     
-    // If no messages queued, return original frame without copying
-    if (publisher->queue_count == 0) {
-        xSemaphoreGive(publisher->mutex);
-        // Don't allocate new memory, just return false to indicate no processing needed
-        *output_data = NULL;
-        *output_size = 0;
-        return false; // This will cause the caller to use the original frame
-    }
-    
-
-    
-    // Check if this is a keyframe (contains SPS/PPS/IDR) for logging purposes
-    bool is_keyframe = false;
-    if (frame_size >= 4) {
-        // Look for SPS (NAL type 7), PPS (NAL type 8), or IDR (NAL type 5)
-        for (size_t i = 0; i < frame_size - 4; i++) {
-            if ((frame_data[i] == 0x00 && frame_data[i+1] == 0x00 && frame_data[i+2] == 0x00 && frame_data[i+3] == 0x01) ||
-                (frame_data[i] == 0x00 && frame_data[i+1] == 0x00 && frame_data[i+2] == 0x01)) {
-                
-                int nal_start = (frame_data[i+2] == 0x01) ? i+3 : i+4;
-                if (nal_start < frame_size) {
-                    uint8_t nal_type = frame_data[nal_start] & 0x1F;
-                    if (nal_type == 5 || nal_type == 7 || nal_type == 8) { // IDR, SPS, or PPS
-                        is_keyframe = true;
-                        break;
-                    }
-                }
+    ESP_LOGD(TAG, "📡 Queued SEI message: %zu bytes (%zu byte NAL), queue: %d/%d, repeat: %d%s%s", 
+             payload_size, nal_size, sei_ring_count(&publisher->queues[opts->priority].ring), SEI_MAX_QUEUE_SIZE,
+             opts->repeat_count > 0 ? opts->repeat_count : SEI_DEFAULT_REPEAT_COUNT,
+             opts->sticky ? ", sticky" : "",
+             opts->priority == SEI_PRIORITY_BULK ? ", bulk" : "");
+    return true;
+}
+
+/**
+ * @brief Drop every message the scheduler has claimed
+ */
+static int drop_active_messages(sei_class_queue_t *queue) {
+    int dropped = queue->active_count;
+    for (int i = 0; i < queue->active_count; i++) {
+        sei_ring_release(&queue->ring, queue->active[i].pos);
+    }
+    queue->active_count = 0;
+    return dropped;
+}
+
+/**
+ * @brief Keep a copy of a sticky message for future keyframes
+ */
+static void store_sticky_message(sei_publisher_t *publisher, const sei_message_t *msg) {
+    int slot;
+    if (publisher->sticky_count < SEI_MAX_STICKY_MESSAGES) {
+        slot = publisher->sticky_count++;
+    } else {
+        // Store is full, replace the oldest sticky message
+        slot = publisher->sticky_next;
+        publisher->sticky_next = (publisher->sticky_next + 1) % SEI_MAX_STICKY_MESSAGES;
+    }
+    memcpy(publisher->sticky_nal[slot], msg->nal, msg->nal_size);
+    publisher->sticky_size[slot] = msg->nal_size;
+    publisher->sticky_timestamp[slot] = msg->timestamp;
+}
+
+/**
+ * @brief Move newly committed messages from the ring into the schedule
+ */
+static void claim_pending_messages(sei_publisher_t *publisher, sei_class_queue_t *queue) {
+    int room = SEI_MAX_QUEUE_SIZE - queue->active_count;
+    uint32_t first_pos;
+    int claimed = sei_ring_claim(&queue->ring, room, &first_pos);
+    
+    for (int i = 0; i < claimed; i++) {
+        sei_message_t *msg = sei_ring_message(&queue->ring, first_pos + i);
+        if (msg->flags & SEI_MSG_FLAG_STICKY) {
+            store_sticky_message(publisher, msg);
+        }
+        queue->active[queue->active_count].pos = first_pos + i;
+        queue->active[queue->active_count].remaining = msg->repeat_count;
+        queue->active_count++;
+    }
+}
+
+/**
+ * @brief Hand fully sent messages back to producers, keep the rest in order
+ */
+static void release_sent_messages(sei_class_queue_t *queue) {
+    int kept = 0;
+    for (int m = 0; m < queue->active_count; m++) {
+        if (queue->active[m].remaining > 0) {
+            queue->active[kept++] = queue->active[m];
+        } else {
+            const sei_message_t *msg = sei_ring_message(&queue->ring, queue->active[m].pos);
+            if (msg->on_sent) {
+                msg->on_sent(msg->on_sent_ctx, msg->on_sent_tag);
             }
+            sei_ring_release(&queue->ring, queue->active[m].pos);
         }
     }
-    
-    // Check available memory before processing - be more conservative
-    size_t free_heap = esp_get_free_heap_size();
-    if (free_heap < 100000) { // Need at least 100KB free to safely process frames
-        // Clear the queue to prevent it from filling up during low memory
-        int cleared_count = publisher->queue_count;
-        while (publisher->queue_count > 0) {
-            sei_message_t *msg = &publisher->message_queue[publisher->queue_head];
-            if (msg->payload) {
-                free(msg->payload);
-                msg->payload = NULL;
+    queue->active_count = kept;
+}
+
+/**
+ * @brief Publish how much of the schedule is left, for producers asking for the queue size
+ */
+static void publish_schedule_size(sei_publisher_t *publisher) {
+    int messages = 0;
+    for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+        const sei_class_queue_t *queue = &publisher->queues[c];
+        for (int m = 0; m < queue->active_count; m++) {
+            if (queue->active[m].remaining > 0) {
+                messages++;
             }
-            publisher->queue_head = (publisher->queue_head + 1) % SEI_MAX_QUEUE_SIZE;
-            publisher->queue_count--;
+        }
+    }
+    uint32_t topics = 0;
+    int topic_count = atomic_load_explicit(&publisher->topic_count, memory_order_acquire);
+    for (int t = 0; t < topic_count; t++) {
+        if (publisher->topics[t].remaining > 0) {
+            topics |= 1u << t;
+        }
+    }
+    atomic_store_explicit(&publisher->scheduled_messages, messages, memory_order_relaxed);
+    atomic_store_explicit(&publisher->scheduled_topics, topics, memory_order_relaxed);
+}
+
+/**
+ * @brief Note the copies left of every scheduled message before a splice
+ */
+static void save_schedule(sei_publisher_t *publisher) {
+    for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+        const sei_class_queue_t *queue = &publisher->queues[c];
+        for (int m = 0; m < queue->active_count; m++) {
+            publisher->saved_remaining[c][m] = queue->active[m].remaining;
+        }
+    }
+    int topic_count = atomic_load_explicit(&publisher->topic_count, memory_order_acquire);
+    for (int t = 0; t < topic_count; t++) {
+        publisher->saved_topic_remaining[t] = publisher->topics[t].remaining;
+    }
+}
+
+/**
+ * @brief Settle the last splice: release its fully sent messages, or put its copies back
+ */
+static void finish_splice(sei_publisher_t *publisher, bool sent) {
+    if (!publisher->splice_pending) {
+        return;
+    }
+    publisher->splice_pending = false;
+    
+    if (sent) {
+        for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+            release_sent_messages(&publisher->queues[c]);
+        }
+        publish_schedule_size(publisher);
+        return;
+    }
+    // Nothing was claimed or dropped since save_schedule, so entries still line up
+    for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+        sei_class_queue_t *queue = &publisher->queues[c];
+        for (int m = 0; m < queue->active_count; m++) {
+            queue->active[m].remaining = publisher->saved_remaining[c][m];
+        }
+    }
+    int topic_count = atomic_load_explicit(&publisher->topic_count, memory_order_acquire);
+    for (int t = 0; t < topic_count; t++) {
+        publisher->topics[t].remaining = publisher->saved_topic_remaining[t];
+    }
+    publish_schedule_size(publisher);
+}
+
+/**
+ * @brief Drop everything queued and scheduled in one class
+ *
+ * @return Number of messages dropped
+ */
+static int drop_class(sei_class_queue_t *queue) {
+    return drop_active_messages(queue) + sei_ring_drain(&queue->ring);
+}
+
+/**
+ * @brief Check whether a message can join the open batched NAL unit
+ */
+static bool batch_has_room(const sei_publisher_t *publisher, size_t nal_size) {
+    if (publisher->batch_start == SEI_NO_BATCH) return false;
+    size_t batch_len = publisher->sei_block_len - publisher->batch_start;
+    return batch_len + nal_size - SEI_NAL_PREFIX_SIZE - SEI_NAL_TRAILER_SIZE <=
+           publisher->config.batch_max_nal_size;
+}
+
+/**
+ * @brief Bytes an encoded SEI NAL unit adds to the SEI block
+ */
+static size_t block_cost(const sei_publisher_t *publisher, size_t nal_size) {
+    if (batch_has_room(publisher, nal_size)) {
+        return nal_size - SEI_NAL_PREFIX_SIZE - SEI_NAL_TRAILER_SIZE;
+    }
+    return nal_size;
+}
+
+/**
+ * @brief Append copies of an encoded SEI NAL unit to the SEI block
+ *
+ * With batching enabled the sei_message() is moved into the open batched NAL
+ * unit instead, replacing that unit's trailing bits. Every sei_message()
+ * starts with its payload type (0x05), so concatenating already
+ * emulation-prevented messages can't form a start code and needs no second
+ * emulation prevention pass.
+ */
+static void append_to_block(sei_publisher_t *publisher, const uint8_t *nal, size_t nal_size, int copies) {
+    for (int i = 0; i < copies; i++) {
+        if (publisher->config.batch_max_nal_size == 0) {
+            memcpy(publisher->sei_block + publisher->sei_block_len, nal, nal_size);
+            publisher->sei_block_len += nal_size;
+            continue;
         }
         
-        if (cleared_count > 0) {
-            ESP_LOGW(TAG, "⚠️  Low memory (%zu bytes), cleared %d queued messages", free_heap, cleared_count);
+        if (!batch_has_room(publisher, nal_size)) {
+            // Open a new batched NAL unit with this message as its first entry
+            publisher->batch_start = publisher->sei_block_len;
+            memcpy(publisher->sei_block + publisher->sei_block_len, nal, nal_size);
+            publisher->sei_block_len += nal_size;
+            continue;
         }
         
-        *output_size = frame_size;
-        *output_data = malloc(frame_size);
-        if (*output_data) {
-            memcpy(*output_data, frame_data, frame_size);
+        // Overwrite the open unit's trailing bits with this message and re-terminate
+        size_t body_len = nal_size - SEI_NAL_PREFIX_SIZE - SEI_NAL_TRAILER_SIZE;
+        uint8_t *dst = publisher->sei_block + publisher->sei_block_len - SEI_NAL_TRAILER_SIZE;
+        memcpy(dst, nal + SEI_NAL_PREFIX_SIZE, body_len + SEI_NAL_TRAILER_SIZE);
+        publisher->sei_block_len += body_len;
+    }
+}
+
+/**
+ * @brief Note the enqueue-to-insert latency of messages appended to the block
+ */
+static void record_timing(sei_publisher_t *publisher, uint32_t timestamp, int copies) {
+    uint32_t latency_ms = publisher->frame_time_ms - timestamp;
+    if (latency_ms > UINT16_MAX) {
+        latency_ms = UINT16_MAX;
+    }
+    for (int i = 0; i < copies && publisher->timing_count < SEI_TIMING_MAX_ENTRIES; i++) {
+        publisher->timing_latency[publisher->timing_count++] = (uint16_t)latency_ms;
+    }
+}
+
+/**
+ * @brief Number of units the block can still take
+ *
+ * A timed frame keeps every unit in its timing message, so it stops at
+ * SEI_TIMING_MAX_ENTRIES and the rest waits for the next frame.
+ */
+static int units_left(const sei_publisher_t *publisher) {
+    return publisher->frame_timed ? SEI_TIMING_MAX_ENTRIES - publisher->timing_count : INT_MAX;
+}
+
+/**
+ * @brief Check whether a message's target PTS has been reached
+ *
+ * Frames without a PTS can't be compared, so they release every message.
+ */
+static bool message_due(const sei_publisher_t *publisher, const sei_message_t *msg) {
+    if (!msg->has_target_pts || !publisher->frame_has_pts) {
+        return true;
+    }
+    // Signed difference so the comparison survives PTS wrap-around
+    return (int32_t)(publisher->frame_pts - msg->target_pts) >= 0;
+}
+
+/**
+ * @brief Append the timing message of the frame to the SEI block
+ *
+ * Carries the frame PTS and one latency entry per SEI message before it in
+ * the block, in order, so viewers can place every payload on the video
+ * timeline and measure how long it waited to be sent.
+ */
+static void append_timing_message(sei_publisher_t *publisher) {
+    uint8_t payload[SEI_TIMING_PAYLOAD_SIZE];
+    payload[0] = SEI_TIMING_VERSION;
+    payload[1] = (uint8_t)publisher->timing_count;
+    put_be32(payload + 2, publisher->frame_pts);
+    put_be32(payload + 6, publisher->frame_time_ms);
+    for (int i = 0; i < publisher->timing_count; i++) {
+        put_be16(payload + SEI_TIMING_HEADER_SIZE + i * 2, publisher->timing_latency[i]);
+    }
+    size_t payload_size = SEI_TIMING_HEADER_SIZE + publisher->timing_count * 2;
+    size_t nal_size = create_sei_nal_unit(SEI_TIMING_UUID, payload, payload_size, publisher->timing_nal);
+    
+    // The block keeps SEI_TIMING_NAL_SIZE bytes beyond SEI_MAX_BLOCK_SIZE for this
+    append_to_block(publisher, publisher->timing_nal, nal_size, 1);
+}
+
+/**
+ * @brief Take the latest value of every updated topic
+ *
+ * @param discard_mask Priority classes (1 << sei_priority_t) whose values are dropped instead
+ * @return Number of live topic values dropped
+ */
+static int claim_topic_updates(sei_publisher_t *publisher, uint32_t discard_mask) {
+    int count = atomic_load_explicit(&publisher->topic_count, memory_order_acquire);
+    int dropped = 0;
+    for (int t = 0; t < count; t++) {
+        sei_topic_t *topic = &publisher->topics[t];
+        if (atomic_load_explicit(&topic->latest, memory_order_relaxed) & SEI_TOPIC_DIRTY) {
+            // Hand the old front buffer back and take the newest value
+            uint32_t latest = atomic_exchange_explicit(&topic->latest, topic->front, memory_order_acq_rel);
+            topic->front = latest & SEI_TOPIC_INDEX_MASK;
+            topic->has_value = true;
+            topic->remaining = topic->buffers[topic->front].repeat_count;
+        }
+        if (topic->has_value && (discard_mask & (1u << topic->buffers[topic->front].priority))) {
+            topic->has_value = false;
+            topic->remaining = 0;
+            dropped++;
+        }
+    }
+    return dropped;
+}
+
+/**
+ * @brief Count topics with copies to send and sticky topics with a live value
+ */
+static int count_pending_topics(const sei_publisher_t *publisher, int *sticky_count) {
+    int count = atomic_load_explicit(&publisher->topic_count, memory_order_acquire);
+    int pending = 0;
+    *sticky_count = 0;
+    for (int t = 0; t < count; t++) {
+        const sei_topic_t *topic = &publisher->topics[t];
+        // Either copies left to send, or a new value the video thread hasn't taken yet
+        if (topic->remaining > 0 ||
+            (atomic_load_explicit(&topic->latest, memory_order_relaxed) & SEI_TOPIC_DIRTY)) {
+            pending++;
+        }
+        if (topic->has_value && (topic->buffers[topic->front].flags & SEI_MSG_FLAG_STICKY)) {
+            (*sticky_count)++;
+        }
+    }
+    return pending;
+}
+
+/**
+ * @brief Per-frame byte budget of scheduled messages
+ */
+typedef struct {
+    size_t limit;               // Bytes allowed for scheduled messages
+    size_t start;               // Block length before the first scheduled message
+    int scheduled;              // Messages scheduled into this frame
+} sei_frame_budget_t;
+
+/**
+ * @brief Append this frame's copies of a scheduled message if the budget allows
+ *
+ * The first scheduled message is always sent so an oversized one can't stall
+ * the schedule.
+ *
+ * @return false if the message did not fit and the frame is full
+ */
+static bool schedule_copies(sei_publisher_t *publisher, sei_frame_budget_t *budget,
+                            const sei_message_t *msg, int *remaining, sei_splice_t *splice) {
+    // Copies in the same batched NAL would be lost together, so batching implies spreading
+    int copies = (publisher->config.spread_repeats || publisher->config.batch_max_nal_size > 0) ?
+                 1 : *remaining;
+    if (copies > units_left(publisher)) {
+        copies = units_left(publisher);
+        if (copies == 0) {
+            return false;
         }
-        xSemaphoreGive(publisher->mutex);
-        return (*output_data != NULL);
     }
+    size_t needed = copies * block_cost(publisher, msg->nal_size);
     
-    // Process all queued messages
-    uint8_t *current_data = malloc(frame_size);
-    size_t current_size = frame_size;
-    if (!current_data) {
-        ESP_LOGE(TAG, "❌ Failed to allocate initial frame buffer (%zu bytes)", frame_size);
-        xSemaphoreGive(publisher->mutex);
+    if (publisher->sei_block_len + needed > SEI_MAX_BLOCK_SIZE ||
+        (budget->scheduled > 0 && publisher->sei_block_len - budget->start + needed > budget->limit)) {
         return false;
     }
-    memcpy(current_data, frame_data, frame_size);
+    append_to_block(publisher, msg->nal, msg->nal_size, copies);
+    record_timing(publisher, msg->timestamp, copies);
+    *remaining -= copies;
+    splice->sei_units += copies;
+    budget->scheduled++;
     
-    int processed_messages = 0;
-    while (publisher->queue_count > 0) {
-        sei_message_t *msg = &publisher->message_queue[publisher->queue_head];
-        
-        // Create SEI NAL unit
-        uint8_t sei_unit[SEI_MAX_PAYLOAD_SIZE + 100];
-        size_t sei_size = create_sei_nal_unit(SEND_SEI_UUID, msg->payload, msg->payload_size, sei_unit);
-        
-        // Insert SEI unit multiple times for reliability
-        for (int i = 0; i < msg->repeat_count; i++) {
-            uint8_t *new_data;
-            size_t new_size;
-            
-            if (insert_sei_unit(current_data, current_size, sei_unit, sei_size, &new_data, &new_size)) {
-                free(current_data);
-                current_data = new_data;
-                current_size = new_size;
-            } else {
-                ESP_LOGE(TAG, "Failed to insert SEI unit (attempt %d) - memory allocation failed", i+1);
-                // Don't break, just skip this repetition but continue with the message
-                break;
+    ESP_LOGD(TAG, "📡 Inserted SEI unit: %zu bytes x%d, %d copies left", msg->nal_size, copies, *remaining);
+    return true;
+}
+
+/**
+ * @brief Schedule the queued messages, then the topics, of one priority class
+ */
+static void schedule_class(sei_publisher_t *publisher, sei_priority_t priority, sei_frame_budget_t *budget,
+                           uint32_t topics_sent, sei_splice_t *splice) {
+    sei_class_queue_t *queue = &publisher->queues[priority];
+    for (int m = 0; m < queue->active_count; m++) {
+        sei_active_msg_t *active = &queue->active[m];
+        const sei_message_t *msg = sei_ring_message(&queue->ring, active->pos);
+        if (!message_due(publisher, msg)) {
+            // Held for a later frame, doesn't block the messages behind it
+            continue;
+        }
+        if (!schedule_copies(publisher, budget, msg, &active->remaining, splice)) {
+            // Over budget, the rest waits for the next frame
+            return;
+        }
+    }
+    
+    int topic_count = atomic_load_explicit(&publisher->topic_count, memory_order_acquire);
+    for (int t = 0; t < topic_count; t++) {
+        sei_topic_t *topic = &publisher->topics[t];
+        const sei_message_t *msg = &topic->buffers[topic->front];
+        if (topic->remaining <= 0 || msg->priority != priority || (topics_sent & (1u << t)) ||
+            !message_due(publisher, msg)) {
+            continue;
+        }
+        if (!schedule_copies(publisher, budget, msg, &topic->remaining, splice)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Schedule pending messages into the SEI block and build the splice
+ *
+ * frame_has_pts and frame_pts are set by the caller.
+ */
+static bool build_splice(sei_publisher_t *publisher, const uint8_t *frame_data, size_t frame_size,
+                         const nal_index_t *nal_index, sei_splice_t *splice) {
+    // Default to a pass-through view of the original frame
+    splice->iov[0].base = frame_data;
+    splice->iov[0].len = frame_size;
+    splice->iov_count = 1;
+    splice->total_size = frame_size;
+    splice->sei_units = 0;
+    splice->block.base = NULL;
+    splice->block.len = 0;
+    splice->insert_offset = 0;
+    
+    // A splice nobody settled went out with its frame
+    finish_splice(publisher, true);
+    
+    if (atomic_exchange(&publisher->clear_requested, false)) {
+        for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+            drop_active_messages(&publisher->queues[c]);
+        }
+        claim_topic_updates(publisher, SEI_ALL_PRIORITIES);
+        publisher->sticky_count = 0;
+        publisher->sticky_next = 0;
+    }
+    
+    // Claim every committed message and topic update at once; no lock is held while building
+    int scheduled_count = 0;
+    for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+        claim_pending_messages(publisher, &publisher->queues[c]);
+        scheduled_count += publisher->queues[c].active_count;
+    }
+    claim_topic_updates(publisher, 0);
+    int sticky_topics;
+    scheduled_count += count_pending_topics(publisher, &sticky_topics);
+    if (scheduled_count == 0 && publisher->sticky_count == 0 && sticky_topics == 0) {
+        return false;
+    }
+    
+    // Without encoder metadata, index the frame once up to the first slice; it
+    // gives both the insert position and whether this is a keyframe
+    nal_index_t scanned_index;
+    if (!nal_index) {
+        int64_t index_start = esp_timer_get_time();
+        nal_index_build(frame_data, frame_size, true, &scanned_index);
+        sei_metrics_record(SEI_STAGE_NAL_INDEX, (uint32_t)(esp_timer_get_time() - index_start));
+        nal_index = &scanned_index;
+    }
+    bool is_keyframe = nal_index->is_keyframe;
+    
+    if (scheduled_count == 0 && !is_keyframe) {
+        // Only sticky messages are left and they wait for the next keyframe
+        return false;
+    }
+    
+    // Check available memory before processing; shed bulk telemetry first and
+    // only drop control messages when memory is critically low
+    size_t free_heap = esp_get_free_heap_size();
+    if (free_heap < SEI_CRITICAL_HEAP_THRESHOLD) {
+        // Clear the queues to prevent them from filling up during low memory
+        int cleared_count = claim_topic_updates(publisher, SEI_ALL_PRIORITIES);
+        for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+            cleared_count += drop_class(&publisher->queues[c]);
+        }
+        ESP_LOGW(TAG, "⚠️  Low memory (%zu bytes), cleared %d queued messages", free_heap, cleared_count);
+        sei_metrics_count(SEI_EVENT_LOW_HEAP_WIPE);
+        return false;
+    }
+    if (free_heap < SEI_LOW_HEAP_THRESHOLD) {
+        int shed_count = drop_class(&publisher->queues[SEI_PRIORITY_BULK]) +
+                         claim_topic_updates(publisher, 1u << SEI_PRIORITY_BULK);
+        if (shed_count > 0) {
+            ESP_LOGW(TAG, "⚠️  Low memory (%zu bytes), shed %d bulk messages", free_heap, shed_count);
+            sei_metrics_count(SEI_EVENT_BULK_SHED);
+        }
+    }
+    
+    publisher->sei_block_len = 0;
+    publisher->batch_start = SEI_NO_BATCH;
+    publisher->timing_count = 0;
+    publisher->frame_timed = publisher->config.frame_timing && publisher->frame_has_pts;
+    publisher->frame_time_ms = esp_timer_get_time() / 1000;
+    save_schedule(publisher);
+    
+    // Keyframes carry every sticky state message so late joiners receive it
+    int topic_count = atomic_load_explicit(&publisher->topic_count, memory_order_acquire);
+    uint32_t topics_sent = 0;
+    if (is_keyframe) {
+        for (int i = 0; i < publisher->sticky_count && units_left(publisher) > 0; i++) {
+            if (publisher->sei_block_len + block_cost(publisher, publisher->sticky_size[i]) <= SEI_MAX_BLOCK_SIZE) {
+                append_to_block(publisher, publisher->sticky_nal[i], publisher->sticky_size[i], 1);
+                record_timing(publisher, publisher->sticky_timestamp[i], 1);
+                splice->sei_units++;
+            }
+        }
+        for (int t = 0; t < topic_count; t++) {
+            sei_topic_t *topic = &publisher->topics[t];
+            const sei_message_t *msg = &topic->buffers[topic->front];
+            if (!topic->has_value || !(msg->flags & SEI_MSG_FLAG_STICKY) || units_left(publisher) == 0 ||
+                publisher->sei_block_len + block_cost(publisher, msg->nal_size) > SEI_MAX_BLOCK_SIZE) {
+                continue;
+            }
+            append_to_block(publisher, msg->nal, msg->nal_size, 1);
+            record_timing(publisher, msg->timestamp, 1);
+            splice->sei_units++;
+            topics_sent |= 1u << t;
+            if (topic->remaining > 0) {
+                // Counts as one of its scheduled copies
+                topic->remaining--;
             }
         }
-        
-        ESP_LOGI(TAG, "📡 Inserted SEI unit: %zu bytes, repeated %d times (%s)", 
-                 sei_size, msg->repeat_count, is_keyframe ? "keyframe" : "regular frame");
-        
-        // Free message payload and advance queue
-        free(msg->payload);
-        msg->payload = NULL;
-        publisher->queue_head = (publisher->queue_head + 1) % SEI_MAX_QUEUE_SIZE;
-        publisher->queue_count--;
-        processed_messages++;
     }
     
-    *output_data = current_data;
-    *output_size = current_size;
+    // Pace scheduled messages against the per-frame byte budget. Control
+    // messages go first; bulk messages get their own budget out of whatever
+    // is left, so they are the ones deferred when frames are full
+    size_t frame_limit = atomic_load_explicit(&publisher->frame_byte_budget, memory_order_relaxed);
+    if (frame_limit == 0 || frame_limit > SEI_MAX_BLOCK_SIZE) {
+        frame_limit = SEI_MAX_BLOCK_SIZE;
+    }
+    sei_frame_budget_t budget = {
+        .limit = frame_limit,
+        .start = publisher->sei_block_len,
+    };
+    schedule_class(publisher, SEI_PRIORITY_CONTROL, &budget, topics_sent, splice);
+    
+    size_t control_used = publisher->sei_block_len - budget.start;
+    size_t bulk_limit = atomic_load_explicit(&publisher->bulk_byte_budget, memory_order_relaxed);
+    if (bulk_limit == 0 || bulk_limit > frame_limit) {
+        bulk_limit = frame_limit;
+    }
+    sei_frame_budget_t bulk_budget = {
+        .limit = control_used < frame_limit ? frame_limit - control_used : 0,
+        .start = publisher->sei_block_len,
+        .scheduled = budget.scheduled,
+    };
+    if (bulk_budget.limit > bulk_limit) {
+        bulk_budget.limit = bulk_limit;
+    }
+    schedule_class(publisher, SEI_PRIORITY_BULK, &bulk_budget, topics_sent, splice);
+    int processed_messages = bulk_budget.scheduled;
     
-    if (processed_messages > 0) {
-        ESP_LOGI(TAG, "📡 Processed %d SEI messages, frame size: %zu -> %zu bytes (%s)", 
-                 processed_messages, frame_size, current_size, is_keyframe ? "keyframe" : "regular frame");
+    if (publisher->sei_block_len == 0) {
+        return false;
+    }
+    // Sent messages are released once the caller commits the splice
+    publisher->splice_pending = true;
+    if (publisher->frame_timed) {
+        append_timing_message(publisher);
     }
     
-    xSemaphoreGive(publisher->mutex);
+    // Splice the block in front of the first video slice
+    int insert_position = nal_index_insert_offset(nal_index);
+    size_t prefix_len = insert_position >= 0 ? (size_t)insert_position : 0;
+    int iov = 0;
+    if (prefix_len > 0) {
+        splice->iov[iov].base = frame_data;
+        splice->iov[iov++].len = prefix_len;
+    }
+    splice->iov[iov].base = publisher->sei_block;
+    splice->iov[iov++].len = publisher->sei_block_len;
+    splice->iov[iov].base = frame_data + prefix_len;
+    splice->iov[iov++].len = frame_size - prefix_len;
+    splice->iov_count = iov;
+    splice->block.base = publisher->sei_block;
+    splice->block.len = publisher->sei_block_len;
+    splice->insert_offset = prefix_len;
+    splice->total_size = frame_size + publisher->sei_block_len;
+    
+    ESP_LOGD(TAG, "📡 Inserted %d SEI messages (%d scheduled), frame size: %zu -> %zu bytes (%s)", 
+             splice->sei_units, processed_messages, frame_size, splice->total_size,
+             is_keyframe ? "keyframe" : "regular frame");
+    return true;
+}
+
+bool sei_publisher_build_splice(sei_publisher_handle_t handle,
+                                const uint8_t *frame_data, size_t frame_size,
+                                sei_splice_t *splice) {
+    return sei_publisher_build_splice_indexed(handle, frame_data, frame_size, NULL, splice);
+}
+
+bool sei_publisher_build_splice_indexed(sei_publisher_handle_t handle,
+                                        const uint8_t *frame_data, size_t frame_size,
+                                        const nal_index_t *nal_index,
+                                        sei_splice_t *splice) {
+    if (!handle || !frame_data || !splice) return false;
+    
+    sei_publisher_t *publisher = (sei_publisher_t *)handle;
+    publisher->frame_has_pts = false;
+    bool spliced = build_splice(publisher, frame_data, frame_size, nal_index, splice);
+    publish_schedule_size(publisher);
+    return spliced;
+}
+
+bool sei_publisher_build_splice_pts(sei_publisher_handle_t handle,
+                                    const uint8_t *frame_data, size_t frame_size,
+                                    const nal_index_t *nal_index, uint32_t pts,
+                                    sei_splice_t *splice) {
+    if (!handle || !frame_data || !splice) return false;
+    
+    sei_publisher_t *publisher = (sei_publisher_t *)handle;
+    publisher->frame_has_pts = true;
+    publisher->frame_pts = pts;
+    atomic_store_explicit(&publisher->last_pts, pts, memory_order_relaxed);
+    atomic_store_explicit(&publisher->has_last_pts, true, memory_order_release);
+    bool spliced = build_splice(publisher, frame_data, frame_size, nal_index, splice);
+    publish_schedule_size(publisher);
+    return spliced;
+}
+
+void sei_publisher_commit_splice(sei_publisher_handle_t handle) {
+    if (!handle) return;
+    finish_splice((sei_publisher_t *)handle, true);
+}
+
+void sei_publisher_cancel_splice(sei_publisher_handle_t handle) {
+    if (!handle) return;
+    finish_splice((sei_publisher_t *)handle, false);
+}
+
+size_t sei_splice_flatten(const sei_splice_t *splice, uint8_t *output) {
+    if (!splice || !output) return 0;
+    
+    size_t pos = 0;
+    for (int i = 0; i < splice->iov_count; i++) {
+        memcpy(output + pos, splice->iov[i].base, splice->iov[i].len);
+        pos += splice->iov[i].len;
+    }
+    return pos;
+}
+
+bool sei_publisher_process_frame(sei_publisher_handle_t handle, 
+                                const uint8_t *frame_data, size_t frame_size,
+                                uint8_t **output_data, size_t *output_size) {
+    return sei_publisher_process_frame_indexed(handle, frame_data, frame_size, NULL,
+                                               output_data, output_size);
+}
+
+/**
+ * @brief Build the splice of a frame, with or without a PTS, and flatten it
+ */
+static bool process_frame(sei_publisher_handle_t handle, const uint8_t *frame_data, size_t frame_size,
+                          const nal_index_t *nal_index, const uint32_t *pts,
+                          uint8_t **output_data, size_t *output_size) {
+    if (!handle || !frame_data || !output_data || !output_size) return false;
+    
+    *output_data = NULL;
+    *output_size = 0;
+    
+    sei_splice_t splice;
+    int64_t build_start = esp_timer_get_time();
+    bool spliced = pts ?
+                   sei_publisher_build_splice_pts(handle, frame_data, frame_size, nal_index, *pts, &splice) :
+                   sei_publisher_build_splice_indexed(handle, frame_data, frame_size, nal_index, &splice);
+    int64_t copy_start = esp_timer_get_time();
+    sei_metrics_record(SEI_STAGE_SPLICE_BUILD, (uint32_t)(copy_start - build_start));
+    if (!spliced) {
+        // Nothing to insert, the caller keeps using the original frame
+        return false;
+    }
+    
+    // Write prefix, SEI block and suffix in a single pass into a pooled buffer
+    uint8_t *output = video_frame_pool_acquire(splice.total_size);
+    if (!output) {
+        ESP_LOGE(TAG, "❌ Failed to allocate output frame buffer (%zu bytes)", splice.total_size);
+        // The messages were never sent, schedule them again on the next frame
+        sei_publisher_cancel_splice(handle);
+        return false;
+    }
+    *output_size = sei_splice_flatten(&splice, output);
+    *output_data = output;
+    sei_publisher_commit_splice(handle);
+    sei_metrics_record(SEI_STAGE_FRAME_COPY, (uint32_t)(esp_timer_get_time() - copy_start));
+    return true;
+}
+
+bool sei_publisher_process_frame_indexed(sei_publisher_handle_t handle,
+                                        const uint8_t *frame_data, size_t frame_size,
+                                        const nal_index_t *nal_index,
+                                        uint8_t **output_data, size_t *output_size) {
+    return process_frame(handle, frame_data, frame_size, nal_index, NULL, output_data, output_size);
+}
+
+bool sei_publisher_process_frame_pts(sei_publisher_handle_t handle,
+                                     const uint8_t *frame_data, size_t frame_size,
+                                     const nal_index_t *nal_index, uint32_t pts,
+                                     uint8_t **output_data, size_t *output_size) {
+    return process_frame(handle, frame_data, frame_size, nal_index, &pts, output_data, output_size);
+}
+
+bool sei_publisher_get_last_pts(sei_publisher_handle_t handle, uint32_t *pts) {
+    if (!handle || !pts) return false;
+    
+    sei_publisher_t *publisher = (sei_publisher_t *)handle;
+    if (!atomic_load_explicit(&publisher->has_last_pts, memory_order_acquire)) {
+        return false;
+    }
+    *pts = atomic_load_explicit(&publisher->last_pts, memory_order_relaxed);
     return true;
 }
 
@@ -455,44 +1369,49 @@ int sei_publisher_get_queue_size(sei_publisher_handle_t handle) {
     
     sei_publisher_t *publisher = (sei_publisher_t *)handle;
     
-    if (xSemaphoreTake(publisher->mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        return -1; // Indicate error
+    // The schedule belongs to the video thread, so only its published size is read here
+    int count = atomic_load_explicit(&publisher->scheduled_messages, memory_order_relaxed);
+    for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+        count += sei_ring_count(&publisher->queues[c].ring);
     }
     
-    int count = publisher->queue_count;
-    xSemaphoreGive(publisher->mutex);
+    // A topic counts once, whether it has copies left or a new value not yet taken
+    uint32_t topics = atomic_load_explicit(&publisher->scheduled_topics, memory_order_relaxed);
+    int topic_count = atomic_load_explicit(&publisher->topic_count, memory_order_acquire);
+    for (int t = 0; t < topic_count; t++) {
+        if (atomic_load_explicit(&publisher->topics[t].latest, memory_order_relaxed) & SEI_TOPIC_DIRTY) {
+            topics |= 1u << t;
+        }
+    }
+    for (; topics; topics &= topics - 1) {
+        count++;
+    }
     return count;
 }
 
-void sei_publisher_clear_queue(sei_publisher_handle_t handle) {
+void sei_publisher_set_byte_budget(sei_publisher_handle_t handle, size_t frame_byte_budget,
+                                   size_t bulk_byte_budget) {
     if (!handle) return;
     
     sei_publisher_t *publisher = (sei_publisher_t *)handle;
+    atomic_store_explicit(&publisher->frame_byte_budget, frame_byte_budget, memory_order_relaxed);
+    atomic_store_explicit(&publisher->bulk_byte_budget, bulk_byte_budget, memory_order_relaxed);
+    ESP_LOGI(TAG, "📏 SEI byte budget: %zu per frame, %zu bulk", frame_byte_budget, bulk_byte_budget);
+}
+
+void sei_publisher_clear_queue(sei_publisher_handle_t handle) {
+    if (!handle) return;
     
-    if (xSemaphoreTake(publisher->mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire mutex for queue clear");
-        return;
-    }
-    
-    int cleared_count = publisher->queue_count;
-    
-    // Free all allocated payloads
-    while (publisher->queue_count > 0) {
-        sei_message_t *msg = &publisher->message_queue[publisher->queue_head];
-        if (msg->payload) {
-            free(msg->payload);
-            msg->payload = NULL;
-        }
-        publisher->queue_head = (publisher->queue_head + 1) % SEI_MAX_QUEUE_SIZE;
-        publisher->queue_count--;
+    sei_publisher_t *publisher = (sei_publisher_t *)handle;
+    int cleared_count = atomic_load_explicit(&publisher->scheduled_messages, memory_order_relaxed);
+    for (int c = 0; c < SEI_PRIORITY_COUNT; c++) {
+        cleared_count += sei_ring_drain(&publisher->queues[c].ring);
     }
     
-    publisher->queue_head = 0;
-    publisher->queue_tail = 0;
+    // Scheduled and sticky messages belong to the video thread, it drops them on the next frame
+    atomic_store(&publisher->clear_requested, true);
     
     if (cleared_count > 0) {
         ESP_LOGI(TAG, "🗑️  Cleared %d queued SEI messages", cleared_count);
     }
-    
-    xSemaphoreGive(publisher->mutex);
-}
\ No newline at end of file
+}
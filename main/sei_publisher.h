@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "nal_index.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,22 +18,191 @@ extern "C" {
 // Maximum payload size for individual SEI messages (conservative limit)
 #define SEI_MAX_PAYLOAD_SIZE 400
 
-// Maximum number of queued messages
-#define SEI_MAX_QUEUE_SIZE 15
+// Maximum number of queued messages (power of two, see sei_ring.h)
+#define SEI_MAX_QUEUE_SIZE 16
 
 // Default repeat count for reliability
 #define SEI_DEFAULT_REPEAT_COUNT 3
 
+// Default per-frame byte budget for SEI units (keeps P-frames from ballooning)
+#define SEI_DEFAULT_FRAME_BUDGET 2048
+
+// Default per-frame byte budget for bulk telemetry, taken from what control messages leave
+#define SEI_DEFAULT_BULK_BUDGET 1024
+
+// Number of sticky state messages re-sent on every keyframe
+#define SEI_MAX_STICKY_MESSAGES 4
+
+// Default size limit for a batched SEI NAL unit when batching is enabled
+#define SEI_DEFAULT_BATCH_NAL_SIZE 1024
+
+// Latest-value-wins topics and the longest topic name (including terminator)
+#define SEI_MAX_TOPICS 8
+#define SEI_MAX_TOPIC_LEN 16
+
+// Payloads larger than SEI_MAX_PAYLOAD_SIZE are split into fragments, each
+// with a SEI_FRAGMENT_HEADER_SIZE byte header (see SEI_README.md)
+#define SEI_FRAGMENT_HEADER_SIZE 16
+#define SEI_FRAGMENT_CHUNK_SIZE (SEI_MAX_PAYLOAD_SIZE - SEI_FRAGMENT_HEADER_SIZE)
+#define SEI_MAX_FRAGMENTS 12
+#define SEI_MAX_FRAGMENTED_PAYLOAD_SIZE (SEI_MAX_FRAGMENTS * SEI_FRAGMENT_CHUNK_SIZE)
+
+// Per-frame timing message: frame PTS plus one latency entry per SEI message
+// in the access unit; a timed frame carries at most SEI_TIMING_MAX_ENTRIES
+// messages (see SEI_README.md)
+#define SEI_TIMING_HEADER_SIZE 10
+#define SEI_TIMING_MAX_ENTRIES 64
+#define SEI_TIMING_PAYLOAD_SIZE (SEI_TIMING_HEADER_SIZE + SEI_TIMING_MAX_ENTRIES * 2)
+
+// Furthest a message may be held for a target PTS, ahead of the last frame seen
+#define SEI_MAX_TARGET_AHEAD_MS 60000
+
+// Message flags
+#define SEI_MSG_FLAG_STICKY (1 << 0)    // Re-send on keyframes for late joiners
+
+// Worst-case size of one encoded SEI NAL unit (start code, header, UUID,
+// payload, trailing bits, plus up to one emulation prevention byte per 2 bytes)
+#define SEI_MAX_NAL_SIZE (6 + ((SEI_MAX_PAYLOAD_SIZE + 24) * 3) / 2)
+
+// Capacity of the per-frame SEI block (a full queue at the default repeat count)
+#define SEI_MAX_BLOCK_SIZE (SEI_MAX_QUEUE_SIZE * SEI_DEFAULT_REPEAT_COUNT * SEI_MAX_NAL_SIZE)
+
+// Encoded size of the largest timing message, kept free at the end of the SEI block
+#define SEI_TIMING_NAL_SIZE (6 + ((SEI_TIMING_PAYLOAD_SIZE + 24) * 3) / 2)
+
+// Most bytes one publisher splices into a frame
+#define SEI_BLOCK_CAPACITY (SEI_MAX_BLOCK_SIZE + SEI_TIMING_NAL_SIZE)
+
+// Maximum number of segments in a spliced frame (prefix, SEI block, suffix)
+#define SEI_SPLICE_MAX_IOV 3
+
+/**
+ * @brief Called on the video thread once the last copy of a message is in a committed frame
+ *
+ * Must not block; it runs inside the frame path.
+ *
+ * @param ctx sei_publish_opts_t.on_sent_ctx
+ * @param tag sei_publish_opts_t.on_sent_tag
+ */
+typedef void (*sei_sent_fn_t)(void *ctx, uint32_t tag);
+
 /**
  * @brief SEI message structure
  */
 typedef struct {
-    uint8_t *payload;           /*!< Message payload data */
-    size_t payload_size;        /*!< Size of payload in bytes */
+    uint8_t *nal;               /*!< Pre-encoded SEI NAL unit, ready to splice (slot in the slab) */
+    size_t nal_size;            /*!< Exact size of the encoded NAL unit in bytes */
+    size_t payload_size;        /*!< Size of the original payload in bytes */
     int repeat_count;           /*!< Number of times to repeat for reliability */
-    uint32_t timestamp;         /*!< Message timestamp (milliseconds since boot) */
+    uint32_t timestamp;         /*!< Enqueue time (milliseconds since boot) */
+    bool has_target_pts;        /*!< Held until a frame with target_pts or later */
+    uint32_t target_pts;        /*!< PTS the message is held for (milliseconds) */
+    uint8_t flags;              /*!< SEI_MSG_FLAG_* */
+    uint8_t priority;           /*!< sei_priority_t */
+    sei_sent_fn_t on_sent;      /*!< Called when the last copy is sent, NULL for none */
+    void *on_sent_ctx;
+    uint32_t on_sent_tag;
 } sei_message_t;
 
+/**
+ * @brief Message priority class
+ * 
+ * Each class has its own queue, so a flood of one can't evict the other.
+ * Control messages are scheduled first; bulk messages are shed first when
+ * the frame budget runs out or free heap is low.
+ */
+typedef enum {
+    SEI_PRIORITY_CONTROL = 0,   /*!< Chat and interactive overlay messages */
+    SEI_PRIORITY_BULK,          /*!< Periodic telemetry and test traffic */
+    SEI_PRIORITY_COUNT,
+} sei_priority_t;
+
+/**
+ * @brief Payload encoding, selects the UUID the message is sent with
+ */
+typedef enum {
+    SEI_PAYLOAD_JSON = 0,       /*!< UTF-8 JSON, sent with the original UUID */
+    SEI_PAYLOAD_TLV,            /*!< Binary TLV (see sei_tlv.h), sent with SEI_TLV_UUID_V1 */
+} sei_payload_format_t;
+
+/**
+ * @brief Per-message publishing options
+ */
+typedef struct {
+    int repeat_count;           /*!< Copies to send (<= 0 for SEI_DEFAULT_REPEAT_COUNT) */
+    bool sticky;                /*!< Also re-send on every keyframe so late joiners get it; without a
+                                     topic up to SEI_MAX_STICKY_MESSAGES are kept, oldest replaced
+                                     first, so changing state should use a topic */
+    sei_payload_format_t format; /*!< Payload encoding */
+    sei_priority_t priority;    /*!< Priority class */
+    const char *topic;          /*!< Latest-value-wins topic (up to SEI_MAX_TOPIC_LEN - 1 chars), NULL to queue every message */
+    bool has_target_pts;        /*!< Hold the message for target_pts instead of sending it right away; not with sticky */
+    uint32_t target_pts;        /*!< PTS to hold the message for (ms, see sei_publisher_get_last_pts) */
+    sei_sent_fn_t on_sent;      /*!< Called once the last copy is in a committed frame, never if the
+                                     message is dropped; not with topics or fragmented payloads */
+    void *on_sent_ctx;          /*!< Passed to on_sent */
+    uint32_t on_sent_tag;       /*!< Passed to on_sent */
+} sei_publish_opts_t;
+
+/**
+ * @brief One contiguous segment of a spliced frame
+ */
+typedef struct {
+    const uint8_t *base;        /*!< Segment start */
+    size_t len;                 /*!< Segment length in bytes */
+} sei_iovec_t;
+
+/**
+ * @brief Scatter-gather view of a frame with SEI units spliced in
+ *
+ * Segments point into the original frame and the publisher's SEI block, so
+ * no frame bytes are copied to build it. The view stays valid until the next
+ * call that processes a frame on the same publisher.
+ */
+typedef struct {
+    sei_iovec_t iov[SEI_SPLICE_MAX_IOV]; /*!< Output segments in send order */
+    int iov_count;              /*!< Number of valid segments */
+    size_t total_size;          /*!< Sum of all segment lengths */
+    int sei_units;              /*!< Number of SEI messages in the block */
+    sei_iovec_t block;          /*!< The SEI block alone, for merging several publishers' blocks */
+    size_t insert_offset;       /*!< Frame offset the block is inserted at */
+} sei_splice_t;
+
+/**
+ * @brief Memory used for the queued message slab
+ */
+typedef enum {
+    SEI_SLAB_AUTO = 0,          /*!< PSRAM when available, otherwise internal RAM */
+    SEI_SLAB_INTERNAL,          /*!< Internal SRAM */
+    SEI_SLAB_PSRAM,             /*!< External PSRAM */
+} sei_slab_location_t;
+
+/**
+ * @brief SEI publisher configuration
+ */
+typedef struct {
+    int max_retry_attempts;             /*!< Maximum number of retry attempts for publishing */
+    sei_slab_location_t slab_location;  /*!< Where to place the message slab */
+    size_t frame_byte_budget;           /*!< SEI bytes allowed per frame, 0 for no limit */
+    size_t bulk_byte_budget;            /*!< Of those, bytes bulk messages may use, 0 for no separate limit */
+    bool spread_repeats;                /*!< Send one copy per frame instead of stacking repeats */
+    size_t batch_max_nal_size;          /*!< Pack a frame's messages into SEI NAL units up to this size, 0 to disable */
+    bool frame_timing;                  /*!< Add a timing message with the frame PTS and per-message latencies */
+    const uint8_t *uuid;                /*!< 16-byte UUID for all payloads of this publisher (copied),
+                                             NULL for the built-in JSON and TLV UUIDs */
+} sei_publisher_config_t;
+
+#define SEI_PUBLISHER_DEFAULT_CONFIG() {                \
+    .max_retry_attempts = 3,                            \
+    .slab_location = SEI_SLAB_AUTO,                     \
+    .frame_byte_budget = SEI_DEFAULT_FRAME_BUDGET,      \
+    .bulk_byte_budget = SEI_DEFAULT_BULK_BUDGET,        \
+    .spread_repeats = true,                             \
+    .batch_max_nal_size = 0,                            \
+    .frame_timing = true,                               \
+    .uuid = NULL,                                       \
+}
+
 /**
  * @brief SEI publisher handle
  */
@@ -46,6 +216,18 @@ typedef struct sei_publisher_s *sei_publisher_handle_t;
  */
 sei_publisher_handle_t sei_publisher_init(int max_retry_attempts);
 
+/**
+ * @brief Initialize SEI publisher with explicit configuration
+ * 
+ * All message storage (per-class queues, sticky store and topics) is
+ * allocated here as one slab, so publishing never
+ * allocates and heap usage stays constant for the lifetime of the stream.
+ * 
+ * @param config Publisher configuration
+ * @return SEI publisher handle or NULL on failure
+ */
+sei_publisher_handle_t sei_publisher_init_with_config(const sei_publisher_config_t *config);
+
 /**
  * @brief Deinitialize SEI publisher and free resources
  * 
@@ -63,6 +245,17 @@ void sei_publisher_deinit(sei_publisher_handle_t handle);
  */
 bool sei_publisher_publish_text(sei_publisher_handle_t handle, const char *text, int repeat_count);
 
+/**
+ * @brief Publish text content as SEI metadata with publishing options
+ * 
+ * @param handle SEI publisher handle
+ * @param text Text content to publish
+ * @param opts Publishing options, NULL for defaults
+ * @return true if successfully queued, false otherwise
+ */
+bool sei_publisher_publish_text_opts(sei_publisher_handle_t handle, const char *text,
+                                     const sei_publish_opts_t *opts);
+
 /**
  * @brief Publish JSON string as SEI metadata
  * 
@@ -73,28 +266,203 @@ bool sei_publisher_publish_text(sei_publisher_handle_t handle, const char *text,
  */
 bool sei_publisher_publish_json(sei_publisher_handle_t handle, const char *json_str, int repeat_count);
 
+/**
+ * @brief Publish a raw payload as SEI metadata
+ * 
+ * Payloads larger than SEI_MAX_PAYLOAD_SIZE are split into sequenced
+ * fragments sent with SEI_FRAGMENT_UUID, which drain over the following
+ * frames under the frame budget. Fragmented payloads can't use topics or
+ * sticky delivery, and are only queued if every fragment fits in the queue.
+ * Publishers with their own UUID can't fragment, since fragments don't
+ * carry it.
+ * 
+ * @param handle SEI publisher handle
+ * @param payload Payload bytes (at most SEI_MAX_FRAGMENTED_PAYLOAD_SIZE)
+ * @param payload_size Size of payload in bytes
+ * @param opts Publishing options, NULL for defaults
+ * @return true if successfully queued, false otherwise
+ */
+bool sei_publisher_publish(sei_publisher_handle_t handle, const uint8_t *payload, size_t payload_size,
+                           const sei_publish_opts_t *opts);
+
 /**
  * @brief Process a video frame and insert any queued SEI messages
  * 
  * @param handle SEI publisher handle
  * @param frame_data Input video frame data
  * @param frame_size Size of input frame data
- * @param output_data Pointer to store output frame data (caller must free)
+ * @param output_data Pointer to store output frame data (release with video_frame_pool_release)
  * @param output_size Pointer to store output frame size
- * @return true if processing successful, false otherwise
+ * @return true if SEI units were inserted, false if the original frame should be used
  */
 bool sei_publisher_process_frame(sei_publisher_handle_t handle, 
                                 const uint8_t *frame_data, size_t frame_size,
                                 uint8_t **output_data, size_t *output_size);
 
+/**
+ * @brief Process a video frame whose NAL layout is already known
+ * 
+ * @param handle SEI publisher handle
+ * @param frame_data Input video frame data
+ * @param frame_size Size of input frame data
+ * @param nal_index NAL table of the frame, or NULL to index it here
+ * @param output_data Pointer to store output frame data (release with video_frame_pool_release)
+ * @param output_size Pointer to store output frame size
+ * @return true if SEI units were inserted, false if the original frame should be used
+ */
+bool sei_publisher_process_frame_indexed(sei_publisher_handle_t handle,
+                                        const uint8_t *frame_data, size_t frame_size,
+                                        const nal_index_t *nal_index,
+                                        uint8_t **output_data, size_t *output_size);
+
+/**
+ * @brief Process a video frame with a known PTS
+ * 
+ * Same as sei_publisher_process_frame_indexed, but messages held for a
+ * target PTS are released against pts, and the frame's SEI messages are
+ * stamped with it (see sei_publisher_config_t.frame_timing).
+ * 
+ * @param handle SEI publisher handle
+ * @param frame_data Input video frame data
+ * @param frame_size Size of input frame data
+ * @param nal_index NAL table of the frame, or NULL to index it here
+ * @param pts Presentation timestamp of the frame in milliseconds
+ * @param output_data Pointer to store output frame data (release with video_frame_pool_release)
+ * @param output_size Pointer to store output frame size
+ * @return true if SEI units were inserted, false if the original frame should be used
+ */
+bool sei_publisher_process_frame_pts(sei_publisher_handle_t handle,
+                                     const uint8_t *frame_data, size_t frame_size,
+                                     const nal_index_t *nal_index, uint32_t pts,
+                                     uint8_t **output_data, size_t *output_size);
+
+/**
+ * @brief Splice queued SEI messages into a frame without copying it
+ *
+ * Finds the first slice NAL once, schedules pending messages into one
+ * contiguous SEI block and returns the output frame as prefix, SEI block and
+ * suffix segments. Repeats are spread over consecutive frames, sticky
+ * messages are re-sent on keyframes, and each frame is paced against the
+ * configured byte budget; messages that do not fit wait for the next frame.
+ * The splice stays pending until sei_publisher_commit_splice or
+ * sei_publisher_cancel_splice, and the block is valid until the next build.
+ *
+ * @param handle SEI publisher handle
+ * @param frame_data Input video frame data
+ * @param frame_size Size of input frame data
+ * @param splice Filled with the segments of the output frame
+ * @return true if SEI units were spliced in, false if the frame should be sent unchanged
+ */
+bool sei_publisher_build_splice(sei_publisher_handle_t handle,
+                                const uint8_t *frame_data, size_t frame_size,
+                                sei_splice_t *splice);
+
+/**
+ * @brief Splice queued SEI messages into a frame whose NAL layout is known
+ * 
+ * Same as sei_publisher_build_splice, but takes the insert position and
+ * keyframe flag from nal_index (for example from the encoder) instead of
+ * scanning the frame.
+ * 
+ * @param handle SEI publisher handle
+ * @param frame_data Input video frame data
+ * @param frame_size Size of input frame data
+ * @param nal_index NAL table of the frame, or NULL to index it here
+ * @param splice Filled with the segments of the output frame
+ * @return true if SEI units were spliced in, false if the frame should be sent unchanged
+ */
+bool sei_publisher_build_splice_indexed(sei_publisher_handle_t handle,
+                                        const uint8_t *frame_data, size_t frame_size,
+                                        const nal_index_t *nal_index,
+                                        sei_splice_t *splice);
+
+/**
+ * @brief Splice queued SEI messages into a frame with a known PTS
+ * 
+ * Same as sei_publisher_build_splice_indexed, and releases messages held
+ * for a target PTS and stamps the frame's messages with pts. Frames spliced
+ * without a PTS send held messages right away and carry no timing message.
+ * 
+ * @param handle SEI publisher handle
+ * @param frame_data Input video frame data
+ * @param frame_size Size of input frame data
+ * @param nal_index NAL table of the frame, or NULL to index it here
+ * @param pts Presentation timestamp of the frame in milliseconds
+ * @param splice Filled with the segments of the output frame
+ * @return true if SEI units were spliced in, false if the frame should be sent unchanged
+ */
+bool sei_publisher_build_splice_pts(sei_publisher_handle_t handle,
+                                    const uint8_t *frame_data, size_t frame_size,
+                                    const nal_index_t *nal_index, uint32_t pts,
+                                    sei_splice_t *splice);
+
+/**
+ * @brief Mark the messages of the last splice as sent
+ * 
+ * Call once the spliced frame has been written out. Fully sent messages go
+ * back to producers here, after their on_sent callbacks; a splice that is
+ * neither committed nor cancelled is committed by the next build.
+ * 
+ * @param handle SEI publisher handle
+ */
+void sei_publisher_commit_splice(sei_publisher_handle_t handle);
+
+/**
+ * @brief Put the messages of the last splice back as if it was never built
+ * 
+ * For frames that could not carry the block (no output buffer, no room for
+ * the insertion); the same copies are scheduled again on the next frame.
+ * Call before the next build, on the video thread.
+ * 
+ * @param handle SEI publisher handle
+ */
+void sei_publisher_cancel_splice(sei_publisher_handle_t handle);
+
+/**
+ * @brief Copy a spliced frame into one contiguous buffer
+ *
+ * @param splice Splice built by sei_publisher_build_splice
+ * @param output Destination buffer of at least splice->total_size bytes
+ * @return Number of bytes written
+ */
+size_t sei_splice_flatten(const sei_splice_t *splice, uint8_t *output);
+
 /**
  * @brief Get the current number of queued messages
  * 
+ * Safe from any task. Messages already claimed by the video thread are
+ * counted as of the last frame it spliced.
+ * 
  * @param handle SEI publisher handle
  * @return Number of queued messages
  */
 int sei_publisher_get_queue_size(sei_publisher_handle_t handle);
 
+/**
+ * @brief Get the PTS of the last frame spliced with a PTS
+ * 
+ * Producers add a delay to it to target a future frame with
+ * sei_publish_opts_t.target_pts.
+ * 
+ * @param handle SEI publisher handle
+ * @param pts Pointer to store the PTS in milliseconds
+ * @return false if no frame with a PTS was seen yet
+ */
+bool sei_publisher_get_last_pts(sei_publisher_handle_t handle, uint32_t *pts);
+
+/**
+ * @brief Change the per-frame byte budgets while streaming
+ * 
+ * Takes effect from the next frame. Used to scale SEI traffic with the
+ * video bitrate.
+ * 
+ * @param handle SEI publisher handle
+ * @param frame_byte_budget SEI bytes allowed per frame, 0 for no limit
+ * @param bulk_byte_budget Of those, bytes bulk messages may use, 0 for no separate limit
+ */
+void sei_publisher_set_byte_budget(sei_publisher_handle_t handle, size_t frame_byte_budget,
+                                   size_t bulk_byte_budget);
+
 /**
  * @brief Clear all queued messages
  * 
@@ -0,0 +1,107 @@
+/* Lock-free SEI Message Ring Implementation
+ * 
+ * Bounded multi-producer ring of pre-encoded SEI messages with fixed-size slots
+ * (sequence-numbered slots, after Vyukov's bounded MPMC queue).
+ */
+
+#include "sei_ring.h"
+#include <string.h>
+
+void sei_ring_init(sei_ring_t *ring, uint8_t *slab) {
+    memset(ring, 0, sizeof(*ring));
+    for (uint32_t i = 0; i < SEI_MAX_QUEUE_SIZE; i++) {
+        ring->slots[i].msg.nal = slab + i * SEI_MAX_NAL_SIZE;
+        atomic_init(&ring->slots[i].seq, i);
+    }
+    atomic_init(&ring->enqueue_pos, 0);
+    atomic_init(&ring->dequeue_pos, 0);
+}
+
+sei_message_t *sei_ring_reserve(sei_ring_t *ring, uint32_t *pos) {
+    uint32_t enqueue_pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    
+    for (;;) {
+        sei_ring_slot_t *slot = &ring->slots[enqueue_pos & SEI_RING_MASK];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - enqueue_pos);
+        
+        if (diff == 0) {
+            // Slot is free, race other producers for it
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &enqueue_pos, enqueue_pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *pos = enqueue_pos;
+                return &slot->msg;
+            }
+        } else if (diff < 0) {
+            // Slot still holds a message that has not been released
+            return NULL;
+        } else {
+            enqueue_pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+void sei_ring_commit(sei_ring_t *ring, uint32_t pos) {
+    atomic_store_explicit(&ring->slots[pos & SEI_RING_MASK].seq, pos + 1, memory_order_release);
+}
+
+int sei_ring_claim(sei_ring_t *ring, int max_count, uint32_t *first_pos) {
+    uint32_t head = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    
+    if (max_count > SEI_MAX_QUEUE_SIZE) {
+        max_count = SEI_MAX_QUEUE_SIZE;
+    }
+    
+    for (;;) {
+        // Count the committed messages in order; stop at the first slot a
+        // producer is still writing
+        int count = 0;
+        while (count < max_count) {
+            uint32_t pos = head + count;
+            uint32_t seq = atomic_load_explicit(&ring->slots[pos & SEI_RING_MASK].seq, memory_order_acquire);
+            if (seq != pos + 1) {
+                break;
+            }
+            count++;
+        }
+        
+        if (count == 0) {
+            return 0;
+        }
+        
+        if (atomic_compare_exchange_weak_explicit(&ring->dequeue_pos, &head, head + count,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            *first_pos = head;
+            return count;
+        }
+    }
+}
+
+void sei_ring_release(sei_ring_t *ring, uint32_t pos) {
+    atomic_store_explicit(&ring->slots[pos & SEI_RING_MASK].seq, pos + SEI_MAX_QUEUE_SIZE, memory_order_release);
+}
+
+bool sei_ring_drop_oldest(sei_ring_t *ring) {
+    uint32_t pos;
+    if (sei_ring_claim(ring, 1, &pos) != 1) {
+        return false;
+    }
+    sei_ring_release(ring, pos);
+    return true;
+}
+
+int sei_ring_drain(sei_ring_t *ring) {
+    uint32_t first_pos;
+    int count = sei_ring_claim(ring, SEI_MAX_QUEUE_SIZE, &first_pos);
+    
+    for (int i = 0; i < count; i++) {
+        sei_ring_release(ring, first_pos + i);
+    }
+    return count;
+}
+
+int sei_ring_count(sei_ring_t *ring) {
+    uint32_t enqueue_pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    uint32_t dequeue_pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    return (int)(enqueue_pos - dequeue_pos);
+}
@@ -0,0 +1,122 @@
+/* Lock-free SEI Message Ring
+ * 
+ * Bounded multi-producer ring of pre-encoded SEI messages with fixed-size slots
+ * carved from one preallocated slab. Producers never block the video thread, and the consumer claims every
+ * pending message with a single atomic operation.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "sei_publisher.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEI_RING_MASK (SEI_MAX_QUEUE_SIZE - 1)
+
+_Static_assert((SEI_MAX_QUEUE_SIZE & SEI_RING_MASK) == 0, "SEI_MAX_QUEUE_SIZE must be a power of two");
+
+/**
+ * @brief Ring slot
+ * 
+ * The sequence number tells who owns the slot: equal to the position when it
+ * is free for a producer, position + 1 once the message is committed, and
+ * position + SEI_MAX_QUEUE_SIZE after the consumer released it.
+ */
+typedef struct {
+    _Atomic uint32_t seq;                   /*!< Slot ownership sequence */
+    sei_message_t msg;                      /*!< Message, nal points into the slab */
+} sei_ring_slot_t;
+
+/**
+ * @brief SEI message ring
+ */
+typedef struct {
+    _Atomic uint32_t enqueue_pos;           /*!< Next position for producers */
+    _Atomic uint32_t dequeue_pos;           /*!< Next position for consumers */
+    sei_ring_slot_t slots[SEI_MAX_QUEUE_SIZE];
+} sei_ring_t;
+
+// Size of the slab backing one ring (one encoded NAL unit per slot)
+#define SEI_RING_SLAB_SIZE (SEI_MAX_QUEUE_SIZE * SEI_MAX_NAL_SIZE)
+
+/**
+ * @brief Initialize an empty ring
+ * 
+ * @param ring Ring to initialize (must live in internal RAM for atomics)
+ * @param slab NAL storage of SEI_RING_SLAB_SIZE bytes (internal RAM or PSRAM)
+ */
+void sei_ring_init(sei_ring_t *ring, uint8_t *slab);
+
+/**
+ * @brief Reserve a free slot for writing a message
+ * 
+ * @param ring Ring handle
+ * @param pos Pointer to store the reserved position
+ * @return Message to fill in, or NULL if the ring is full
+ */
+sei_message_t *sei_ring_reserve(sei_ring_t *ring, uint32_t *pos);
+
+/**
+ * @brief Publish a reserved slot to consumers
+ * 
+ * @param ring Ring handle
+ * @param pos Position returned by sei_ring_reserve
+ */
+void sei_ring_commit(sei_ring_t *ring, uint32_t pos);
+
+/**
+ * @brief Claim up to max_count committed messages with one atomic operation
+ * 
+ * Claimed slots stay owned by the caller until each is released.
+ * 
+ * @param ring Ring handle
+ * @param max_count Maximum number of messages to claim
+ * @param first_pos Pointer to store the first claimed position
+ * @return Number of claimed messages (consecutive positions from first_pos)
+ */
+int sei_ring_claim(sei_ring_t *ring, int max_count, uint32_t *first_pos);
+
+/**
+ * @brief Get the message stored at a claimed position
+ */
+static inline sei_message_t *sei_ring_message(sei_ring_t *ring, uint32_t pos) {
+    return &ring->slots[pos & SEI_RING_MASK].msg;
+}
+
+/**
+ * @brief Hand a claimed slot back to producers
+ * 
+ * @param ring Ring handle
+ * @param pos Claimed position
+ */
+void sei_ring_release(sei_ring_t *ring, uint32_t pos);
+
+/**
+ * @brief Drop the oldest committed message to make room for a new one
+ * 
+ * @param ring Ring handle
+ * @return true if a message was dropped
+ */
+bool sei_ring_drop_oldest(sei_ring_t *ring);
+
+/**
+ * @brief Drop every committed message
+ * 
+ * @param ring Ring handle
+ * @return Number of dropped messages
+ */
+int sei_ring_drain(sei_ring_t *ring);
+
+/**
+ * @brief Get the number of reserved or committed messages
+ */
+int sei_ring_count(sei_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,73 @@
+/* Compact Binary SEI Payload Encoding Implementation
+ * 
+ * Schema-tagged TLV encoding for SEI payloads, see sei_tlv.h for the format.
+ */
+
+#include "sei_tlv.h"
+#include <string.h>
+
+// UUID for binary TLV payloads, version 1 (unique v4 UUID: 3f8a2b1c-4d5e-6f70-8192-a3b4c5d6e701)
+const uint8_t SEI_TLV_UUID_V1[16] = {
+    0x3F, 0x8A, 0x2B, 0x1C, 0x4D, 0x5E, 0x6F, 0x70,
+    0x81, 0x92, 0xA3, 0xB4, 0xC5, 0xD6, 0xE7, 0x01
+};
+
+/**
+ * @brief Append one raw byte
+ */
+static void put_byte(sei_tlv_writer_t *writer, uint8_t byte) {
+    if (writer->len >= writer->cap) {
+        writer->overflow = true;
+        return;
+    }
+    writer->buf[writer->len++] = byte;
+}
+
+/**
+ * @brief Append an unsigned LEB128 varint
+ */
+static void put_varint(sei_tlv_writer_t *writer, uint32_t value) {
+    while (value >= 0x80) {
+        put_byte(writer, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    put_byte(writer, (uint8_t)value);
+}
+
+void sei_tlv_init(sei_tlv_writer_t *writer, uint8_t *buf, size_t cap, uint8_t schema) {
+    writer->buf = buf;
+    writer->cap = cap;
+    writer->len = 0;
+    writer->overflow = false;
+    put_byte(writer, schema);
+}
+
+void sei_tlv_put_uint(sei_tlv_writer_t *writer, uint8_t field, uint32_t value) {
+    put_byte(writer, (uint8_t)((field << 3) | SEI_TLV_WIRE_VARINT));
+    put_varint(writer, value);
+}
+
+void sei_tlv_put_int(sei_tlv_writer_t *writer, uint8_t field, int32_t value) {
+    // Zigzag keeps small negative values short
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    sei_tlv_put_uint(writer, field, zigzag);
+}
+
+void sei_tlv_put_string(sei_tlv_writer_t *writer, uint8_t field, const char *str) {
+    size_t str_len = str ? strlen(str) : 0;
+    
+    put_byte(writer, (uint8_t)((field << 3) | SEI_TLV_WIRE_BYTES));
+    put_varint(writer, (uint32_t)str_len);
+    if (writer->overflow || writer->len + str_len > writer->cap) {
+        writer->overflow = true;
+        return;
+    }
+    if (str_len > 0) {
+        memcpy(writer->buf + writer->len, str, str_len);
+        writer->len += str_len;
+    }
+}
+
+size_t sei_tlv_finish(const sei_tlv_writer_t *writer) {
+    return writer->overflow ? 0 : writer->len;
+}
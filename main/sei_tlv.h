@@ -0,0 +1,127 @@
+/* Compact Binary SEI Payload Encoding
+ * 
+ * Schema-tagged TLV encoding for SEI payloads. A payload is one schema byte
+ * followed by fields; each field is a key byte (field id << 3 | wire type)
+ * and either a varint or a length-prefixed byte string, so receivers can skip
+ * fields they don't know. Binary payloads are sent with SEI_TLV_UUID_V1.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Wire types (low 3 bits of a field key)
+#define SEI_TLV_WIRE_VARINT 0       // Unsigned LEB128, signed values zigzag-encoded
+#define SEI_TLV_WIRE_BYTES  2       // Varint length followed by raw bytes
+
+// Payload schemas (first payload byte)
+#define SEI_TLV_SCHEMA_TEXT     1   // Text message
+#define SEI_TLV_SCHEMA_CHAT     2   // Role/content chat message
+#define SEI_TLV_SCHEMA_STATUS   3   // Named status value
+#define SEI_TLV_SCHEMA_SENSOR   4   // Temperature/humidity reading
+#define SEI_TLV_SCHEMA_STATS    5   // WebRTC stream statistics window
+#define SEI_TLV_SCHEMA_PROBE    6   // Latency probe of the carrying frame
+
+// Fields shared by every schema
+#define SEI_TLV_FIELD_TIMESTAMP     1   // uint, milliseconds since boot
+
+// SEI_TLV_SCHEMA_TEXT fields
+#define SEI_TLV_FIELD_TEXT          2   // bytes, UTF-8
+
+// SEI_TLV_SCHEMA_CHAT fields
+#define SEI_TLV_FIELD_ROLE          2   // bytes, UTF-8
+#define SEI_TLV_FIELD_CONTENT       3   // bytes, UTF-8
+
+// SEI_TLV_SCHEMA_STATUS fields
+#define SEI_TLV_FIELD_STATUS        2   // bytes, UTF-8
+#define SEI_TLV_FIELD_VALUE         3   // sint
+
+// SEI_TLV_SCHEMA_SENSOR fields
+#define SEI_TLV_FIELD_SENSOR_ID     2   // uint, SEI_TLV_SENSOR_*
+#define SEI_TLV_FIELD_TEMP_DECI_C   3   // sint, tenths of a degree Celsius
+#define SEI_TLV_FIELD_HUMIDITY_DECI 4   // uint, tenths of a percent
+#define SEI_TLV_FIELD_SENSOR_STATUS 5   // uint, 0 = ok, 1 = read error
+#define SEI_TLV_FIELD_LOG_SEQ       6   // uint, telemetry log seq, only on readings replayed from the log
+#define SEI_TLV_FIELD_READING_UNIX_S 7  // uint, wall-clock time of a replayed reading, absent if the clock wasn't set
+
+// SEI_TLV_SCHEMA_STATS fields (see webrtc_stats_sample_t)
+#define SEI_TLV_FIELD_INTERVAL_MS   2   // uint
+#define SEI_TLV_FIELD_FPS_X10       3   // uint, tenths of a frame per second
+#define SEI_TLV_FIELD_SEND_KBPS     4   // uint
+#define SEI_TLV_FIELD_SEND_DELAY_MS 5   // uint
+#define SEI_TLV_FIELD_KEYFRAMES     6   // uint
+#define SEI_TLV_FIELD_SEI_DROPPED   7   // uint
+#define SEI_TLV_FIELD_SEI_QUEUE     8   // uint
+#define SEI_TLV_FIELD_FREE_HEAP     9   // uint, bytes
+#define SEI_TLV_FIELD_PROFILE       10  // uint, video profile index
+#define SEI_TLV_FIELD_FRAMES_MISSED 11  // uint
+#define SEI_TLV_FIELD_FRAMES_LATE   12  // uint
+
+// SEI_TLV_SCHEMA_PROBE fields (see latency_probe_t), timestamp is the capture time
+#define SEI_TLV_FIELD_PROBE_SEQ     2   // uint
+#define SEI_TLV_FIELD_PROBE_PTS     3   // uint, milliseconds
+#define SEI_TLV_FIELD_CAPTURE_UNIX_S  4 // uint, capture wall-clock seconds, absent if the clock isn't set
+#define SEI_TLV_FIELD_CAPTURE_UNIX_US 5 // uint, microseconds within that second
+#define SEI_TLV_FIELD_ENCODE_US     6   // uint, capture to encoded, absent if not seen
+#define SEI_TLV_FIELD_SEND_US       7   // uint, capture to on_video_send
+
+// Sensor ids
+#define SEI_TLV_SENSOR_DHT11        1
+
+/**
+ * @brief UUID carried by binary (TLV v1) SEI payloads
+ */
+extern const uint8_t SEI_TLV_UUID_V1[16];
+
+/**
+ * @brief TLV payload writer
+ */
+typedef struct {
+    uint8_t *buf;               /*!< Output buffer */
+    size_t cap;                 /*!< Output buffer size */
+    size_t len;                 /*!< Bytes written so far */
+    bool overflow;              /*!< Set once a field did not fit */
+} sei_tlv_writer_t;
+
+/**
+ * @brief Start a payload with the given schema
+ * 
+ * @param writer Writer to initialize
+ * @param buf Output buffer
+ * @param cap Output buffer size
+ * @param schema Payload schema (SEI_TLV_SCHEMA_*)
+ */
+void sei_tlv_init(sei_tlv_writer_t *writer, uint8_t *buf, size_t cap, uint8_t schema);
+
+/**
+ * @brief Append an unsigned varint field
+ */
+void sei_tlv_put_uint(sei_tlv_writer_t *writer, uint8_t field, uint32_t value);
+
+/**
+ * @brief Append a signed (zigzag) varint field
+ */
+void sei_tlv_put_int(sei_tlv_writer_t *writer, uint8_t field, int32_t value);
+
+/**
+ * @brief Append a length-prefixed string field
+ */
+void sei_tlv_put_string(sei_tlv_writer_t *writer, uint8_t field, const char *str);
+
+/**
+ * @brief Finish the payload
+ * 
+ * @param writer Writer
+ * @return Payload length in bytes, or 0 if a field did not fit
+ */
+size_t sei_tlv_finish(const sei_tlv_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,186 @@
+/* Sensor Sampling Implementation
+ *
+ * Earliest-deadline loop over a small fixed table; the task blocks on its
+ * notification until the next sensor is due or the table changes
+ */
+
+#include "sensor_sampler.h"
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "SENSOR_SAMPLER";
+
+#define SENSOR_TASK_STACK_SIZE 4096
+#define SENSOR_TASK_PRIORITY 4
+
+typedef struct {
+    const sensor_driver_t *driver;
+    int64_t next_due_us;
+    bool init_done;
+    sensor_sampler_stats_t stats;
+} sensor_slot_t;
+
+typedef struct {
+    sensor_slot_t slots[SENSOR_SAMPLER_MAX_SENSORS];
+    int count;
+    bool enabled;
+    TaskHandle_t task;
+    portMUX_TYPE lock;                  // Guards count, next_due_us and stats
+} sensor_sampler_t;
+
+static sensor_sampler_t g_sampler = {
+    .enabled = true,
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static void wake_task(void) {
+    if (g_sampler.task) {
+        xTaskNotifyGive(g_sampler.task);
+    }
+}
+
+int sensor_sampler_register(const sensor_driver_t *driver) {
+    if (!driver || !driver->sample || driver->interval_ms == 0) return -1;
+
+    taskENTER_CRITICAL(&g_sampler.lock);
+    int index = g_sampler.count;
+    if (index < SENSOR_SAMPLER_MAX_SENSORS) {
+        sensor_slot_t *slot = &g_sampler.slots[index];
+        slot->driver = driver;
+        slot->next_due_us = 0;
+        slot->init_done = false;
+        slot->stats = (sensor_sampler_stats_t){
+            .name = driver->name,
+            .interval_ms = driver->interval_ms,
+        };
+        g_sampler.count++;
+    } else {
+        index = -1;
+    }
+    taskEXIT_CRITICAL(&g_sampler.lock);
+
+    if (index < 0) {
+        ESP_LOGE(TAG, "❌ Sensor table full, %s not registered", driver->name);
+        return -1;
+    }
+    ESP_LOGI(TAG, "🌡️  Registered sensor %s, every %" PRIu32 " ms", driver->name, driver->interval_ms);
+    wake_task();
+    return index;
+}
+
+/**
+ * @brief Run one sensor, initializing it first if needed
+ */
+static void run_slot(sensor_slot_t *slot) {
+    const sensor_driver_t *driver = slot->driver;
+    if (!slot->init_done) {
+        slot->init_done = true;
+        bool ready = !driver->init || driver->init(driver->ctx);
+        taskENTER_CRITICAL(&g_sampler.lock);
+        slot->stats.ready = ready;
+        taskEXIT_CRITICAL(&g_sampler.lock);
+        if (!ready) {
+            ESP_LOGE(TAG, "❌ Sensor %s failed to initialize, not sampling it", driver->name);
+        }
+    }
+    if (!slot->stats.ready) return;
+
+    int64_t start_us = esp_timer_get_time();
+    bool ok = driver->sample(driver->ctx);
+    uint32_t duration_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    taskENTER_CRITICAL(&g_sampler.lock);
+    if (ok) {
+        slot->stats.samples++;
+    } else {
+        slot->stats.failures++;
+    }
+    slot->stats.last_duration_us = duration_us;
+    taskEXIT_CRITICAL(&g_sampler.lock);
+}
+
+static void sampler_task(void *arg) {
+    ESP_LOGI(TAG, "🌡️  Sensor sampling task started on core %d", xPortGetCoreID());
+    for (;;) {
+        // Pick the sensor due first
+        sensor_slot_t *due = NULL;
+        int64_t wait_us = -1;
+        int64_t now_us = esp_timer_get_time();
+
+        taskENTER_CRITICAL(&g_sampler.lock);
+        if (g_sampler.enabled) {
+            for (int i = 0; i < g_sampler.count; i++) {
+                sensor_slot_t *slot = &g_sampler.slots[i];
+                if (slot->init_done && !slot->stats.ready) continue;
+                if (!due || slot->next_due_us < due->next_due_us) {
+                    due = slot;
+                }
+            }
+            if (due && due->next_due_us > now_us) {
+                wait_us = due->next_due_us - now_us;
+                due = NULL;
+            } else if (due) {
+                // Schedule from the due time so the rate doesn't drift,
+                // unless the sensor fell a whole interval behind
+                int64_t interval_us = (int64_t)due->driver->interval_ms * 1000;
+                int64_t next_us = due->next_due_us + interval_us;
+                due->next_due_us = next_us > now_us ? next_us : now_us + interval_us;
+            }
+        }
+        taskEXIT_CRITICAL(&g_sampler.lock);
+
+        if (due) {
+            run_slot(due);
+            continue;
+        }
+        TickType_t wait = wait_us < 0 ? portMAX_DELAY : pdMS_TO_TICKS(wait_us / 1000) + 1;
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+bool sensor_sampler_start(void) {
+    if (g_sampler.task) return true;
+
+    if (xTaskCreatePinnedToCore(sampler_task, "sensor_task", SENSOR_TASK_STACK_SIZE, NULL,
+                                SENSOR_TASK_PRIORITY, &g_sampler.task, SENSOR_SAMPLER_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create sensor sampling task");
+        g_sampler.task = NULL;
+        return false;
+    }
+    return true;
+}
+
+void sensor_sampler_set_enabled(bool enabled) {
+    taskENTER_CRITICAL(&g_sampler.lock);
+    if (enabled && !g_sampler.enabled) {
+        for (int i = 0; i < g_sampler.count; i++) {
+            g_sampler.slots[i].next_due_us = 0;
+        }
+    }
+    g_sampler.enabled = enabled;
+    taskEXIT_CRITICAL(&g_sampler.lock);
+    wake_task();
+}
+
+bool sensor_sampler_get_stats(int index, sensor_sampler_stats_t *out) {
+    if (!out) return false;
+
+    bool found = false;
+    taskENTER_CRITICAL(&g_sampler.lock);
+    if (index >= 0 && index < g_sampler.count) {
+        *out = g_sampler.slots[index].stats;
+        found = true;
+    }
+    taskEXIT_CRITICAL(&g_sampler.lock);
+    return found;
+}
+
+int sensor_sampler_count(void) {
+    taskENTER_CRITICAL(&g_sampler.lock);
+    int count = g_sampler.count;
+    taskEXIT_CRITICAL(&g_sampler.lock);
+    return count;
+}
@@ -0,0 +1,96 @@
+/* Sensor Sampling
+ *
+ * One task samples every registered sensor at its own rate. The task is
+ * pinned away from pc_task, which sends every packet, and sleeps until the
+ * next sensor is due, so idle sensors cost nothing. It shares its core with
+ * the video encoder at a lower priority, so the encoder preempts sampling
+ * and never waits for it.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Most sensors the sampler holds
+#define SENSOR_SAMPLER_MAX_SENSORS 8
+
+// Core for the sampling task; pc_task and the audio encoder run on core 1,
+// venc_0 on core 0 (see thread_placement.c)
+#ifndef SENSOR_SAMPLER_CORE
+#define SENSOR_SAMPLER_CORE 0
+#endif
+
+/**
+ * @brief A sensor driver
+ *
+ * Callbacks run on the sampling task, so a driver can block (for example
+ * waiting for a capture to complete) without holding up the media threads.
+ * The encoder can preempt a callback at any point; a driver with a
+ * timing-critical step must protect it itself (see dht_rmt.c).
+ */
+typedef struct {
+    const char *name;                   /*!< Short name for logs and the console */
+    uint32_t interval_ms;               /*!< Time between two samples */
+    bool (*init)(void *ctx);            /*!< Optional, called once on the sampling task */
+    bool (*sample)(void *ctx);          /*!< Take and publish one sample, false on a failed read */
+    void *ctx;                          /*!< Passed to the callbacks */
+} sensor_driver_t;
+
+/**
+ * @brief Per-sensor counters
+ */
+typedef struct {
+    const char *name;
+    uint32_t interval_ms;
+    bool ready;                         /*!< init succeeded */
+    uint32_t samples;                   /*!< Successful samples */
+    uint32_t failures;                  /*!< Failed samples */
+    uint32_t last_duration_us;          /*!< Time the last sample took */
+} sensor_sampler_stats_t;
+
+/**
+ * @brief Register a sensor, before or after sensor_sampler_start
+ *
+ * @param driver Driver to register, must stay valid while the sampler runs
+ * @return Sensor index, or -1 if the table is full or the driver is invalid
+ */
+int sensor_sampler_register(const sensor_driver_t *driver);
+
+/**
+ * @brief Start the sampling task on SENSOR_SAMPLER_CORE
+ *
+ * @return true on success
+ */
+bool sensor_sampler_start(void);
+
+/**
+ * @brief Pause or resume sampling for every sensor
+ *
+ * While paused the task sleeps; resuming samples every sensor right away.
+ *
+ * @param enabled false to pause
+ */
+void sensor_sampler_set_enabled(bool enabled);
+
+/**
+ * @brief Get the counters of a sensor
+ *
+ * @param index Sensor index from sensor_sampler_register
+ * @param out Counters to fill
+ * @return true if the index is valid
+ */
+bool sensor_sampler_get_stats(int index, sensor_sampler_stats_t *out);
+
+/**
+ * @brief Number of registered sensors
+ */
+int sensor_sampler_count(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,659 @@
+/* Telemetry Log Implementation
+ *
+ * The partition is a ring of 4 KB sectors holding fixed 32-byte slots: a
+ * header slot with the sector's sequence number, then records in sequence
+ * order. Readings queue in a RAM batch under a spinlock; only the log task
+ * reads, writes and erases flash. The number of the last replayed record
+ * is kept in NVS, so a reboot resumes the replay instead of repeating it.
+ *
+ * Flash writes and erases (NVS commits included) stall the caches of both
+ * cores, so they only happen while the stream is down. While streaming the
+ * log reads through a memory mapping and replays the RAM batch from RAM.
+ */
+
+#include "telemetry_log.h"
+#include "settings.h"
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "nvs_storage.h"
+#include "nvs.h"
+#include "latency_probe.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifndef TELEMETRY_LOG_FLUSH_MS
+#define TELEMETRY_LOG_FLUSH_MS 60000
+#endif
+
+#ifndef TELEMETRY_LOG_REPLAY_INTERVAL_MS
+#define TELEMETRY_LOG_REPLAY_INTERVAL_MS 200
+#endif
+
+// A replayed reading not reported sent by then was dropped and is published again
+#ifndef TELEMETRY_LOG_ACK_TIMEOUT_MS
+#define TELEMETRY_LOG_ACK_TIMEOUT_MS 5000
+#endif
+
+#define LOG_TASK_STACK_SIZE 4096
+#define LOG_TASK_PRIORITY 2
+
+#define LOG_SECTOR_SIZE 4096
+#define LOG_SLOT_SIZE 32
+#define LOG_SLOTS_PER_SECTOR (LOG_SECTOR_SIZE / LOG_SLOT_SIZE)
+
+// Header slot: kind marks it, value[0] holds the magic and value[1] the first record seq
+#define LOG_KIND_HEADER 0xA5
+#define LOG_MAGIC 0x474F4C54    // "TLOG"
+
+#define NVS_NAMESPACE "telemetry"
+#define NVS_KEY "replayed"
+
+static const char *TAG = "TELEMETRY_LOG";
+
+/**
+ * @brief One slot as stored in flash
+ */
+typedef struct {
+    uint32_t seq;
+    uint32_t unix_s;
+    uint32_t uptime_ms;
+    uint8_t kind;
+    uint8_t status;
+    uint16_t reserved;          // Left erased
+    int32_t value[2];
+    uint32_t reserved2;         // Left erased
+    uint32_t crc;               // Over the bytes before it
+} log_slot_t;
+
+_Static_assert(sizeof(log_slot_t) == LOG_SLOT_SIZE, "log slot must stay 32 bytes");
+
+typedef struct {
+    const esp_partition_t *partition;
+    const uint8_t *mapped;      // Partition in the data cache, NULL to read through the flash driver
+    uint32_t sectors;
+    telemetry_replay_fn_t replay;
+    void *replay_ctx;
+    TaskHandle_t task;
+
+    // Flash state, log task only
+    int write_sector;           // Sector being filled, -1 before the first write
+    uint32_t write_slot;        // Next free slot in it
+    uint32_t sector_seq;        // Sequence number of the write sector
+    uint32_t flash_last_seq;    // Last record seq in flash
+    int replay_sector;          // Next record to replay, valid while the backlog isn't empty
+    uint32_t replay_slot;
+    uint32_t saved_seq;         // Replay position last stored in NVS
+    log_slot_t cache[TELEMETRY_LOG_BATCH_RECORDS]; // Slots read ahead for the replay
+    int cache_sector;
+    uint32_t cache_slot;
+    uint32_t cache_count;
+    int64_t in_flight_us;       // When the reading in flight was published
+
+    // Shared, under the lock
+    log_slot_t batch[TELEMETRY_LOG_BATCH_RECORDS];
+    int batch_count;
+    int64_t batch_start_us;
+    uint32_t next_seq;
+    uint32_t replayed_seq;      // Last replayed (or discarded) record
+    uint32_t in_flight_seq;     // Reading published and not yet reported sent, 0 if none
+    bool online;
+    bool flush_requested;
+    bool discard_requested;
+    telemetry_log_stats_t stats;
+    portMUX_TYPE lock;
+} telemetry_log_t;
+
+static telemetry_log_t g_log = {
+    .write_sector = -1,
+    .cache_sector = -1,
+    .next_seq = 1,
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static uint32_t slot_crc(const log_slot_t *slot) {
+    return esp_rom_crc32_le(0, (const uint8_t *)slot, offsetof(log_slot_t, crc));
+}
+
+static bool slot_valid(const log_slot_t *slot) {
+    return slot->crc == slot_crc(slot);
+}
+
+static bool slot_empty(const log_slot_t *slot) {
+    const uint32_t *words = (const uint32_t *)slot;
+    for (int i = 0; i < LOG_SLOT_SIZE / 4; i++) {
+        if (words[i] != UINT32_MAX) return false;
+    }
+    return true;
+}
+
+static size_t slot_offset(int sector, uint32_t slot) {
+    return (size_t)sector * LOG_SECTOR_SIZE + slot * LOG_SLOT_SIZE;
+}
+
+static bool read_slots(int sector, uint32_t slot, log_slot_t *out, uint32_t count) {
+    if (g_log.mapped) {
+        memcpy(out, g_log.mapped + slot_offset(sector, slot), count * LOG_SLOT_SIZE);
+        return true;
+    }
+    esp_err_t err = esp_partition_read(g_log.partition, slot_offset(sector, slot), out, count * LOG_SLOT_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Failed to read sector %d: %s", sector, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read the header of a sector
+ *
+ * @return true if the sector holds a log header
+ */
+static bool read_header(int sector, log_slot_t *header) {
+    return read_slots(sector, 0, header, 1) && slot_valid(header) && header->kind == LOG_KIND_HEADER &&
+           header->value[0] == LOG_MAGIC;
+}
+
+/**
+ * @brief Store the replay position in NVS, only called while the stream is down
+ *
+ * A reset while streaming replays again from the last stored position; the
+ * repeated readings keep their log_seq so viewers can drop them.
+ */
+static void save_replay_position(void) {
+    taskENTER_CRITICAL(&g_log.lock);
+    uint32_t replayed_seq = g_log.replayed_seq;
+    taskEXIT_CRITICAL(&g_log.lock);
+    if (replayed_seq == g_log.saved_seq) return;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_u32(handle, NVS_KEY, replayed_seq);
+        if (err == ESP_OK) err = nvs_commit(handle);
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Failed to save the replay position: %s", esp_err_to_name(err));
+        return;
+    }
+    g_log.saved_seq = replayed_seq;
+}
+
+static uint32_t load_replay_position(void) {
+    nvs_handle_t handle;
+    uint32_t replayed_seq = 0;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        nvs_get_u32(handle, NVS_KEY, &replayed_seq);
+        nvs_close(handle);
+    }
+    return replayed_seq;
+}
+
+/**
+ * @brief Erase the next sector of the ring and start it with a header
+ *
+ * The erased sector is the oldest one; if the replay hasn't got past it,
+ * its readings are lost and the replay moves on to the next sector.
+ *
+ * @param first_seq Seq of the first record going into the new sector
+ */
+static bool open_next_sector(uint32_t first_seq) {
+    int sector = g_log.write_sector < 0 ? 0 : (g_log.write_sector + 1) % (int)g_log.sectors;
+    taskENTER_CRITICAL(&g_log.lock);
+    uint32_t replayed_seq = g_log.replayed_seq;
+    taskEXIT_CRITICAL(&g_log.lock);
+
+    if (g_log.write_sector >= 0 && replayed_seq < g_log.flash_last_seq && g_log.replay_sector == sector) {
+        // The oldest readings left start the sector after it, unless that one is unusable too
+        log_slot_t erased, following;
+        int next = (sector + 1) % (int)g_log.sectors;
+        uint32_t oldest_seq = first_seq;
+        if (read_header(sector, &erased) && read_header(next, &following) && following.seq == erased.seq + 1) {
+            oldest_seq = (uint32_t)following.value[1];
+            g_log.replay_sector = next;
+            g_log.replay_slot = 1;
+        }
+        taskENTER_CRITICAL(&g_log.lock);
+        g_log.stats.overwritten += oldest_seq - 1 - g_log.replayed_seq;
+        g_log.replayed_seq = oldest_seq - 1;
+        taskEXIT_CRITICAL(&g_log.lock);
+        ESP_LOGW(TAG, "⚠️ Log full, erasing readings up to %" PRIu32 " before they were replayed", oldest_seq - 1);
+    }
+    if (g_log.cache_sector == sector) {
+        g_log.cache_sector = -1;
+    }
+
+    esp_err_t err = esp_partition_erase_range(g_log.partition, slot_offset(sector, 0), LOG_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Failed to erase sector %d: %s", sector, esp_err_to_name(err));
+        return false;
+    }
+    log_slot_t header;
+    memset(&header, 0xFF, sizeof(header));
+    header.seq = g_log.write_sector < 0 ? 1 : g_log.sector_seq + 1;
+    header.kind = LOG_KIND_HEADER;
+    header.value[0] = LOG_MAGIC;
+    header.value[1] = (int32_t)first_seq;
+    header.crc = slot_crc(&header);
+    err = esp_partition_write(g_log.partition, slot_offset(sector, 0), &header, sizeof(header));
+    taskENTER_CRITICAL(&g_log.lock);
+    g_log.stats.sector_erases++;
+    taskEXIT_CRITICAL(&g_log.lock);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Failed to write sector %d header: %s", sector, esp_err_to_name(err));
+        return false;
+    }
+    g_log.write_sector = sector;
+    g_log.write_slot = 1;
+    g_log.sector_seq = header.seq;
+    return true;
+}
+
+/**
+ * @brief Write a batch, one flash write per sector it lands in
+ */
+static void write_batch(const log_slot_t *slots, int count) {
+    int done = 0;
+    while (done < count) {
+        if (g_log.write_sector < 0 || g_log.write_slot >= LOG_SLOTS_PER_SECTOR) {
+            if (!open_next_sector(slots[done].seq)) return;
+        }
+        taskENTER_CRITICAL(&g_log.lock);
+        bool caught_up = g_log.replayed_seq >= g_log.flash_last_seq;
+        taskEXIT_CRITICAL(&g_log.lock);
+        if (caught_up) {
+            // The replay continues with the first record written here
+            g_log.replay_sector = g_log.write_sector;
+            g_log.replay_slot = g_log.write_slot;
+        }
+
+        uint32_t room = LOG_SLOTS_PER_SECTOR - g_log.write_slot;
+        uint32_t chunk = (uint32_t)(count - done) < room ? (uint32_t)(count - done) : room;
+        esp_err_t err = esp_partition_write(g_log.partition, slot_offset(g_log.write_sector, g_log.write_slot),
+                                            &slots[done], chunk * LOG_SLOT_SIZE);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "❌ Failed to write %" PRIu32 " readings: %s", chunk, esp_err_to_name(err));
+            // Skip the slots, a partial write reads back as invalid
+            g_log.write_slot += chunk;
+            return;
+        }
+        g_log.write_slot += chunk;
+        done += chunk;
+        g_log.flash_last_seq = slots[done - 1].seq;
+        taskENTER_CRITICAL(&g_log.lock);
+        g_log.stats.flash_writes++;
+        taskEXIT_CRITICAL(&g_log.lock);
+    }
+}
+
+/**
+ * @brief Get the slot at the replay position, reading ahead a batch at a time
+ */
+static const log_slot_t *replay_slot(void) {
+    if (g_log.cache_sector != g_log.replay_sector || g_log.replay_slot < g_log.cache_slot ||
+        g_log.replay_slot >= g_log.cache_slot + g_log.cache_count) {
+        uint32_t end = g_log.replay_sector == g_log.write_sector ? g_log.write_slot : LOG_SLOTS_PER_SECTOR;
+        uint32_t count = end - g_log.replay_slot;
+        if (count > TELEMETRY_LOG_BATCH_RECORDS) {
+            count = TELEMETRY_LOG_BATCH_RECORDS;
+        }
+        g_log.cache_sector = -1;
+        if (count == 0 || !read_slots(g_log.replay_sector, g_log.replay_slot, g_log.cache, count)) {
+            return NULL;
+        }
+        g_log.cache_sector = g_log.replay_sector;
+        g_log.cache_slot = g_log.replay_slot;
+        g_log.cache_count = count;
+    }
+    return &g_log.cache[g_log.replay_slot - g_log.cache_slot];
+}
+
+/**
+ * @brief Replay the next logged reading
+ *
+ * @return true if there is more to replay
+ */
+static bool replay_next(void) {
+    taskENTER_CRITICAL(&g_log.lock);
+    uint32_t replayed_seq = g_log.replayed_seq;
+    taskEXIT_CRITICAL(&g_log.lock);
+    const log_slot_t *slot = NULL;
+    log_slot_t batch_slot;
+    while (!slot) {
+        if (replayed_seq >= g_log.flash_last_seq) {
+            // Flash is done; readings that never left the RAM batch come next
+            taskENTER_CRITICAL(&g_log.lock);
+            for (int i = 0; i < g_log.batch_count && !slot; i++) {
+                if (g_log.batch[i].seq > replayed_seq) {
+                    batch_slot = g_log.batch[i];
+                    slot = &batch_slot;
+                }
+            }
+            taskEXIT_CRITICAL(&g_log.lock);
+            if (!slot) {
+                return false;
+            }
+            break;
+        }
+        if (g_log.replay_slot >= LOG_SLOTS_PER_SECTOR) {
+            g_log.replay_sector = (g_log.replay_sector + 1) % (int)g_log.sectors;
+            g_log.replay_slot = 1;
+        }
+        slot = replay_slot();
+        if (!slot) {
+            return false;
+        }
+        if (!slot_valid(slot) || slot->seq <= replayed_seq) {
+            // Torn write or a reading replayed before a reboot
+            g_log.replay_slot++;
+            slot = NULL;
+        }
+    }
+
+    telemetry_record_t record = {
+        .seq = slot->seq,
+        .unix_s = slot->unix_s,
+        .uptime_ms = slot->uptime_ms,
+        .kind = slot->kind,
+        .status = slot->status,
+        .value = {slot->value[0], slot->value[1]},
+    };
+    // One reading in flight; the replay moves on once telemetry_log_mark_replayed reports it sent
+    int64_t now_us = esp_timer_get_time();
+    taskENTER_CRITICAL(&g_log.lock);
+    bool waiting = g_log.in_flight_seq == record.seq &&
+                   now_us - g_log.in_flight_us < (int64_t)TELEMETRY_LOG_ACK_TIMEOUT_MS * 1000;
+    if (!waiting) {
+        g_log.in_flight_seq = record.seq;
+        g_log.in_flight_us = now_us;
+    }
+    taskEXIT_CRITICAL(&g_log.lock);
+    if (waiting) {
+        return true;
+    }
+    if (!g_log.replay(&record, g_log.replay_ctx)) {
+        // SEI is busy, try the same reading next time
+        taskENTER_CRITICAL(&g_log.lock);
+        if (g_log.in_flight_seq == record.seq) {
+            g_log.in_flight_seq = 0;
+        }
+        taskEXIT_CRITICAL(&g_log.lock);
+    }
+    return true;
+}
+
+static void log_task(void *arg) {
+    ESP_LOGI(TAG, "🗃️  Telemetry log task started on core %d", xPortGetCoreID());
+    log_slot_t pending[TELEMETRY_LOG_BATCH_RECORDS];
+    TickType_t wait = portMAX_DELAY;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        // Take the batch once it is full, old enough or asked for, but only
+        // while the stream is down; requests made while streaming wait for it
+        int64_t now_us = esp_timer_get_time();
+        int pending_count = 0;
+        taskENTER_CRITICAL(&g_log.lock);
+        bool online = g_log.online;
+        bool flush_due = !online && g_log.batch_count > 0 &&
+                         (g_log.batch_count == TELEMETRY_LOG_BATCH_RECORDS || g_log.flush_requested ||
+                          now_us - g_log.batch_start_us >= (int64_t)TELEMETRY_LOG_FLUSH_MS * 1000);
+        if (flush_due) {
+            pending_count = g_log.batch_count;
+            memcpy(pending, g_log.batch, pending_count * sizeof(pending[0]));
+            g_log.batch_count = 0;
+        }
+        if (!online) {
+            g_log.flush_requested = false;
+        }
+        bool discard = g_log.discard_requested;
+        if (discard) {
+            // Readings still in RAM are written later and skipped like the rest
+            g_log.replayed_seq = g_log.next_seq - 1;
+            g_log.discard_requested = false;
+        }
+        taskEXIT_CRITICAL(&g_log.lock);
+
+        if (discard) {
+            ESP_LOGI(TAG, "🗑️  Telemetry backlog discarded");
+        }
+        if (pending_count > 0) {
+            write_batch(pending, pending_count);
+        }
+
+        taskENTER_CRITICAL(&g_log.lock);
+        int batch_count = g_log.batch_count;
+        int64_t flush_at_us = g_log.batch_start_us + (int64_t)TELEMETRY_LOG_FLUSH_MS * 1000;
+        taskEXIT_CRITICAL(&g_log.lock);
+
+        bool more = online && replay_next();
+        if (!online) {
+            save_replay_position();
+        }
+
+        // Sleep until the next replay or the batch is due, or until woken
+        wait = portMAX_DELAY;
+        if (more) {
+            wait = pdMS_TO_TICKS(TELEMETRY_LOG_REPLAY_INTERVAL_MS);
+        } else if (!online && batch_count > 0) {
+            int64_t remaining_us = flush_at_us - esp_timer_get_time();
+            wait = remaining_us > 0 ? pdMS_TO_TICKS(remaining_us / 1000) + 1 : 0;
+        }
+    }
+}
+
+/**
+ * @brief Find the write position and the first reading not replayed yet
+ */
+static void mount(void) {
+    // The newest sector has the highest header seq
+    log_slot_t header;
+    int newest = -1;
+    for (uint32_t sector = 0; sector < g_log.sectors; sector++) {
+        if (read_header((int)sector, &header) && (newest < 0 || header.seq > g_log.sector_seq)) {
+            newest = (int)sector;
+            g_log.sector_seq = header.seq;
+        }
+    }
+    uint32_t replayed_seq = load_replay_position();
+    g_log.saved_seq = replayed_seq;
+    if (newest < 0) {
+        // Fresh partition, the first batch formats sector 0
+        taskENTER_CRITICAL(&g_log.lock);
+        g_log.replayed_seq = 0;
+        taskEXIT_CRITICAL(&g_log.lock);
+        return;
+    }
+
+    // Records fill a sector from the front, the slot after the last used one is free
+    read_header(newest, &header);
+    g_log.write_sector = newest;
+    g_log.write_slot = 1;
+    g_log.flash_last_seq = (uint32_t)header.value[1] - 1;
+    for (uint32_t slot = 1; slot < LOG_SLOTS_PER_SECTOR; slot += TELEMETRY_LOG_BATCH_RECORDS) {
+        uint32_t count = LOG_SLOTS_PER_SECTOR - slot;
+        if (count > TELEMETRY_LOG_BATCH_RECORDS) {
+            count = TELEMETRY_LOG_BATCH_RECORDS;
+        }
+        if (!read_slots(newest, slot, g_log.cache, count)) break;
+        for (uint32_t i = 0; i < count; i++) {
+            if (slot_empty(&g_log.cache[i])) continue;
+            g_log.write_slot = slot + i + 1;
+            if (slot_valid(&g_log.cache[i])) {
+                g_log.flash_last_seq = g_log.cache[i].seq;
+            }
+        }
+    }
+
+    // Walk back from the newest sector to the one holding the first reading not replayed
+    if (replayed_seq > g_log.flash_last_seq) {
+        replayed_seq = 0;
+    }
+    uint32_t oldest_first_seq = (uint32_t)header.value[1];
+    g_log.replay_sector = newest;
+    g_log.replay_slot = 1;
+    for (uint32_t back = 1; back < g_log.sectors; back++) {
+        int sector = (newest - (int)back + (int)g_log.sectors) % (int)g_log.sectors;
+        if (oldest_first_seq <= replayed_seq + 1) break;
+        if (!read_header(sector, &header) || header.seq != g_log.sector_seq - back) break;
+        oldest_first_seq = (uint32_t)header.value[1];
+        g_log.replay_sector = sector;
+    }
+    if (replayed_seq + 1 < oldest_first_seq) {
+        // Readings older than the ring were erased before they were replayed
+        replayed_seq = oldest_first_seq - 1;
+    }
+    taskENTER_CRITICAL(&g_log.lock);
+    g_log.replayed_seq = replayed_seq;
+    g_log.next_seq = g_log.flash_last_seq + 1;
+    taskEXIT_CRITICAL(&g_log.lock);
+}
+
+bool telemetry_log_init(telemetry_replay_fn_t replay, void *ctx) {
+    if (g_log.task) return true;
+    if (!replay) return false;
+
+    g_log.partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                               TELEMETRY_LOG_PARTITION);
+    if (!g_log.partition || g_log.partition->size < 2 * LOG_SECTOR_SIZE) {
+        ESP_LOGE(TAG, "❌ No \"%s\" partition of at least 8 KB, readings taken offline are dropped",
+                 TELEMETRY_LOG_PARTITION);
+        return false;
+    }
+    if (!nvs_storage_init()) {
+        ESP_LOGW(TAG, "⚠️ NVS not available, replay restarts from the oldest reading after a reboot");
+    }
+    // Reads through the cache don't stall the other core like the flash driver does
+    esp_partition_mmap_handle_t mmap_handle;
+    if (esp_partition_mmap(g_log.partition, 0, g_log.partition->size, ESP_PARTITION_MMAP_DATA,
+                           (const void **)&g_log.mapped, &mmap_handle) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Failed to map the log partition, reading through the flash driver");
+        g_log.mapped = NULL;
+    }
+    g_log.sectors = g_log.partition->size / LOG_SECTOR_SIZE;
+    g_log.replay = replay;
+    g_log.replay_ctx = ctx;
+    mount();
+
+    taskENTER_CRITICAL(&g_log.lock);
+    g_log.stats.mounted = true;
+    g_log.stats.sectors = g_log.sectors;
+    g_log.stats.capacity = (g_log.sectors - 1) * (LOG_SLOTS_PER_SECTOR - 1);
+    uint32_t backlog = g_log.next_seq - 1 - g_log.replayed_seq;
+    taskEXIT_CRITICAL(&g_log.lock);
+
+    if (xTaskCreatePinnedToCore(log_task, "telemetry_log", LOG_TASK_STACK_SIZE, NULL, LOG_TASK_PRIORITY,
+                                &g_log.task, TELEMETRY_LOG_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create telemetry log task");
+        g_log.task = NULL;
+        taskENTER_CRITICAL(&g_log.lock);
+        g_log.stats.mounted = false;
+        taskEXIT_CRITICAL(&g_log.lock);
+        return false;
+    }
+    ESP_LOGI(TAG, "🗃️  Telemetry log: %" PRIu32 " sectors, %" PRIu32 " readings waiting for replay",
+             g_log.sectors, backlog);
+    return true;
+}
+
+bool telemetry_log_append(const telemetry_record_t *record) {
+    if (!record) return false;
+
+    log_slot_t slot;
+    memset(&slot, 0xFF, sizeof(slot));
+    slot.unix_s = (uint32_t)(latency_probe_unix_time_us() / 1000000);
+    slot.uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    slot.kind = record->kind;
+    slot.status = record->status;
+    slot.value[0] = record->value[0];
+    slot.value[1] = record->value[1];
+
+    bool added = false;
+    bool wake = false;
+    taskENTER_CRITICAL(&g_log.lock);
+    if (g_log.stats.mounted && g_log.batch_count < TELEMETRY_LOG_BATCH_RECORDS) {
+        slot.seq = g_log.next_seq++;
+        slot.crc = slot_crc(&slot);
+        if (g_log.batch_count == 0) {
+            g_log.batch_start_us = esp_timer_get_time();
+        }
+        g_log.batch[g_log.batch_count++] = slot;
+        g_log.stats.appended++;
+        // A full batch is written now, a new one needs its flush scheduled
+        wake = g_log.batch_count == TELEMETRY_LOG_BATCH_RECORDS || g_log.batch_count == 1;
+        added = true;
+    }
+    taskEXIT_CRITICAL(&g_log.lock);
+
+    if (wake) {
+        xTaskNotifyGive(g_log.task);
+    }
+    return added;
+}
+
+void telemetry_log_mark_replayed(uint32_t seq) {
+    bool sent = false;
+    taskENTER_CRITICAL(&g_log.lock);
+    if (seq != 0 && seq == g_log.in_flight_seq) {
+        g_log.in_flight_seq = 0;
+        // Kept in RAM until the stream is down, see save_replay_position
+        if (seq > g_log.replayed_seq) {
+            g_log.replayed_seq = seq;
+            g_log.stats.replayed++;
+        }
+        sent = true;
+    }
+    taskEXIT_CRITICAL(&g_log.lock);
+    if (sent && g_log.task) {
+        xTaskNotifyGive(g_log.task);
+    }
+}
+
+void telemetry_log_set_online(bool online) {
+    taskENTER_CRITICAL(&g_log.lock);
+    bool changed = g_log.online != online;
+    g_log.online = online;
+    taskEXIT_CRITICAL(&g_log.lock);
+    if (changed && g_log.task) {
+        xTaskNotifyGive(g_log.task);
+    }
+}
+
+bool telemetry_log_is_online(void) {
+    taskENTER_CRITICAL(&g_log.lock);
+    bool online = g_log.online;
+    taskEXIT_CRITICAL(&g_log.lock);
+    return online;
+}
+
+void telemetry_log_flush(void) {
+    if (!g_log.task) return;
+    taskENTER_CRITICAL(&g_log.lock);
+    g_log.flush_requested = true;
+    taskEXIT_CRITICAL(&g_log.lock);
+    xTaskNotifyGive(g_log.task);
+}
+
+void telemetry_log_discard(void) {
+    if (!g_log.task) return;
+    // Readings still in RAM are written first, then skipped like the rest
+    taskENTER_CRITICAL(&g_log.lock);
+    g_log.flush_requested = true;
+    g_log.discard_requested = true;
+    taskEXIT_CRITICAL(&g_log.lock);
+    xTaskNotifyGive(g_log.task);
+}
+
+void telemetry_log_get_stats(telemetry_log_stats_t *out) {
+    if (!out) return;
+
+    taskENTER_CRITICAL(&g_log.lock);
+    *out = g_log.stats;
+    out->online = g_log.online;
+    out->backlog = g_log.next_seq - 1 - g_log.replayed_seq;
+    taskEXIT_CRITICAL(&g_log.lock);
+}
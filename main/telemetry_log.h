@@ -0,0 +1,150 @@
+/* Telemetry Log
+ *
+ * Append-only ring log of telemetry readings in the "telemetry" flash
+ * partition, kept while the stream is down and replayed through SEI once
+ * it is back. Readings are batched in RAM and written by the log's own
+ * task, away from the media core, and the log moves through the
+ * partition's sectors in turn, so every sector is erased equally often.
+ * Nothing is written, erased or committed to NVS while the stream is up.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Label of the flash partition holding the log (see partitions.csv)
+#define TELEMETRY_LOG_PARTITION "telemetry"
+
+// Readings held in RAM before they are written in one go
+#define TELEMETRY_LOG_BATCH_RECORDS 16
+
+// Core for the log task; pc_task runs on core 1 (see thread_placement.c)
+#ifndef TELEMETRY_LOG_CORE
+#define TELEMETRY_LOG_CORE 0
+#endif
+
+/**
+ * @brief Kinds of logged readings
+ */
+typedef enum {
+    TELEMETRY_KIND_DHT11 = 1,   /*!< value[0] tenths of a degree Celsius, value[1] tenths of a percent */
+} telemetry_kind_t;
+
+/**
+ * @brief One logged reading
+ */
+typedef struct {
+    uint32_t seq;               /*!< Log sequence number, assigned on append */
+    uint32_t unix_s;            /*!< Wall-clock time of the reading, 0 if the clock wasn't set */
+    uint32_t uptime_ms;         /*!< Time since boot of the reading, from the boot that logged it */
+    uint8_t kind;               /*!< telemetry_kind_t */
+    uint8_t status;             /*!< 0 for a good reading, else a kind-specific error */
+    int32_t value[2];           /*!< Kind-specific values */
+} telemetry_record_t;
+
+/**
+ * @brief Publish one logged reading while replaying
+ *
+ * Runs on the log task. The replay waits for telemetry_log_mark_replayed
+ * with the reading's seq before it moves on, and publishes the reading
+ * again if that doesn't come within TELEMETRY_LOG_ACK_TIMEOUT_MS.
+ *
+ * @param record Reading to publish
+ * @param ctx Pointer given to telemetry_log_init
+ * @return false to try the same reading again later (SEI queue busy)
+ */
+typedef bool (*telemetry_replay_fn_t)(const telemetry_record_t *record, void *ctx);
+
+/**
+ * @brief Log counters
+ */
+typedef struct {
+    bool mounted;               /*!< Partition found and scanned */
+    bool online;                /*!< Stream up, readings are replayed instead of logged */
+    uint32_t sectors;           /*!< Sectors of the partition */
+    uint32_t capacity;          /*!< Readings the partition holds before the oldest are erased */
+    uint32_t backlog;           /*!< Logged readings not replayed yet, including the RAM batch */
+    uint32_t appended;          /*!< Readings appended since boot */
+    uint32_t replayed;          /*!< Readings replayed and reported sent since boot */
+    uint32_t overwritten;       /*!< Readings erased before they were replayed, since boot */
+    uint32_t flash_writes;      /*!< Batch writes since boot */
+    uint32_t sector_erases;     /*!< Sector erases since boot */
+} telemetry_log_stats_t;
+
+/**
+ * @brief Mount the log partition and start the log task on TELEMETRY_LOG_CORE
+ *
+ * Scans the partition for the newest sector and the first reading not
+ * replayed yet. Without the partition, readings logged while offline are
+ * dropped.
+ *
+ * @param replay Callback publishing replayed readings
+ * @param ctx Passed to the callback
+ * @return true on success
+ */
+bool telemetry_log_init(telemetry_replay_fn_t replay, void *ctx);
+
+/**
+ * @brief Add a reading to the RAM batch, safe from any task
+ *
+ * Never touches flash; the log task writes the batch once it is full or
+ * TELEMETRY_LOG_FLUSH_MS after its first reading, while the stream is down.
+ *
+ * @param record Reading, seq is assigned here
+ * @return false if the log isn't mounted or it is falling behind
+ */
+bool telemetry_log_append(const telemetry_record_t *record);
+
+/**
+ * @brief Report a replayed reading as sent, safe from any task
+ *
+ * Call once the reading is in a frame on its way to viewers (for example
+ * from sei_publish_opts_t.on_sent), or right away for a reading that is
+ * skipped. Only then does the replay position pass it.
+ *
+ * @param seq Seq of the reading given to the replay callback
+ */
+void telemetry_log_mark_replayed(uint32_t seq);
+
+/**
+ * @brief Tell the log whether the stream is up
+ *
+ * Going online starts replaying the backlog, at one reading per
+ * TELEMETRY_LOG_REPLAY_INTERVAL_MS: first from flash, then the readings
+ * still in the RAM batch. The batch and the replay position are written
+ * once the stream is down again.
+ *
+ * @param online true while SEI reaches viewers
+ */
+void telemetry_log_set_online(bool online);
+
+/**
+ * @brief Whether the stream is up, so readings go to SEI instead of the log
+ */
+bool telemetry_log_is_online(void);
+
+/**
+ * @brief Write out the RAM batch now, from the log task
+ *
+ * Deferred until the stream is down.
+ */
+void telemetry_log_flush(void);
+
+/**
+ * @brief Forget the backlog without replaying it
+ */
+void telemetry_log_discard(void);
+
+/**
+ * @brief Get the log counters
+ */
+void telemetry_log_get_stats(telemetry_log_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
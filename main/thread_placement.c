@@ -0,0 +1,386 @@
+/* Thread Placement Implementation
+ *
+ * Built-in table plus overrides parsed from "name:stack:prio:core[:ext|int]"
+ * lists, entries separated by commas and '-' keeping a field. settings.h
+ * gives the build-time list, NVS the one set from the console; NVS entries
+ * win over settings.h entries for the same name
+ */
+
+#include "thread_placement.h"
+#include "settings.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "nvs_storage.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "THREAD_PLACEMENT";
+
+#ifndef THREAD_PLACEMENT_OVERRIDES
+#define THREAD_PLACEMENT_OVERRIDES ""
+#endif
+
+#define NVS_NAMESPACE "thread_cfg"
+#define NVS_KEY "overrides"
+#define OVERRIDE_TEXT_MAX (THREAD_PLACEMENT_MAX_OVERRIDES * 48)
+
+#define KEEP THREAD_PLACEMENT_KEEP
+
+// pc_task sends every packet and gets a core of its own with the audio
+// encoder (light next to H.264); the video encoder runs on the other core.
+// Threads not listed keep the library settings
+static const thread_placement_t s_table[] = {
+#if CONFIG_IDF_TARGET_ESP32S3
+    // Software H.264 needs a large stack, a hardware encoder a small one
+    { "venc_0", 20 * 1024, 10, 0, KEEP },
+#else
+    { "venc_0", KEEP, 10, 0, KEEP },
+#endif
+#ifdef WEBRTC_SUPPORT_OPUS
+    // The OPUS encoder needs a huge stack, especially on ESP32-P4
+    { "aenc_0", 128 * 1024, 10, 1, 1 },
+#else
+    { "aenc_0", KEEP, KEEP, 1, KEEP },
+#endif
+    { "AUD_SRC", KEEP, 15, KEEP, KEEP },
+    { "pc_task", 25 * 1024, 18, 1, KEEP },
+    { "start", 6 * 1024, KEEP, KEEP, KEEP },
+};
+
+#define TABLE_SIZE (int)(sizeof(s_table) / sizeof(s_table[0]))
+
+typedef struct {
+    thread_placement_t placement;
+    bool from_nvs;
+} placement_override_t;
+
+typedef struct {
+    placement_override_t overrides[THREAD_PLACEMENT_MAX_OVERRIDES];
+    int override_count;
+    thread_usage_t threads[THREAD_PLACEMENT_MAX_THREADS];
+    int thread_count;
+    portMUX_TYPE lock;
+} thread_placement_state_t;
+
+static thread_placement_state_t g_state = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static bool name_matches(const char *pattern, const char *name) {
+    size_t len = strlen(pattern);
+    if (len > 0 && pattern[len - 1] == '*') {
+        return strncmp(pattern, name, len - 1) == 0;
+    }
+    return strcmp(pattern, name) == 0;
+}
+
+static int parse_field(const char *text, int min, int max, int *out) {
+    if (text[0] == '\0' || strcmp(text, "-") == 0) {
+        *out = KEEP;
+        return 0;
+    }
+    char *end;
+    long value = strtol(text, &end, 0);
+    if (*end != '\0' || value < min || value > max) return -1;
+    *out = (int)value;
+    return 0;
+}
+
+/**
+ * @brief Parse one "name:stack:prio:core[:ext|int]" entry
+ */
+static bool parse_entry(char *entry, thread_placement_t *out) {
+    char *fields[5] = {0};
+    int count = 0;
+    for (char *save = NULL, *field = strtok_r(entry, ":", &save); field && count < 5;
+         field = strtok_r(NULL, ":", &save)) {
+        fields[count++] = field;
+    }
+    if (count < 4 || strlen(fields[0]) >= THREAD_PLACEMENT_NAME_LEN) return false;
+
+    int stack_size, priority, core_id;
+    if (parse_field(fields[1], 1024, 1024 * 1024, &stack_size) ||
+        parse_field(fields[2], 0, configMAX_PRIORITIES - 1, &priority) ||
+        parse_field(fields[3], 0, portNUM_PROCESSORS - 1, &core_id)) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    strcpy(out->name, fields[0]);
+    out->stack_size = stack_size;
+    out->priority = (int8_t)priority;
+    out->core_id = (int8_t)core_id;
+    out->stack_in_ext = KEEP;
+    if (count == 5) {
+        if (strcmp(fields[4], "ext") == 0) {
+            out->stack_in_ext = 1;
+        } else if (strcmp(fields[4], "int") == 0) {
+            out->stack_in_ext = 0;
+        } else if (strcmp(fields[4], "-") != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Add or replace an override, caller holds the lock
+ */
+static bool put_override(const thread_placement_t *placement, bool from_nvs) {
+    int slot = -1;
+    for (int i = 0; i < g_state.override_count; i++) {
+        if (strcmp(g_state.overrides[i].placement.name, placement->name) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        if (g_state.override_count >= THREAD_PLACEMENT_MAX_OVERRIDES) return false;
+        slot = g_state.override_count++;
+    }
+    g_state.overrides[slot].placement = *placement;
+    g_state.overrides[slot].from_nvs = from_nvs;
+    return true;
+}
+
+static void load_overrides(const char *text, bool from_nvs, const char *source) {
+    char buffer[OVERRIDE_TEXT_MAX];
+    if (strlen(text) >= sizeof(buffer)) {
+        ESP_LOGW(TAG, "⚠️ Thread overrides from %s too long, ignored", source);
+        return;
+    }
+    strcpy(buffer, text);
+    for (char *save = NULL, *entry = strtok_r(buffer, ",", &save); entry; entry = strtok_r(NULL, ",", &save)) {
+        char copy[64];
+        snprintf(copy, sizeof(copy), "%s", entry);
+        thread_placement_t placement;
+        if (!parse_entry(entry, &placement)) {
+            ESP_LOGW(TAG, "⚠️ Bad thread override '%s' from %s", copy, source);
+            continue;
+        }
+        taskENTER_CRITICAL(&g_state.lock);
+        bool stored = put_override(&placement, from_nvs);
+        taskEXIT_CRITICAL(&g_state.lock);
+        if (!stored) {
+            ESP_LOGW(TAG, "⚠️ Too many thread overrides, '%s' ignored", copy);
+        } else {
+            ESP_LOGI(TAG, "🧵 Thread override from %s: %s", source, copy);
+        }
+    }
+}
+
+static void format_field(char *out, size_t size, int value) {
+    if (value == KEEP) {
+        snprintf(out, size, "-");
+    } else {
+        snprintf(out, size, "%d", value);
+    }
+}
+
+/**
+ * @brief Write the NVS-sourced overrides back to NVS
+ */
+static bool save_overrides(void) {
+    char text[OVERRIDE_TEXT_MAX] = "";
+    size_t len = 0;
+
+    // Copy out under the spinlock, format with interrupts enabled
+    placement_override_t overrides[THREAD_PLACEMENT_MAX_OVERRIDES];
+    taskENTER_CRITICAL(&g_state.lock);
+    int count = g_state.override_count;
+    memcpy(overrides, g_state.overrides, count * sizeof(overrides[0]));
+    taskEXIT_CRITICAL(&g_state.lock);
+
+    for (int i = 0; i < count; i++) {
+        const thread_placement_t *p = &overrides[i].placement;
+        if (!overrides[i].from_nvs) continue;
+        char stack[12], priority[8], core[8];
+        format_field(stack, sizeof(stack), p->stack_size);
+        format_field(priority, sizeof(priority), p->priority);
+        format_field(core, sizeof(core), p->core_id);
+        const char *ext = p->stack_in_ext == KEEP ? "-" : p->stack_in_ext ? "ext" : "int";
+        len += snprintf(text + len, sizeof(text) - len, "%s%s:%s:%s:%s:%s", len ? "," : "", p->name, stack,
+                        priority, core, ext);
+        if (len >= sizeof(text)) break;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = text[0] ? nvs_set_str(handle, NVS_KEY, text) : nvs_erase_key(handle, NVS_KEY);
+        if (err == ESP_ERR_NVS_NOT_FOUND) err = ESP_OK;
+        if (err == ESP_OK) err = nvs_commit(handle);
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Failed to save thread overrides: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+bool thread_placement_init(void) {
+    load_overrides(THREAD_PLACEMENT_OVERRIDES, false, "settings.h");
+
+    if (!nvs_storage_init()) {
+        ESP_LOGW(TAG, "⚠️ NVS not available, thread overrides from settings.h only");
+        return false;
+    }
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) return true;   // Nothing stored yet
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Failed to open thread overrides: %s", esp_err_to_name(err));
+        return false;
+    }
+    char text[OVERRIDE_TEXT_MAX];
+    size_t size = sizeof(text);
+    err = nvs_get_str(handle, NVS_KEY, text, &size);
+    nvs_close(handle);
+    if (err == ESP_OK) {
+        load_overrides(text, true, "NVS");
+    } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "⚠️ Failed to read thread overrides: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+static void merge(thread_placement_t *into, const thread_placement_t *from) {
+    if (from->stack_size != KEEP) into->stack_size = from->stack_size;
+    if (from->priority != KEEP) into->priority = from->priority;
+    if (from->core_id != KEEP) into->core_id = from->core_id;
+    if (from->stack_in_ext != KEEP) into->stack_in_ext = from->stack_in_ext;
+}
+
+bool thread_placement_lookup(const char *name, thread_placement_t *out) {
+    if (!name || !out) return false;
+
+    bool found = false;
+    memset(out, 0, sizeof(*out));
+    snprintf(out->name, sizeof(out->name), "%s", name);
+    out->stack_size = KEEP;
+    out->priority = KEEP;
+    out->core_id = KEEP;
+    out->stack_in_ext = KEEP;
+
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        if (name_matches(s_table[i].name, name)) {
+            merge(out, &s_table[i]);
+            found = true;
+            break;
+        }
+    }
+    taskENTER_CRITICAL(&g_state.lock);
+    for (int i = 0; i < g_state.override_count; i++) {
+        if (name_matches(g_state.overrides[i].placement.name, name)) {
+            merge(out, &g_state.overrides[i].placement);
+            found = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&g_state.lock);
+    return found;
+}
+
+void thread_placement_record(const char *name, uint32_t stack_size, uint8_t priority, int8_t core_id,
+                             bool stack_in_ext) {
+    if (!name) return;
+
+    taskENTER_CRITICAL(&g_state.lock);
+    int slot = -1;
+    for (int i = 0; i < g_state.thread_count; i++) {
+        if (strncmp(g_state.threads[i].name, name, THREAD_PLACEMENT_NAME_LEN - 1) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0 && g_state.thread_count < THREAD_PLACEMENT_MAX_THREADS) {
+        slot = g_state.thread_count++;
+    }
+    if (slot >= 0) {
+        thread_usage_t *thread = &g_state.threads[slot];
+        snprintf(thread->name, sizeof(thread->name), "%s", name);
+        thread->stack_size = stack_size;
+        thread->priority = priority;
+        thread->core_id = core_id;
+        thread->stack_in_ext = stack_in_ext;
+        thread->running = true;
+        thread->min_free = stack_size;  // A new thread starts a new measurement
+    }
+    taskEXIT_CRITICAL(&g_state.lock);
+}
+
+bool thread_placement_set_override(const thread_placement_t *placement) {
+    if (!placement || placement->name[0] == '\0') return false;
+
+    taskENTER_CRITICAL(&g_state.lock);
+    bool stored = put_override(placement, true);
+    taskEXIT_CRITICAL(&g_state.lock);
+    return stored && save_overrides();
+}
+
+bool thread_placement_clear_override(const char *name) {
+    if (!name) return false;
+
+    bool removed = false;
+    taskENTER_CRITICAL(&g_state.lock);
+    for (int i = 0; i < g_state.override_count; i++) {
+        if (g_state.overrides[i].from_nvs && strcmp(g_state.overrides[i].placement.name, name) == 0) {
+            g_state.overrides[i] = g_state.overrides[--g_state.override_count];
+            removed = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&g_state.lock);
+    return removed && save_overrides();
+}
+
+int thread_placement_get_table(thread_placement_t *out, bool *is_override, int max_count) {
+    if (!out || max_count <= 0) return 0;
+
+    int count = 0;
+    for (int i = 0; i < TABLE_SIZE && count < max_count; i++, count++) {
+        out[count] = s_table[i];
+        if (is_override) is_override[count] = false;
+    }
+    taskENTER_CRITICAL(&g_state.lock);
+    for (int i = 0; i < g_state.override_count && count < max_count; i++, count++) {
+        out[count] = g_state.overrides[i].placement;
+        if (is_override) is_override[count] = true;
+    }
+    taskEXIT_CRITICAL(&g_state.lock);
+    return count;
+}
+
+int thread_placement_get_usage(thread_usage_t *out, int max_count) {
+    if (!out || max_count <= 0) return 0;
+
+    taskENTER_CRITICAL(&g_state.lock);
+    int count = g_state.thread_count < max_count ? g_state.thread_count : max_count;
+    memcpy(out, g_state.threads, count * sizeof(thread_usage_t));
+    taskEXIT_CRITICAL(&g_state.lock);
+
+    // xTaskGetHandle walks the task lists, so run it outside the spinlock.
+    // ESP-IDF stack types are bytes, so the high-water mark is in bytes
+    for (int i = 0; i < count; i++) {
+        TaskHandle_t task = xTaskGetHandle(out[i].name);
+        out[i].running = task != NULL;
+        if (task) {
+            uint32_t free_bytes = uxTaskGetStackHighWaterMark(task);
+            if (free_bytes < out[i].min_free) out[i].min_free = free_bytes;
+        }
+    }
+
+    taskENTER_CRITICAL(&g_state.lock);
+    for (int i = 0; i < count && i < g_state.thread_count; i++) {
+        if (strcmp(g_state.threads[i].name, out[i].name) == 0) {
+            g_state.threads[i].running = out[i].running;
+            g_state.threads[i].min_free = out[i].min_free;
+        }
+    }
+    taskEXIT_CRITICAL(&g_state.lock);
+    return count;
+}
@@ -0,0 +1,122 @@
+/* Thread Placement
+ *
+ * Table of core, priority and stack settings for the media threads created
+ * through the media_lib and esp_capture schedulers, with overrides from
+ * settings.h and NVS, and a stack high-water report for sizing the stacks
+ * from measurements.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Field value that keeps what the library asked for
+#define THREAD_PLACEMENT_KEEP -1
+
+// Longest thread name kept, including the terminator (FreeRTOS default)
+#define THREAD_PLACEMENT_NAME_LEN 16
+
+// Overrides held at once, from settings.h and NVS together
+#define THREAD_PLACEMENT_MAX_OVERRIDES 12
+
+// Threads remembered for the stack report
+#define THREAD_PLACEMENT_MAX_THREADS 24
+
+/**
+ * @brief Placement of one thread
+ */
+typedef struct {
+    char name[THREAD_PLACEMENT_NAME_LEN];   /*!< Thread name, or a prefix when it ends with '*' */
+    int32_t stack_size;                     /*!< Stack bytes, or THREAD_PLACEMENT_KEEP */
+    int8_t priority;                        /*!< FreeRTOS priority, or THREAD_PLACEMENT_KEEP */
+    int8_t core_id;                         /*!< Core, or THREAD_PLACEMENT_KEEP */
+    int8_t stack_in_ext;                    /*!< 1 PSRAM, 0 internal RAM, or THREAD_PLACEMENT_KEEP
+                                                 (only esp_capture threads can choose) */
+} thread_placement_t;
+
+/**
+ * @brief A thread created with a placement, for the stack report
+ */
+typedef struct {
+    char name[THREAD_PLACEMENT_NAME_LEN];
+    uint32_t stack_size;                    /*!< Stack it was created with */
+    uint8_t priority;
+    int8_t core_id;
+    bool stack_in_ext;
+    bool running;                           /*!< Thread still exists */
+    uint32_t min_free;                      /*!< Lowest free stack seen by a report, bytes */
+} thread_usage_t;
+
+/**
+ * @brief Load the overrides from settings.h and NVS
+ *
+ * Call once before the media system is built. Later lookups don't touch
+ * flash, so they are safe from threads with PSRAM stacks.
+ *
+ * @return true on success (a missing NVS entry is not an error)
+ */
+bool thread_placement_init(void);
+
+/**
+ * @brief Resolve the placement of a thread about to be created
+ *
+ * The settings of the table entry are combined with any override; fields
+ * both leave at THREAD_PLACEMENT_KEEP keep the library value.
+ *
+ * @param name Thread name
+ * @param out Placement to fill
+ * @return true if the table or an override knows the thread
+ */
+bool thread_placement_lookup(const char *name, thread_placement_t *out);
+
+/**
+ * @brief Remember a thread for the stack report
+ */
+void thread_placement_record(const char *name, uint32_t stack_size, uint8_t priority, int8_t core_id,
+                             bool stack_in_ext);
+
+/**
+ * @brief Store an override in NVS
+ *
+ * Applies to threads created afterwards, for example on the next stream.
+ *
+ * @param placement Settings to store, THREAD_PLACEMENT_KEEP fields fall back to the table
+ * @return true on success
+ */
+bool thread_placement_set_override(const thread_placement_t *placement);
+
+/**
+ * @brief Remove the NVS override of a thread
+ *
+ * @param name Thread name or prefix as stored
+ * @return true if an override was removed
+ */
+bool thread_placement_clear_override(const char *name);
+
+/**
+ * @brief Get the effective table: built-in entries followed by overrides
+ *
+ * @param out Array to fill
+ * @param max_count Capacity of out
+ * @param is_override Optional array marking the entries that come from an override
+ * @return Number of entries copied
+ */
+int thread_placement_get_table(thread_placement_t *out, bool *is_override, int max_count);
+
+/**
+ * @brief Sample the stack high-water mark of every recorded thread
+ *
+ * @param out Array to fill
+ * @param max_count Capacity of out
+ * @return Number of threads copied
+ */
+int thread_placement_get_usage(thread_usage_t *out, int max_count);
+
+#ifdef __cplusplus
+}
+#endif
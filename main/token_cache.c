@@ -0,0 +1,259 @@
+/* Participant Token Cache Implementation
+ *
+ * One background task owns the HTTP client and does every fetch; callers
+ * only copy the cached token out under a mutex
+ */
+
+#include "token_cache.h"
+#include "settings.h"
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "cJSON.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+static const char *TAG = "TOKEN_CACHE";
+
+// clang-format off
+#define TOKEN_REQUEST_BODY                                                     \
+  "{\"stageArn\": \"" STAGE_ARN "\", \"capabilities\": [\"PUBLISH\"]," \
+  "\"attributes\": {\"username\": \"" PARTICIPANT_NAME "\"}}"
+// clang-format on
+
+// The response carries the token plus a few short attributes
+#define TOKEN_RESPONSE_MAX_LEN (TOKEN_CACHE_MAX_LEN + 512)
+
+#define TOKEN_TASK_STACK_SIZE 6144
+#define TOKEN_TASK_PRIORITY 4
+#define TOKEN_HTTP_TIMEOUT_MS 10000
+
+#define TOKEN_VALID_BIT BIT0
+
+typedef struct {
+    // Cached token, guarded by lock
+    char token[TOKEN_CACHE_MAX_LEN];
+    int64_t expires_us;         // esp_timer time the token expires, 0 if none
+    int64_t refresh_us;         // esp_timer time to fetch the next one
+    SemaphoreHandle_t lock;
+    EventGroupHandle_t events;  // TOKEN_VALID_BIT while a token is cached
+    TaskHandle_t task;
+    volatile bool network_up;
+
+    // Owned by the token task
+    esp_http_client_handle_t client;
+    char response[TOKEN_RESPONSE_MAX_LEN];
+    int response_len;
+    bool response_overflow;
+} token_cache_t;
+
+static token_cache_t g_cache;
+
+static esp_err_t token_http_event_handler(esp_http_client_event_t *evt) {
+    token_cache_t *cache = evt->user_data;
+    if (evt->event_id == HTTP_EVENT_ON_DATA) {
+        if (cache->response_len + evt->data_len < TOKEN_RESPONSE_MAX_LEN) {
+            memcpy(cache->response + cache->response_len, evt->data, evt->data_len);
+            cache->response_len += evt->data_len;
+            cache->response[cache->response_len] = '\0';
+        } else {
+            cache->response_overflow = true;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Create the persistent client on first use
+ */
+static bool ensure_client(void) {
+    if (g_cache.client) return true;
+
+    esp_http_client_config_t config = {
+        .url = TOKEN_API_URL,
+        .method = HTTP_METHOD_POST,
+        .event_handler = token_http_event_handler,
+        .user_data = &g_cache,
+        .timeout_ms = TOKEN_HTTP_TIMEOUT_MS,
+        .crt_bundle_attach = esp_crt_bundle_attach, // Use certificate bundle for HTTPS
+        .skip_cert_common_name_check = false,
+        .keep_alive_enable = true,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .save_client_session = true, // Resume TLS when the server closed the connection
+#endif
+    };
+    g_cache.client = esp_http_client_init(&config);
+    if (!g_cache.client) {
+        ESP_LOGE(TAG, "❌ Failed to initialize HTTP client");
+        return false;
+    }
+    esp_http_client_set_header(g_cache.client, "Content-Type", "application/json");
+    esp_http_client_set_post_field(g_cache.client, TOKEN_REQUEST_BODY, strlen(TOKEN_REQUEST_BODY));
+    return true;
+}
+
+static void drop_client(void) {
+    if (g_cache.client) {
+        esp_http_client_cleanup(g_cache.client);
+        g_cache.client = NULL;
+    }
+}
+
+/**
+ * @brief Fetch a token and cache it, runs on the token task
+ */
+static bool fetch_token(void) {
+    if (!ensure_client()) return false;
+
+    ESP_LOGI(TAG, "🔄 Fetching participant token...");
+    g_cache.response_len = 0;
+    g_cache.response_overflow = false;
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = esp_http_client_perform(g_cache.client);
+    int status_code = esp_http_client_get_status_code(g_cache.client);
+    if (err != ESP_OK || status_code != 200) {
+        ESP_LOGE(TAG, "❌ Token fetch failed: %s (HTTP %d)", esp_err_to_name(err), status_code);
+        // Start from a fresh connection next time
+        esp_http_client_close(g_cache.client);
+        return false;
+    }
+    if (g_cache.response_overflow || g_cache.response_len == 0) {
+        ESP_LOGE(TAG, "❌ Token response %s", g_cache.response_overflow ? "too large" : "empty");
+        return false;
+    }
+
+    cJSON *json = cJSON_Parse(g_cache.response);
+    if (!json) {
+        ESP_LOGE(TAG, "❌ Failed to parse token response");
+        return false;
+    }
+    cJSON *token_item = cJSON_GetObjectItem(json, "token");
+    cJSON *duration_item = cJSON_GetObjectItem(json, "duration");
+    if (!cJSON_IsString(token_item) || strlen(token_item->valuestring) >= TOKEN_CACHE_MAX_LEN) {
+        ESP_LOGE(TAG, "❌ No usable token in response");
+        cJSON_Delete(json);
+        return false;
+    }
+
+    // Lifetime from the fetch start, so the cache never outlives the token
+    int duration_min = cJSON_IsNumber(duration_item) && duration_item->valueint > 0 ?
+                       duration_item->valueint : TOKEN_CACHE_DEFAULT_DURATION_MIN;
+    int64_t lifetime_s = (int64_t)duration_min * 60;
+    int64_t margin_s = lifetime_s / 5 < TOKEN_CACHE_REFRESH_MARGIN_S ? lifetime_s / 5 : TOKEN_CACHE_REFRESH_MARGIN_S;
+
+    xSemaphoreTake(g_cache.lock, portMAX_DELAY);
+    strcpy(g_cache.token, token_item->valuestring);
+    g_cache.expires_us = start_us + lifetime_s * 1000000;
+    g_cache.refresh_us = g_cache.expires_us - margin_s * 1000000;
+    xSemaphoreGive(g_cache.lock);
+    xEventGroupSetBits(g_cache.events, TOKEN_VALID_BIT);
+
+    ESP_LOGI(TAG, "✅ Token cached (length: %d, valid %d min, fetched in %" PRId64 " ms)",
+             (int)strlen(token_item->valuestring), duration_min, (esp_timer_get_time() - start_us) / 1000);
+    cJSON_Delete(json);
+    return true;
+}
+
+static void token_task(void *arg) {
+    uint32_t retry_ms = TOKEN_CACHE_RETRY_MIN_MS;
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        if (g_cache.network_up) {
+            xSemaphoreTake(g_cache.lock, portMAX_DELAY);
+            int64_t refresh_us = g_cache.refresh_us;
+            xSemaphoreGive(g_cache.lock);
+
+            int64_t now_us = esp_timer_get_time();
+            if (refresh_us > now_us) {
+                wait = pdMS_TO_TICKS((refresh_us - now_us) / 1000) + 1;
+            } else if (fetch_token()) {
+                retry_ms = TOKEN_CACHE_RETRY_MIN_MS;
+                continue;
+            } else {
+                wait = pdMS_TO_TICKS(retry_ms);
+                retry_ms = retry_ms * 2 > TOKEN_CACHE_RETRY_MAX_MS ? TOKEN_CACHE_RETRY_MAX_MS : retry_ms * 2;
+            }
+        } else {
+            drop_client();
+            retry_ms = TOKEN_CACHE_RETRY_MIN_MS;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+bool token_cache_init(void) {
+    if (g_cache.task) return true;
+
+    g_cache.lock = xSemaphoreCreateMutex();
+    g_cache.events = xEventGroupCreate();
+    if (!g_cache.lock || !g_cache.events) {
+        ESP_LOGE(TAG, "Failed to create token cache locks");
+        return false;
+    }
+    if (xTaskCreate(token_task, "token_task", TOKEN_TASK_STACK_SIZE, NULL, TOKEN_TASK_PRIORITY,
+                    &g_cache.task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create token task");
+        g_cache.task = NULL;
+        return false;
+    }
+    return true;
+}
+
+void token_cache_set_network_connected(bool connected) {
+    if (!g_cache.task) return;
+
+    g_cache.network_up = connected;
+    xTaskNotifyGive(g_cache.task);
+}
+
+/**
+ * @brief Copy the cached token if it is still valid, forget it if it expired
+ */
+static bool copy_valid_token(char *out, size_t out_size) {
+    bool copied = false;
+    xSemaphoreTake(g_cache.lock, portMAX_DELAY);
+    if (g_cache.expires_us > esp_timer_get_time()) {
+        if (strlen(g_cache.token) < out_size) {
+            strcpy(out, g_cache.token);
+            copied = true;
+        }
+    } else if (g_cache.expires_us != 0) {
+        g_cache.expires_us = 0;
+        g_cache.refresh_us = 0;
+        xEventGroupClearBits(g_cache.events, TOKEN_VALID_BIT);
+    }
+    xSemaphoreGive(g_cache.lock);
+    return copied;
+}
+
+bool token_cache_get(char *out, size_t out_size, uint32_t wait_ms) {
+    if (!g_cache.task || !out || out_size == 0) return false;
+
+    if (copy_valid_token(out, out_size)) {
+        return true;
+    }
+
+    // Nothing cached yet: make sure a fetch is under way and wait for it
+    ESP_LOGI(TAG, "⏳ No cached token, waiting up to %" PRIu32 " ms", wait_ms);
+    xTaskNotifyGive(g_cache.task);
+    xEventGroupWaitBits(g_cache.events, TOKEN_VALID_BIT, pdFALSE, pdTRUE, pdMS_TO_TICKS(wait_ms));
+    return copy_valid_token(out, out_size);
+}
+
+void token_cache_consume(void) {
+    if (!g_cache.task) return;
+
+    xSemaphoreTake(g_cache.lock, portMAX_DELAY);
+    g_cache.token[0] = '\0';
+    g_cache.expires_us = 0;
+    g_cache.refresh_us = 0;
+    xEventGroupClearBits(g_cache.events, TOKEN_VALID_BIT);
+    xSemaphoreGive(g_cache.lock);
+    xTaskNotifyGive(g_cache.task);
+}
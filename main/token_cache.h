@@ -0,0 +1,71 @@
+/* Participant Token Cache
+ *
+ * Fetches stage participant tokens from TOKEN_API_URL in the background as
+ * soon as the network comes up, caches them with their expiry and refreshes
+ * them ahead of time, so starting a stream goes straight to WHIP signaling.
+ * Requests share one persistent HTTP client, keeping the TLS connection
+ * (or its session ticket) between fetches.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest token the cache holds, including the terminator
+#define TOKEN_CACHE_MAX_LEN 2048
+
+// Lifetime assumed when the token response has no "duration" (minutes)
+#define TOKEN_CACHE_DEFAULT_DURATION_MIN 60
+
+// Refresh this long before expiry (at most a fifth of the token lifetime)
+#define TOKEN_CACHE_REFRESH_MARGIN_S 300
+
+// Retry delays after a failed fetch, doubling from the first to the last
+#define TOKEN_CACHE_RETRY_MIN_MS 2000
+#define TOKEN_CACHE_RETRY_MAX_MS 60000
+
+/**
+ * @brief Start the background token task
+ *
+ * Nothing is fetched until token_cache_set_network_connected(true).
+ *
+ * @return true on success
+ */
+bool token_cache_init(void);
+
+/**
+ * @brief Tell the cache whether the network is up
+ *
+ * Connecting triggers a fetch if no valid token is cached; disconnecting
+ * drops the persistent connection.
+ *
+ * @param connected true once the station has an IP address
+ */
+void token_cache_set_network_connected(bool connected);
+
+/**
+ * @brief Copy a valid token, waiting for a fetch if none is cached
+ *
+ * @param out Buffer for the token
+ * @param out_size Size of out (TOKEN_CACHE_MAX_LEN is always enough)
+ * @param wait_ms How long to wait for a fetch in progress
+ * @return true if a token was copied
+ */
+bool token_cache_get(char *out, size_t out_size, uint32_t wait_ms);
+
+/**
+ * @brief Drop the cached token after it was used to join, and prefetch the next one
+ *
+ * Every stream start then uses a fresh token without waiting for it.
+ */
+void token_cache_consume(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,160 @@
+/* Video Frame Buffer Pool Implementation
+ * 
+ * Fixed pool of preallocated output buffers for frames rewritten by the
+ * on_video_send hook, so the per-frame path never touches the heap
+ */
+
+#include "video_frame_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "FRAME_POOL";
+
+#define VIDEO_FRAME_POOL_MAX_BUFS 8
+
+typedef struct {
+    bool initialized;
+    uint8_t *bufs[VIDEO_FRAME_POOL_MAX_BUFS];
+    bool in_use[VIDEO_FRAME_POOL_MAX_BUFS];
+    int buf_count;
+    size_t buf_size;
+    uint32_t fallback_allocs;
+    portMUX_TYPE lock;
+} video_frame_pool_t;
+
+static video_frame_pool_t g_pool = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+bool video_frame_pool_init(int buf_count, size_t buf_size) {
+    if (g_pool.initialized) {
+        ESP_LOGW(TAG, "Frame pool already initialized");
+        return true;
+    }
+    
+    if (buf_count <= 0 || buf_count > VIDEO_FRAME_POOL_MAX_BUFS || buf_size == 0) {
+        ESP_LOGE(TAG, "Invalid frame pool config: %d x %zu bytes", buf_count, buf_size);
+        return false;
+    }
+    
+    // PSRAM first; without it (or once it runs out) keep at most
+    // VIDEO_FRAME_POOL_INTERNAL_BUFS buffers in internal RAM so the pool
+    // does not starve WiFi and the TLS stack
+    int psram_count = 0;
+    int count = 0;
+    while (count < buf_count) {
+        uint8_t *buf = heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (buf) {
+            psram_count++;
+        } else if (count - psram_count < VIDEO_FRAME_POOL_INTERNAL_BUFS) {
+            buf = heap_caps_malloc(buf_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (!buf) {
+            break;
+        }
+        g_pool.bufs[count] = buf;
+        g_pool.in_use[count] = false;
+        count++;
+    }
+    
+    if (count == 0) {
+        ESP_LOGE(TAG, "Failed to allocate any frame buffer (%zu bytes)", buf_size);
+        return false;
+    }
+    if (count < buf_count) {
+        ESP_LOGW(TAG, "Frame pool reduced to %d of %d buffers", count, buf_count);
+    }
+    
+    g_pool.buf_count = count;
+    g_pool.buf_size = buf_size;
+    g_pool.fallback_allocs = 0;
+    g_pool.initialized = true;
+    
+    ESP_LOGI(TAG, "✅ Frame pool initialized: %d x %zu bytes (%d in PSRAM, %d internal)",
+             count, buf_size, psram_count, count - psram_count);
+    return true;
+}
+
+void video_frame_pool_deinit(void) {
+    if (!g_pool.initialized) {
+        return;
+    }
+    
+    for (int i = 0; i < g_pool.buf_count; i++) {
+        if (g_pool.in_use[i]) {
+            ESP_LOGW(TAG, "Frame buffer %d still in use at deinit", i);
+        }
+        heap_caps_free(g_pool.bufs[i]);
+        g_pool.bufs[i] = NULL;
+        g_pool.in_use[i] = false;
+    }
+    g_pool.buf_count = 0;
+    g_pool.initialized = false;
+    ESP_LOGI(TAG, "✅ Frame pool deinitialized");
+}
+
+uint8_t *video_frame_pool_acquire(size_t size) {
+    uint8_t *buf = NULL;
+    
+    if (g_pool.initialized && size <= g_pool.buf_size) {
+        taskENTER_CRITICAL(&g_pool.lock);
+        for (int i = 0; i < g_pool.buf_count; i++) {
+            if (!g_pool.in_use[i]) {
+                g_pool.in_use[i] = true;
+                buf = g_pool.bufs[i];
+                break;
+            }
+        }
+        taskEXIT_CRITICAL(&g_pool.lock);
+    }
+    
+    if (!buf) {
+        // Oversized frame or every buffer still in flight
+        buf = malloc(size);
+        if (buf) {
+            taskENTER_CRITICAL(&g_pool.lock);
+            g_pool.fallback_allocs++;
+            taskEXIT_CRITICAL(&g_pool.lock);
+            ESP_LOGW(TAG, "Frame pool fallback to heap for %zu bytes", size);
+        }
+    }
+    return buf;
+}
+
+void video_frame_pool_release(uint8_t *buf) {
+    if (!buf) {
+        return;
+    }
+    
+    taskENTER_CRITICAL(&g_pool.lock);
+    for (int i = 0; i < g_pool.buf_count; i++) {
+        if (g_pool.bufs[i] == buf) {
+            g_pool.in_use[i] = false;
+            taskEXIT_CRITICAL(&g_pool.lock);
+            return;
+        }
+    }
+    taskEXIT_CRITICAL(&g_pool.lock);
+    
+    // Not a pool buffer, it came from the heap fallback
+    free(buf);
+}
+
+void video_frame_pool_get_stats(int *in_use, uint32_t *fallback_allocs) {
+    int count = 0;
+    
+    taskENTER_CRITICAL(&g_pool.lock);
+    for (int i = 0; i < g_pool.buf_count; i++) {
+        if (g_pool.in_use[i]) {
+            count++;
+        }
+    }
+    uint32_t fallbacks = g_pool.fallback_allocs;
+    taskEXIT_CRITICAL(&g_pool.lock);
+    
+    if (in_use) *in_use = count;
+    if (fallback_allocs) *fallback_allocs = fallbacks;
+}
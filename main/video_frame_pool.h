@@ -0,0 +1,75 @@
+/* Video Frame Buffer Pool
+ * 
+ * Fixed pool of preallocated output buffers for frames rewritten by the
+ * on_video_send hook, so the per-frame path never touches the heap
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "settings.h"
+#include "sei_publisher.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of output buffers; one is in flight while the peer packetizes it
+#ifndef VIDEO_FRAME_POOL_BUF_COUNT
+#define VIDEO_FRAME_POOL_BUF_COUNT 3
+#endif
+
+// Cap on buffers placed in internal RAM when PSRAM is missing or full
+#ifndef VIDEO_FRAME_POOL_INTERNAL_BUFS
+#define VIDEO_FRAME_POOL_INTERNAL_BUFS 1
+#endif
+
+/**
+ * @brief Allocate the frame buffer pool
+ * 
+ * Buffers go to PSRAM; when it is missing or full the pool falls back to
+ * at most VIDEO_FRAME_POOL_INTERNAL_BUFS internal RAM buffers and runs
+ * with fewer buffers than requested.
+ * 
+ * @param buf_count Number of buffers in the pool
+ * @param buf_size Size of each buffer in bytes
+ * @return true if at least one buffer was allocated, false otherwise
+ */
+bool video_frame_pool_init(int buf_count, size_t buf_size);
+
+/**
+ * @brief Free all pool buffers
+ */
+void video_frame_pool_deinit(void);
+
+/**
+ * @brief Get an output buffer for a frame
+ * 
+ * Falls back to a heap allocation when the pool is exhausted or the frame
+ * does not fit, so callers always release through video_frame_pool_release.
+ * 
+ * @param size Required buffer size in bytes
+ * @return Buffer of at least size bytes, or NULL on failure
+ */
+uint8_t *video_frame_pool_acquire(size_t size);
+
+/**
+ * @brief Return a buffer obtained from video_frame_pool_acquire
+ * 
+ * @param buf Buffer to release (NULL is ignored)
+ */
+void video_frame_pool_release(uint8_t *buf);
+
+/**
+ * @brief Get pool usage statistics
+ * 
+ * @param in_use Pointer to store number of pool buffers currently in use
+ * @param fallback_allocs Pointer to store number of heap fallbacks since init
+ */
+void video_frame_pool_get_stats(int *in_use, uint32_t *fallback_allocs);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,188 @@
+/* Runtime Video Profiles Implementation
+ *
+ * Profile table and the hysteresis loop that picks a profile from the link
+ * statistics measured on the video send path
+ */
+
+#include "video_profile.h"
+#include "settings.h"
+#include "sei_publisher.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+
+static const char *TAG = "VIDEO_PROFILE";
+
+// Highest quality first. Entries above the settings.h profile are skipped,
+// so lowering VIDEO_WIDTH / VIDEO_FPS trims the table instead of breaking it
+#if CONFIG_IDF_TARGET_ESP32P4
+static const video_profile_t s_profiles[] = {
+    { "full",   VIDEO_WIDTH, VIDEO_HEIGHT, VIDEO_FPS },
+    { "720p25", 1280, 720, 25 },
+    { "720p15", 1280, 720, 15 },
+    { "360p15", 640, 360, 15 },
+};
+#else
+static const video_profile_t s_profiles[] = {
+    { "full",   VIDEO_WIDTH, VIDEO_HEIGHT, VIDEO_FPS },
+    { "240p7",  320, 240, 7 },
+    { "240p5",  320, 240, 5 },
+};
+#endif
+
+#define VIDEO_PROFILE_TABLE_SIZE (int)(sizeof(s_profiles) / sizeof(s_profiles[0]))
+
+static const video_profile_t *s_table[VIDEO_PROFILE_TABLE_SIZE];
+static int s_table_count;
+
+static _Atomic int s_current;
+static atomic_bool s_pinned;
+
+// Set from any task, consumed by video_profile_update
+static atomic_bool s_reset_requested;
+
+// Adaptation state, owned by the task calling video_profile_update
+static int s_congested_windows;
+static int s_clean_windows;
+static int s_up_backoff = 1;
+static int s_windows_since_up = -1;     // -1 once the last step up has held
+
+void video_profile_init(void) {
+    if (s_table_count > 0) return;
+
+    s_table[s_table_count++] = &s_profiles[0];
+    for (int i = 1; i < VIDEO_PROFILE_TABLE_SIZE; i++) {
+        const video_profile_t *profile = &s_profiles[i];
+        if (profile->width <= VIDEO_WIDTH && profile->height <= VIDEO_HEIGHT && profile->fps <= VIDEO_FPS &&
+            (profile->width < VIDEO_WIDTH || profile->fps < VIDEO_FPS)) {
+            s_table[s_table_count++] = profile;
+        }
+    }
+}
+
+int video_profile_count(void) {
+    return s_table_count;
+}
+
+const video_profile_t *video_profile_get(int index) {
+    if (index < 0 || index >= s_table_count) return NULL;
+    return s_table[index];
+}
+
+int video_profile_current_index(void) {
+    return atomic_load(&s_current);
+}
+
+const video_profile_t *video_profile_current(void) {
+    return video_profile_get(atomic_load(&s_current));
+}
+
+bool video_profile_select(int index) {
+    if (index < 0) {
+        atomic_store(&s_pinned, false);
+        ESP_LOGI(TAG, "🎚️  Automatic video profile selection enabled");
+        return true;
+    }
+
+    const video_profile_t *profile = video_profile_get(index);
+    if (!profile) return false;
+
+    atomic_store(&s_current, index);
+    atomic_store(&s_pinned, true);
+    ESP_LOGI(TAG, "📌 Video profile pinned to %s (%dx%d@%d)",
+             profile->name, profile->width, profile->height, profile->fps);
+    return true;
+}
+
+bool video_profile_is_auto(void) {
+    return !atomic_load(&s_pinned);
+}
+
+void video_profile_reset_windows(void) {
+    atomic_store(&s_reset_requested, true);
+}
+
+static void clear_windows(void) {
+    s_congested_windows = 0;
+    s_clean_windows = 0;
+}
+
+/**
+ * @brief Move to another profile and log why
+ */
+static void step_to(int index, const char *reason) {
+    const video_profile_t *from = video_profile_current();
+    const video_profile_t *to = video_profile_get(index);
+    atomic_store(&s_current, index);
+    clear_windows();
+    ESP_LOGW(TAG, "🎚️  Video profile %s -> %s (%dx%d@%d): %s",
+             from->name, to->name, to->width, to->height, to->fps, reason);
+}
+
+bool video_profile_update(const video_link_sample_t *sample) {
+    if (!sample || sample->frames == 0 || sample->interval_ms == 0 || !video_profile_is_auto()) {
+        return false;
+    }
+    if (atomic_exchange(&s_reset_requested, false)) {
+        clear_windows();
+    }
+
+    int current = video_profile_current_index();
+    const video_profile_t *profile = video_profile_get(current);
+    uint32_t fps_pct = sample->frames * 100000u / (sample->interval_ms * profile->fps);
+
+    // Low frame rate alone is not congestion, the camera may just be slow
+    bool congested = sample->max_send_delay_ms > VIDEO_PROFILE_CONGESTED_DELAY_MS ||
+                     (fps_pct < VIDEO_PROFILE_CONGESTED_FPS_PCT &&
+                      sample->max_send_delay_ms > VIDEO_PROFILE_CLEAN_DELAY_MS);
+    bool clean = sample->max_send_delay_ms < VIDEO_PROFILE_CLEAN_DELAY_MS;
+
+    if (s_windows_since_up >= 0 && ++s_windows_since_up > VIDEO_PROFILE_FAILED_PROBE_WINDOWS) {
+        // The last step up held, probe at the normal pace again
+        s_windows_since_up = -1;
+        s_up_backoff = 1;
+    }
+
+    if (congested) {
+        s_clean_windows = 0;
+        if (++s_congested_windows < VIDEO_PROFILE_DOWN_WINDOWS || current + 1 >= video_profile_count()) {
+            return false;
+        }
+        if (s_windows_since_up >= 0) {
+            // Undoing a recent probe, wait longer before the next one
+            s_up_backoff = s_up_backoff * 2 > VIDEO_PROFILE_MAX_UP_BACKOFF ? VIDEO_PROFILE_MAX_UP_BACKOFF
+                                                                            : s_up_backoff * 2;
+            s_windows_since_up = -1;
+        }
+        step_to(current + 1, "link congested");
+        return true;
+    }
+
+    s_congested_windows = 0;
+    if (!clean) {
+        // In between the thresholds: neither direction accumulates
+        s_clean_windows = 0;
+        return false;
+    }
+
+    if (++s_clean_windows < VIDEO_PROFILE_UP_WINDOWS * s_up_backoff || current == 0) {
+        return false;
+    }
+    s_windows_since_up = 0;
+    step_to(current - 1, "link clean, probing up");
+    return true;
+}
+
+static uint32_t pixel_rate(const video_profile_t *profile) {
+    return (uint32_t)profile->width * profile->height * profile->fps;
+}
+
+size_t video_profile_scale_budget(const video_profile_t *profile, size_t full_budget) {
+    const video_profile_t *top = video_profile_get(0);
+    if (!profile || full_budget == 0 || pixel_rate(profile) >= pixel_rate(top)) {
+        return full_budget;
+    }
+
+    // 64-bit: full budget times a 1080p30 pixel rate overflows 32 bits
+    size_t budget = (size_t)((uint64_t)full_budget * pixel_rate(profile) / pixel_rate(top));
+    return budget < SEI_MAX_NAL_SIZE ? SEI_MAX_NAL_SIZE : budget;
+}
@@ -0,0 +1,136 @@
+/* Runtime video profiles and adaptive profile selection
+ *
+ * A small table of resolution / frame rate steps, topped
+ * by the VIDEO_WIDTH x VIDEO_HEIGHT @ VIDEO_FPS profile from settings.h.
+ * The adaptation loop steps down when the link can't keep up and probes
+ * back up after a sustained clean period, with hysteresis so it doesn't
+ * oscillate between two profiles.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Consecutive congested windows before stepping down
+#define VIDEO_PROFILE_DOWN_WINDOWS 2
+
+// Consecutive clean windows before probing the next profile up
+#define VIDEO_PROFILE_UP_WINDOWS 15
+
+// A step up that is undone within this many windows doubles the wait before the next probe
+#define VIDEO_PROFILE_FAILED_PROBE_WINDOWS 30
+#define VIDEO_PROFILE_MAX_UP_BACKOFF 8
+
+// Send delay above the session baseline that counts as congestion, and the level that counts as clean
+#define VIDEO_PROFILE_CONGESTED_DELAY_MS 300
+#define VIDEO_PROFILE_CLEAN_DELAY_MS 80
+
+// Delivered frame rate, as a percentage of the profile's, below which a window with
+// send delay above VIDEO_PROFILE_CLEAN_DELAY_MS is congested too
+#define VIDEO_PROFILE_CONGESTED_FPS_PCT 75
+
+/**
+ * @brief Video profile
+ */
+typedef struct {
+    const char *name;           /*!< Short name for logs and the CLI */
+    uint16_t width;             /*!< Encoded width in pixels */
+    uint16_t height;            /*!< Encoded height in pixels */
+    uint8_t fps;                /*!< Encoded frame rate */
+} video_profile_t;
+
+/**
+ * @brief Link statistics for one adaptation window
+ */
+typedef struct {
+    uint32_t interval_ms;       /*!< Window length */
+    uint32_t frames;            /*!< Video frames handed to the peer */
+    uint32_t bytes;             /*!< Encoded bytes handed to the peer */
+    uint32_t max_send_delay_ms; /*!< Worst capture-to-send delay above the session baseline */
+} video_link_sample_t;
+
+/**
+ * @brief Build the profile table from the settings.h profile
+ *
+ * Call once before any task uses the other functions.
+ */
+void video_profile_init(void);
+
+/**
+ * @brief Get the number of profiles, highest quality first
+ */
+int video_profile_count(void);
+
+/**
+ * @brief Get a profile from the table
+ *
+ * @param index Profile index, 0 is the highest quality
+ * @return Profile, or NULL if index is out of range
+ */
+const video_profile_t *video_profile_get(int index);
+
+/**
+ * @brief Get the index of the active profile
+ */
+int video_profile_current_index(void);
+
+/**
+ * @brief Get the active profile
+ */
+const video_profile_t *video_profile_current(void);
+
+/**
+ * @brief Pin a profile or return to automatic selection
+ *
+ * @param index Profile index to pin, or -1 for automatic selection
+ * @return true if the index is valid
+ */
+bool video_profile_select(int index);
+
+/**
+ * @brief Check whether profiles are selected automatically
+ */
+bool video_profile_is_auto(void);
+
+/**
+ * @brief Feed one window of link statistics to the adaptation loop
+ *
+ * Windows without frames (not streaming, or reconnecting) are ignored.
+ * Call from a single task.
+ *
+ * @param sample Statistics for the window that just ended
+ * @return true if a different profile was selected and must be applied
+ */
+bool video_profile_update(const video_link_sample_t *sample);
+
+/**
+ * @brief Reset the adaptation state after the active profile was applied
+ *
+ * Counters start over, so windows measured on the previous profile don't
+ * trigger another change. Safe to call from any task: the reset is taken
+ * up by the next video_profile_update.
+ */
+void video_profile_reset_windows(void);
+
+/**
+ * @brief Scale a per-frame SEI byte budget to a profile's pixel rate
+ *
+ * The full budget applies to the top profile; lower profiles get a share
+ * proportional to width x height x fps, which the encoder's output follows,
+ * but never less than one maximum-size SEI message.
+ *
+ * @param profile Profile the budget is for
+ * @param full_budget Budget at the top profile
+ * @return Scaled budget in bytes
+ */
+size_t video_profile_scale_budget(const video_profile_t *profile, size_t full_budget);
+
+#ifdef __cplusplus
+}
+#endif
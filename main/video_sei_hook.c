@@ -2,53 +2,479 @@
  * 
  * Provides hooks to intercept video frames and inject SEI NAL units
  * before they are sent via WebRTC
+ *
+ * The processor and stage chain are published as immutable snapshots
+ * swapped with an atomic pointer. Frames only count themselves in and out
+ * of the snapshot they use, and writers wait for those counts to drain
+ * before reusing a snapshot, so the per-frame path takes no locks. The
+ * publishers' consumer side is single-threaded, so a frame that finds
+ * another one in the hook passes through instead of waiting for it.
  */
 
 #include "video_sei_hook.h"
-#include "sei.h"
+#include "sei_metrics.h"
+#include "settings.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 #include <inttypes.h>
 
+#ifndef VIDEO_SEI_INSERT_AUD
+#define VIDEO_SEI_INSERT_AUD false
+#endif
+
 static const char *TAG = "VIDEO_SEI_HOOK";
 
+// Access unit delimiter, primary_pic_type 7 (any slice type)
+static const uint8_t AUD_NAL[] = {0x00, 0x00, 0x00, 0x01, 0x09, 0xF0};
+_Static_assert(sizeof(AUD_NAL) == VIDEO_SEI_HOOK_AUD_SIZE, "AUD size is part of the frame pool size");
+
+typedef struct {
+    char name[VIDEO_SEI_HOOK_STAGE_NAME_LEN];
+    video_frame_stage_t fn;
+    void *user_ctx;
+    int stats_slot;                 // Entry of g_hook.stage_stats
+} video_sei_stage_t;
+
+/**
+ * @brief Processor and stage chain as seen by one frame, never changed while published
+ */
 typedef struct {
-    bool initialized;
     video_frame_processor_t custom_processor;
     void *user_ctx;
-    SemaphoreHandle_t mutex;
+    video_sei_stage_t stages[VIDEO_SEI_HOOK_MAX_STAGES];
+    int stage_count;
+    atomic_int readers;             // Frames using this snapshot
+} video_sei_chain_t;
+
+/**
+ * @brief Stage counters, kept outside the snapshots so they survive a swap
+ */
+typedef struct {
+    bool in_use;                    // Guarded by the writer mutex
+    _Atomic uint32_t failures;
+    _Atomic uint32_t max_us;
+} video_sei_stage_stats_t;
+
+/**
+ * @brief Hook counters of one core, added up when read
+ */
+typedef struct {
+    _Atomic uint32_t frames_processed;
+    _Atomic uint32_t sei_units_inserted;
+    _Atomic uint32_t total_sei_bytes;
+} video_sei_core_stats_t;
+
+typedef struct {
+    bool initialized;
+    SemaphoreHandle_t mutex;        // Serializes writers, never taken per frame
+    
+    // Published snapshot and the spare one the next writer fills in
+    video_sei_chain_t chains[2];
+    _Atomic(video_sei_chain_t *) active;
+    atomic_flag busy;               // Set while a frame is in the processor or chain
+    
+    // Publishers whose block is in the frame being built, guarded by busy
+    sei_publisher_handle_t spliced[VIDEO_SEI_HOOK_MAX_PUBLISHERS];
+    int spliced_count;
     
-    // Statistics
-    uint32_t frames_processed;
-    uint32_t sei_units_inserted;
-    uint32_t total_sei_bytes;
+    video_sei_stage_stats_t stage_stats[VIDEO_SEI_HOOK_MAX_STAGES];
+    video_sei_core_stats_t core_stats[portNUM_PROCESSORS];
 } video_sei_hook_t;
 
 static video_sei_hook_t g_hook = {0};
 
 /**
- * @brief Default SEI frame processor using the test SEI publisher
+ * @brief Take a reference on the published snapshot
+ *
+ * The count is checked against the pointer again after it is taken: if a
+ * writer swapped in between, it may not have seen the count, so the frame
+ * backs out and tries the new snapshot.
+ */
+static video_sei_chain_t *chain_acquire(void) {
+    for (;;) {
+        video_sei_chain_t *chain = atomic_load(&g_hook.active);
+        atomic_fetch_add(&chain->readers, 1);
+        if (atomic_load(&g_hook.active) == chain) {
+            return chain;
+        }
+        atomic_fetch_sub(&chain->readers, 1);
+    }
+}
+
+static void chain_release(video_sei_chain_t *chain) {
+    atomic_fetch_sub_explicit(&chain->readers, 1, memory_order_release);
+}
+
+/**
+ * @brief Copy the published snapshot into the spare one, must be called with the mutex held
+ */
+static video_sei_chain_t *chain_begin(void) {
+    video_sei_chain_t *active = atomic_load(&g_hook.active);
+    video_sei_chain_t *next = active == &g_hook.chains[0] ? &g_hook.chains[1] : &g_hook.chains[0];
+    next->custom_processor = active->custom_processor;
+    next->user_ctx = active->user_ctx;
+    memcpy(next->stages, active->stages, sizeof(next->stages));
+    next->stage_count = active->stage_count;
+    return next;
+}
+
+/**
+ * @brief Publish a snapshot and wait until no frame uses the previous one
+ *
+ * Must be called with the mutex held. Once this returns, callbacks and
+ * publishers only the previous snapshot referenced are no longer in use.
+ */
+static void chain_publish(video_sei_chain_t *next) {
+    video_sei_chain_t *previous = atomic_exchange(&g_hook.active, next);
+    while (atomic_load(&previous->readers) != 0) {
+        vTaskDelay(1);
+    }
+}
+
+/**
+ * @brief Append a stage to a snapshot being edited, must be called with the mutex held
+ */
+static bool chain_add_stage(video_sei_chain_t *chain, const char *name, video_frame_stage_t fn, void *user_ctx) {
+    if (chain->stage_count >= VIDEO_SEI_HOOK_MAX_STAGES) {
+        return false;
+    }
+    int slot = 0;
+    while (g_hook.stage_stats[slot].in_use) {
+        slot++;
+    }
+    video_sei_stage_stats_t *stats = &g_hook.stage_stats[slot];
+    stats->in_use = true;
+    atomic_store_explicit(&stats->failures, 0, memory_order_relaxed);
+    atomic_store_explicit(&stats->max_us, 0, memory_order_relaxed);
+    
+    video_sei_stage_t *stage = &chain->stages[chain->stage_count++];
+    memset(stage, 0, sizeof(*stage));
+    strncpy(stage->name, name ? name : "stage", sizeof(stage->name) - 1);
+    stage->fn = fn;
+    stage->user_ctx = user_ctx;
+    stage->stats_slot = slot;
+    return true;
+}
+
+/**
+ * @brief Registered publishers, highest priority first
+ *
+ * Kept apart from g_hook so publishers can register before the hook is
+ * initialized, and guarded by a spinlock the video thread only holds long
+ * enough to copy the handles.
  */
-static bool default_sei_processor(const uint8_t *frame_data, size_t frame_size,
-                                 uint8_t **output_data, size_t *output_size,
-                                 void *user_ctx) {
-    sei_publisher_handle_t publisher = sei_get_publisher();
-    if (!publisher) {
-        // No SEI publisher available, just copy frame as-is
-        *output_data = malloc(frame_size);
-        if (!*output_data) {
-            return false;
+static struct {
+    video_sei_channel_t channels[VIDEO_SEI_HOOK_MAX_PUBLISHERS];
+    int count;
+    portMUX_TYPE lock;
+} g_channels = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+bool video_sei_hook_register_publisher(sei_publisher_handle_t publisher, const char *name, int priority) {
+    if (!publisher) return false;
+    
+    bool added = false;
+    taskENTER_CRITICAL(&g_channels.lock);
+    bool known = false;
+    for (int i = 0; i < g_channels.count; i++) {
+        known |= g_channels.channels[i].publisher == publisher;
+    }
+    if (!known && g_channels.count < VIDEO_SEI_HOOK_MAX_PUBLISHERS) {
+        // Insert after every publisher of the same or higher priority
+        int slot = g_channels.count;
+        while (slot > 0 && g_channels.channels[slot - 1].priority < priority) {
+            g_channels.channels[slot] = g_channels.channels[slot - 1];
+            slot--;
+        }
+        g_channels.channels[slot] = (video_sei_channel_t) {
+            .publisher = publisher,
+            .name = name ? name : "sei",
+            .priority = priority,
+        };
+        g_channels.count++;
+        added = true;
+    }
+    taskEXIT_CRITICAL(&g_channels.lock);
+    
+    if (added) {
+        ESP_LOGI(TAG, "📹 Registered SEI publisher \"%s\" (priority %d)", name ? name : "sei", priority);
+    } else {
+        ESP_LOGE(TAG, "Failed to register SEI publisher \"%s\": %s", name ? name : "sei",
+                 known ? "already registered" : "table full");
+    }
+    return added;
+}
+
+bool video_sei_hook_unregister_publisher(sei_publisher_handle_t publisher) {
+    bool removed = false;
+    taskENTER_CRITICAL(&g_channels.lock);
+    for (int i = 0; i < g_channels.count; i++) {
+        if (g_channels.channels[i].publisher != publisher) continue;
+        for (int j = i + 1; j < g_channels.count; j++) {
+            g_channels.channels[j - 1] = g_channels.channels[j];
         }
-        memcpy(*output_data, frame_data, frame_size);
-        *output_size = frame_size;
+        g_channels.count--;
+        removed = true;
+        break;
+    }
+    taskEXIT_CRITICAL(&g_channels.lock);
+    
+    // A frame being processed may still use the publisher; republishing waits for it
+    if (removed && g_hook.initialized && xSemaphoreTake(g_hook.mutex, portMAX_DELAY) == pdTRUE) {
+        chain_publish(chain_begin());
+        xSemaphoreGive(g_hook.mutex);
+    }
+    return removed;
+}
+
+int video_sei_hook_get_publishers(video_sei_channel_t *out, int max_count) {
+    if (!out || max_count <= 0) return 0;
+    
+    taskENTER_CRITICAL(&g_channels.lock);
+    int count = g_channels.count < max_count ? g_channels.count : max_count;
+    memcpy(out, g_channels.channels, count * sizeof(out[0]));
+    taskEXIT_CRITICAL(&g_channels.lock);
+    return count;
+}
+
+const nal_index_t *video_frame_ctx_nal_index(video_frame_ctx_t *ctx) {
+    if (!ctx->nal_index) {
+        int64_t index_start = esp_timer_get_time();
+        nal_index_build(ctx->frame->data, ctx->frame->size, true, &ctx->scanned_index);
+        sei_metrics_record(SEI_STAGE_NAL_INDEX, (uint32_t)(esp_timer_get_time() - index_start));
+        ctx->nal_index = &ctx->scanned_index;
+    }
+    return ctx->nal_index;
+}
+
+/**
+ * @brief Put an insertion at a position of the list, which must keep it sorted
+ */
+static bool insert_at(video_frame_ctx_t *ctx, int slot, size_t offset, const uint8_t *data, size_t len) {
+    if (ctx->insert_count >= VIDEO_FRAME_MAX_INSERTS) {
+        return false;
+    }
+    memmove(&ctx->inserts[slot + 1], &ctx->inserts[slot], (ctx->insert_count - slot) * sizeof(ctx->inserts[0]));
+    ctx->inserts[slot] = (video_frame_insert_t) {
+        .offset = offset,
+        .data = data,
+        .len = len,
+    };
+    ctx->insert_count++;
+    ctx->inserted_bytes += len;
+    return true;
+}
+
+bool video_frame_ctx_insert(video_frame_ctx_t *ctx, size_t offset, const uint8_t *data, size_t len) {
+    if (!ctx || offset > ctx->frame->size || (!data && len > 0)) {
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+    // After every insertion at the same offset, so earlier stages go first
+    int slot = ctx->insert_count;
+    while (slot > 0 && ctx->inserts[slot - 1].offset > offset) {
+        slot--;
+    }
+    return insert_at(ctx, slot, offset, data, len);
+}
+
+/**
+ * @brief Built-in stage splicing the block of every registered publisher
+ *
+ * Every publisher schedules against its own budgets; the blocks all go in
+ * front of the first slice, in priority order. Blocks stay in the
+ * publishers' buffers until the chain output is written, and their splices
+ * are committed or cancelled by run_stages once it is.
+ */
+static bool sei_stage(video_frame_ctx_t *ctx, void *user_ctx) {
+    video_sei_channel_t channels[VIDEO_SEI_HOOK_MAX_PUBLISHERS];
+    int count = video_sei_hook_get_publishers(channels, VIDEO_SEI_HOOK_MAX_PUBLISHERS);
+    if (count == 0) {
+        // No SEI publisher available, nothing to insert
         return true;
     }
     
-    // Process frame with SEI publisher
-    return sei_publisher_process_frame(publisher, frame_data, frame_size, output_data, output_size);
+    // One index for every publisher; the PTS stamps the inserted messages and releases those held for it
+    const nal_index_t *nal_index = video_frame_ctx_nal_index(ctx);
+    const video_frame_desc_t *frame = ctx->frame;
+    bool ok = true;
+    int64_t build_start = esp_timer_get_time();
+    for (int i = 0; i < count; i++) {
+        sei_splice_t splice;
+        if (!sei_publisher_build_splice_pts(channels[i].publisher, frame->data, frame->size, nal_index,
+                                            frame->pts, &splice)) {
+            continue;
+        }
+        if (video_frame_ctx_insert(ctx, splice.insert_offset, splice.block.base, splice.block.len)) {
+            g_hook.spliced[g_hook.spliced_count++] = channels[i].publisher;
+        } else {
+            // No room in this frame, the messages go out with a later one
+            sei_publisher_cancel_splice(channels[i].publisher);
+            ok = false;
+        }
+    }
+    sei_metrics_record(SEI_STAGE_SPLICE_BUILD, (uint32_t)(esp_timer_get_time() - build_start));
+    return ok;
+}
+
+bool video_sei_hook_aud_stage(video_frame_ctx_t *ctx, void *user_ctx) {
+    const nal_index_t *nal_index = video_frame_ctx_nal_index(ctx);
+    if (nal_index->count == 0 || nal_index->entries[0].nal_type == NAL_TYPE_AUD) {
+        return true;
+    }
+    // The delimiter starts the access unit, ahead of anything other stages put at offset 0
+    return insert_at(ctx, 0, 0, AUD_NAL, sizeof(AUD_NAL));
+}
+
+/**
+ * @brief Commit or cancel the splices of every publisher in this frame
+ */
+static void finish_splices(bool sent) {
+    for (int i = 0; i < g_hook.spliced_count; i++) {
+        if (sent) {
+            sei_publisher_commit_splice(g_hook.spliced[i]);
+        } else {
+            sei_publisher_cancel_splice(g_hook.spliced[i]);
+        }
+    }
+    g_hook.spliced_count = 0;
+}
+
+/**
+ * @brief Run the stage chain and write the frame with every insertion in one pass
+ */
+static bool run_stages(const video_sei_chain_t *chain, const video_frame_desc_t *frame,
+                       uint8_t **output_data, size_t *output_size, bool *failed) {
+    // Shared by every stage of this frame
+    video_frame_ctx_t frame_ctx;
+    video_frame_ctx_t *ctx = &frame_ctx;
+    ctx->frame = frame;
+    ctx->nal_index = frame->nal_index;
+    ctx->insert_count = 0;
+    ctx->inserted_bytes = 0;
+    g_hook.spliced_count = 0;
+    
+    for (int i = 0; i < chain->stage_count; i++) {
+        const video_sei_stage_t *stage = &chain->stages[i];
+        video_sei_stage_stats_t *stats = &g_hook.stage_stats[stage->stats_slot];
+        int64_t stage_start = esp_timer_get_time();
+        bool ok = stage->fn(ctx, stage->user_ctx);
+        uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - stage_start);
+        if (!ok) {
+            atomic_fetch_add_explicit(&stats->failures, 1, memory_order_relaxed);
+            *failed = true;
+        }
+        uint32_t max_us = atomic_load_explicit(&stats->max_us, memory_order_relaxed);
+        while (elapsed_us > max_us &&
+               !atomic_compare_exchange_weak_explicit(&stats->max_us, &max_us, elapsed_us,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+        }
+    }
+    if (ctx->insert_count == 0) {
+        // Nothing to insert, the caller keeps using the original frame
+        return false;
+    }
+    
+    int64_t copy_start = esp_timer_get_time();
+    size_t total_size = frame->size + ctx->inserted_bytes;
+    uint8_t *output = video_frame_pool_acquire(total_size);
+    if (!output) {
+        ESP_LOGE(TAG, "❌ Failed to allocate output frame buffer (%zu bytes)", total_size);
+        finish_splices(false);
+        *failed = true;
+        return false;
+    }
+    size_t src = 0;
+    size_t pos = 0;
+    for (int i = 0; i < ctx->insert_count; i++) {
+        const video_frame_insert_t *insert = &ctx->inserts[i];
+        memcpy(output + pos, frame->data + src, insert->offset - src);
+        pos += insert->offset - src;
+        memcpy(output + pos, insert->data, insert->len);
+        pos += insert->len;
+        src = insert->offset;
+    }
+    memcpy(output + pos, frame->data + src, frame->size - src);
+    finish_splices(true);
+    *output_data = output;
+    *output_size = total_size;
+    sei_metrics_record(SEI_STAGE_FRAME_COPY, (uint32_t)(esp_timer_get_time() - copy_start));
+    return true;
+}
+
+bool video_sei_hook_add_stage(const char *name, video_frame_stage_t stage, void *user_ctx) {
+    if (!g_hook.initialized || !stage) {
+        ESP_LOGE(TAG, "Video SEI hook not initialized");
+        return false;
+    }
+    
+    if (xSemaphoreTake(g_hook.mutex, portMAX_DELAY) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed to acquire mutex");
+        return false;
+    }
+    video_sei_chain_t *next = chain_begin();
+    bool added = chain_add_stage(next, name, stage, user_ctx);
+    if (added) {
+        chain_publish(next);
+    }
+    xSemaphoreGive(g_hook.mutex);
+    
+    if (added) {
+        ESP_LOGI(TAG, "📹 Added frame stage \"%s\"", name ? name : "stage");
+    } else {
+        ESP_LOGE(TAG, "Failed to add frame stage \"%s\": chain full", name ? name : "stage");
+    }
+    return added;
+}
+
+bool video_sei_hook_remove_stage(video_frame_stage_t stage) {
+    if (!g_hook.initialized) {
+        return false;
+    }
+    
+    if (xSemaphoreTake(g_hook.mutex, portMAX_DELAY) != pdTRUE) {
+        return false;
+    }
+    video_sei_chain_t *next = chain_begin();
+    int stats_slot = -1;
+    for (int i = 0; i < next->stage_count; i++) {
+        if (next->stages[i].fn != stage) continue;
+        stats_slot = next->stages[i].stats_slot;
+        memmove(&next->stages[i], &next->stages[i + 1], (next->stage_count - i - 1) * sizeof(next->stages[0]));
+        next->stage_count--;
+        break;
+    }
+    if (stats_slot >= 0) {
+        // Waits for the frames in the old chain, so the stage is never called once this returns
+        chain_publish(next);
+        g_hook.stage_stats[stats_slot].in_use = false;
+    }
+    xSemaphoreGive(g_hook.mutex);
+    return stats_slot >= 0;
+}
+
+int video_sei_hook_get_stages(video_sei_hook_stage_info_t *out, int max_count) {
+    if (!g_hook.initialized || !out || max_count <= 0) return 0;
+    
+    video_sei_chain_t *chain = chain_acquire();
+    int count = chain->stage_count < max_count ? chain->stage_count : max_count;
+    for (int i = 0; i < count; i++) {
+        const video_sei_stage_stats_t *stats = &g_hook.stage_stats[chain->stages[i].stats_slot];
+        memcpy(out[i].name, chain->stages[i].name, sizeof(out[i].name));
+        out[i].failures = atomic_load_explicit(&stats->failures, memory_order_relaxed);
+        out[i].max_us = atomic_load_explicit(&stats->max_us, memory_order_relaxed);
+    }
+    chain_release(chain);
+    return count;
 }
 
 bool video_sei_hook_init(void) {
@@ -58,6 +484,7 @@ bool video_sei_hook_init(void) {
     }
     
     memset(&g_hook, 0, sizeof(g_hook));
+    atomic_flag_clear(&g_hook.busy);
     
     g_hook.mutex = xSemaphoreCreateMutex();
     if (!g_hook.mutex) {
@@ -65,27 +492,65 @@ bool video_sei_hook_init(void) {
         return false;
     }
     
-    // Set default processor
-    g_hook.custom_processor = default_sei_processor;
-    g_hook.user_ctx = NULL;
+    // Output frames come from a fixed PSRAM pool instead of per-frame mallocs
+    if (!video_frame_pool_init(VIDEO_FRAME_POOL_BUF_COUNT, VIDEO_FRAME_POOL_BUF_SIZE)) {
+        ESP_LOGE(TAG, "Failed to initialize frame pool");
+        vSemaphoreDelete(g_hook.mutex);
+        g_hook.mutex = NULL;
+        return false;
+    }
+    
+    // No custom processor selects the stage chain, which starts with the publishers' SEI
+    video_sei_chain_t *chain = &g_hook.chains[0];
+    chain_add_stage(chain, "sei", sei_stage, NULL);
+    if (VIDEO_SEI_INSERT_AUD) {
+        chain_add_stage(chain, "aud", video_sei_hook_aud_stage, NULL);
+    }
+    atomic_store(&g_hook.active, chain);
     g_hook.initialized = true;
     
     ESP_LOGI(TAG, "✅ Video SEI hook initialized");
     return true;
 }
 
-void video_sei_hook_deinit(void) {
+bool video_sei_hook_deinit(void) {
     if (!g_hook.initialized) {
-        return;
+        return true;
     }
     
-    if (g_hook.mutex) {
-        vSemaphoreDelete(g_hook.mutex);
-        g_hook.mutex = NULL;
+    xSemaphoreTake(g_hook.mutex, portMAX_DELAY);
+    // New frames pass through unchanged from here on
+    g_hook.initialized = false;
+    video_sei_chain_t *previous = atomic_load(&g_hook.active);
+    video_sei_chain_t *empty = chain_begin();
+    empty->custom_processor = NULL;
+    empty->stage_count = 0;
+    // Frames still in the old chain drain before anything is freed
+    chain_publish(empty);
+    // A frame that saw the hook initialized just before may still be on the
+    // empty chain; holding busy keeps any later one out
+    while (atomic_flag_test_and_set_explicit(&g_hook.busy, memory_order_acquire)) {
+        vTaskDelay(1);
+    }
+    
+    int frames_out = 0;
+    video_frame_pool_get_stats(&frames_out, NULL);
+    if (frames_out > 0) {
+        // Freeing a buffer the peer still sends from would corrupt the heap
+        // on its release; put the old chain back and let the caller retry
+        chain_publish(previous);
+        g_hook.initialized = true;
+        atomic_flag_clear_explicit(&g_hook.busy, memory_order_release);
+        xSemaphoreGive(g_hook.mutex);
+        ESP_LOGE(TAG, "Video SEI hook still has %d output frames out, release them before deinit", frames_out);
+        return false;
     }
     
+    video_frame_pool_deinit();
+    vSemaphoreDelete(g_hook.mutex);
     memset(&g_hook, 0, sizeof(g_hook));
     ESP_LOGI(TAG, "✅ Video SEI hook deinitialized");
+    return true;
 }
 
 void video_sei_hook_set_processor(video_frame_processor_t processor, void *user_ctx) {
@@ -94,13 +559,15 @@ void video_sei_hook_set_processor(video_frame_processor_t processor, void *user_
         return;
     }
     
-    if (xSemaphoreTake(g_hook.mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+    if (xSemaphoreTake(g_hook.mutex, portMAX_DELAY) != pdTRUE) {
         ESP_LOGE(TAG, "Failed to acquire mutex");
         return;
     }
     
-    g_hook.custom_processor = processor ? processor : default_sei_processor;
-    g_hook.user_ctx = user_ctx;
+    video_sei_chain_t *next = chain_begin();
+    next->custom_processor = processor;
+    next->user_ctx = user_ctx;
+    chain_publish(next);
     
     ESP_LOGI(TAG, "📹 Set custom video frame processor: %p", processor);
     
@@ -109,73 +576,83 @@ void video_sei_hook_set_processor(video_frame_processor_t processor, void *user_
 
 bool video_sei_hook_process_frame(const uint8_t *frame_data, size_t frame_size,
                                  uint8_t **output_data, size_t *output_size) {
-    if (!g_hook.initialized || !frame_data || !output_data || !output_size) {
+    video_frame_desc_t frame = {
+        .data = frame_data,
+        .size = frame_size,
+    };
+    return video_sei_hook_process_frame_desc(&frame, output_data, output_size, NULL);
+}
+
+bool video_sei_hook_process_frame_desc(const video_frame_desc_t *frame,
+                                      uint8_t **output_data, size_t *output_size,
+                                      bool *failed) {
+    bool stage_failed = false;
+    if (failed) {
+        *failed = false;
+    }
+    if (!g_hook.initialized || !frame || !frame->data || !output_data || !output_size) {
         return false;
     }
     
-    if (xSemaphoreTake(g_hook.mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        // If we can't get the mutex quickly, just copy frame as-is
-        *output_data = malloc(frame_size);
-        if (!*output_data) {
-            return false;
-        }
-        memcpy(*output_data, frame_data, frame_size);
-        *output_size = frame_size;
-        return true;
+    *output_data = NULL;
+    *output_size = 0;
+    
+    int64_t start_us = esp_timer_get_time();
+    if (atomic_flag_test_and_set_explicit(&g_hook.busy, memory_order_acquire)) {
+        // Publisher blocks are single-consumer; send this frame as is
+        sei_metrics_count(SEI_EVENT_CHAIN_BUSY);
+        return false;
     }
+    video_sei_chain_t *chain = chain_acquire();
     
     bool result = false;
-    size_t original_size = frame_size;
+    size_t original_size = frame->size;
+    
+    if (chain->custom_processor) {
+        result = chain->custom_processor(frame->data, frame->size, output_data, output_size, chain->user_ctx);
+    } else {
+        result = run_stages(chain, frame, output_data, output_size, &stage_failed);
+    }
+    chain_release(chain);
+    atomic_flag_clear_explicit(&g_hook.busy, memory_order_release);
+    if (failed) {
+        *failed = stage_failed;
+    }
     
-    if (g_hook.custom_processor) {
-        result = g_hook.custom_processor(frame_data, frame_size, output_data, output_size, g_hook.user_ctx);
+    if (result) {
+        // Update statistics; the task may move cores, the counters stay correct either way
+        video_sei_core_stats_t *stats = &g_hook.core_stats[xPortGetCoreID()];
+        atomic_fetch_add_explicit(&stats->frames_processed, 1, memory_order_relaxed);
         
-        if (result) {
-            // Update statistics
-            g_hook.frames_processed++;
+        if (*output_size > original_size) {
+            // SEI data was added
+            uint32_t sei_bytes_added = *output_size - original_size;
+            atomic_fetch_add_explicit(&stats->total_sei_bytes, sei_bytes_added, memory_order_relaxed);
+            atomic_fetch_add_explicit(&stats->sei_units_inserted, 1, memory_order_relaxed);
             
-            if (*output_size > original_size) {
-                // SEI data was added
-                uint32_t sei_bytes_added = *output_size - original_size;
-                g_hook.total_sei_bytes += sei_bytes_added;
-                g_hook.sei_units_inserted++;
-                
-                ESP_LOGD(TAG, "📹 Frame processed: %zu -> %zu bytes (+%" PRIu32 " SEI bytes)", 
-                         original_size, *output_size, sei_bytes_added);
-            }
-        }
-    } else {
-        // No processor, just copy frame as-is
-        *output_data = malloc(frame_size);
-        if (*output_data) {
-            memcpy(*output_data, frame_data, frame_size);
-            *output_size = frame_size;
-            result = true;
+            ESP_LOGD(TAG, "📹 Frame processed: %zu -> %zu bytes (+%" PRIu32 " SEI bytes)", 
+                     original_size, *output_size, sei_bytes_added);
         }
     }
     
-    xSemaphoreGive(g_hook.mutex);
+    sei_metrics_record(SEI_STAGE_HOOK_FRAME, (uint32_t)(esp_timer_get_time() - start_us));
     return result;
 }
 
 void video_sei_hook_get_stats(uint32_t *frames_processed, uint32_t *sei_units_inserted, uint32_t *total_sei_bytes) {
-    if (!g_hook.initialized) {
-        if (frames_processed) *frames_processed = 0;
-        if (sei_units_inserted) *sei_units_inserted = 0;
-        if (total_sei_bytes) *total_sei_bytes = 0;
-        return;
-    }
-    
-    if (xSemaphoreTake(g_hook.mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire mutex for stats");
-        return;
+    uint32_t frames = 0, units = 0, bytes = 0;
+    if (g_hook.initialized) {
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            const video_sei_core_stats_t *stats = &g_hook.core_stats[core];
+            frames += atomic_load_explicit(&stats->frames_processed, memory_order_relaxed);
+            units += atomic_load_explicit(&stats->sei_units_inserted, memory_order_relaxed);
+            bytes += atomic_load_explicit(&stats->total_sei_bytes, memory_order_relaxed);
+        }
     }
     
-    if (frames_processed) *frames_processed = g_hook.frames_processed;
-    if (sei_units_inserted) *sei_units_inserted = g_hook.sei_units_inserted;
-    if (total_sei_bytes) *total_sei_bytes = g_hook.total_sei_bytes;
-    
-    xSemaphoreGive(g_hook.mutex);
+    if (frames_processed) *frames_processed = frames;
+    if (sei_units_inserted) *sei_units_inserted = units;
+    if (total_sei_bytes) *total_sei_bytes = bytes;
 }
 
 void video_sei_hook_reset_stats(void) {
@@ -183,16 +660,13 @@ void video_sei_hook_reset_stats(void) {
         return;
     }
     
-    if (xSemaphoreTake(g_hook.mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire mutex for stats reset");
-        return;
+    // A frame finishing concurrently may land on either side of the reset
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        video_sei_core_stats_t *stats = &g_hook.core_stats[core];
+        atomic_store_explicit(&stats->frames_processed, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->sei_units_inserted, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->total_sei_bytes, 0, memory_order_relaxed);
     }
     
-    g_hook.frames_processed = 0;
-    g_hook.sei_units_inserted = 0;
-    g_hook.total_sei_bytes = 0;
-    
     ESP_LOGI(TAG, "📊 Statistics reset");
-    
-    xSemaphoreGive(g_hook.mutex);
-}
\ No newline at end of file
+}
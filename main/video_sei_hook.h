@@ -10,25 +10,153 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "sei_publisher.h"
+#include "video_frame_pool.h"
+#include "nal_index.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Most SEI publishers the "sei" stage merges into one frame
+#define VIDEO_SEI_HOOK_MAX_PUBLISHERS 4
+
+// Access unit delimiter added by video_sei_hook_aud_stage
+#define VIDEO_SEI_HOOK_AUD_SIZE 6
+
+// Largest access unit the H.264 encoder emits (see settings.h)
+#ifndef VIDEO_ENC_MAX_FRAME_SIZE
+#define VIDEO_ENC_MAX_FRAME_SIZE (VIDEO_WIDTH * VIDEO_HEIGHT / 6)
+#endif
+
+// Output frame buffer: the largest encoded access unit, a full SEI block with
+// its timing message from every publisher, and the AUD. Bigger frames still
+// go out through the pool's heap fallback
+#ifndef VIDEO_FRAME_POOL_BUF_SIZE
+#define VIDEO_FRAME_POOL_BUF_SIZE (VIDEO_ENC_MAX_FRAME_SIZE + \
+                                   VIDEO_SEI_HOOK_MAX_PUBLISHERS * SEI_BLOCK_CAPACITY + \
+                                   VIDEO_SEI_HOOK_AUD_SIZE)
+#endif
+
+// Priority of the publisher from sei.c
+#define VIDEO_SEI_HOOK_DEFAULT_PRIORITY 0
+
+// Stages in the frame chain, including the built-in "sei" stage
+#define VIDEO_SEI_HOOK_MAX_STAGES 6
+
+// Insertions all stages of the chain can make into one frame
+#define VIDEO_FRAME_MAX_INSERTS 8
+
+// Longest stage name kept, including the terminator
+#define VIDEO_SEI_HOOK_STAGE_NAME_LEN 12
+
+/**
+ * @brief A publisher registered with the hook
+ */
+typedef struct {
+    sei_publisher_handle_t publisher;
+    const char *name;               /*!< Short name for logs and the console */
+    int priority;                   /*!< Higher priorities go first in the access unit */
+} video_sei_channel_t;
+
 /**
  * @brief Video frame processing callback type
  * 
  * @param frame_data Input video frame data
  * @param frame_size Size of input frame data
- * @param output_data Pointer to store output frame data (caller must free)
+ * @param output_data Pointer to store output frame data (from video_frame_pool_acquire)
  * @param output_size Pointer to store output frame size
  * @param user_ctx User context pointer
- * @return true if processing successful, false otherwise
+ * @return true if a new frame was produced, false to send the original frame
  */
 typedef bool (*video_frame_processor_t)(const uint8_t *frame_data, size_t frame_size,
                                        uint8_t **output_data, size_t *output_size,
                                        void *user_ctx);
 
+/**
+ * @brief Outgoing video frame with optional encoder-provided layout
+ */
+typedef struct {
+    const uint8_t *data;            /*!< Encoded access unit */
+    size_t size;                    /*!< Access unit size in bytes */
+    uint32_t pts;                   /*!< Presentation timestamp */
+    const nal_index_t *nal_index;   /*!< NAL boundaries from the encoder, NULL if unknown */
+    bool is_keyframe;               /*!< Frame starts an IDR access unit (valid with nal_index) */
+} video_frame_desc_t;
+
+/**
+ * @brief Bytes a stage inserts into the outgoing frame
+ */
+typedef struct {
+    size_t offset;                  /*!< Offset in the original frame to insert at */
+    const uint8_t *data;            /*!< Bytes to insert, valid until the chain has run */
+    size_t len;
+} video_frame_insert_t;
+
+/**
+ * @brief Frame shared by every stage of the chain
+ *
+ * Stages never copy the frame: they read it, look up the cached NAL index
+ * and record insertions against the original offsets. Once every stage has
+ * run, the output is written into one pool buffer in a single pass, or
+ * the original frame is sent if nothing was inserted.
+ */
+typedef struct {
+    const video_frame_desc_t *frame;    /*!< Original frame, read-only */
+    const nal_index_t *nal_index;       /*!< NAL index, NULL until the encoder or a stage provides it */
+    nal_index_t scanned_index;          /*!< Storage for an index built by video_frame_ctx_nal_index */
+    video_frame_insert_t inserts[VIDEO_FRAME_MAX_INSERTS]; /*!< Sorted by offset, stable */
+    int insert_count;
+    size_t inserted_bytes;              /*!< Sum of all insertion lengths */
+} video_frame_ctx_t;
+
+/**
+ * @brief One stage of the frame chain
+ *
+ * Runs on the video send thread and must not block or change the chain or
+ * the processor. Only one frame is in the chain at a time.
+ *
+ * @param ctx Shared frame context
+ * @param user_ctx Pointer given when the stage was added
+ * @return false if the stage failed (counted, the chain goes on)
+ */
+typedef bool (*video_frame_stage_t)(video_frame_ctx_t *ctx, void *user_ctx);
+
+/**
+ * @brief Counters of a chain stage
+ */
+typedef struct {
+    char name[VIDEO_SEI_HOOK_STAGE_NAME_LEN];
+    uint32_t failures;              /*!< Frames the stage returned false for */
+    uint32_t max_us;                /*!< Longest run since the stage was added */
+} video_sei_hook_stage_info_t;
+
+/**
+ * @brief Get the NAL index of the frame, scanning up to the first slice if nobody has yet
+ *
+ * @param ctx Frame context
+ * @return The index (from the encoder, an earlier stage or this scan)
+ */
+const nal_index_t *video_frame_ctx_nal_index(video_frame_ctx_t *ctx);
+
+/**
+ * @brief Insert bytes into the outgoing frame without copying them
+ *
+ * Insertions at the same offset keep the order they were made in, so
+ * earlier stages go first.
+ *
+ * @param ctx Frame context
+ * @param offset Offset in the original frame, at most its size
+ * @param data Bytes to insert, must stay valid until the chain has run
+ * @param len Number of bytes
+ * @return false if the offset is out of range or VIDEO_FRAME_MAX_INSERTS is reached
+ */
+bool video_frame_ctx_insert(video_frame_ctx_t *ctx, size_t offset, const uint8_t *data, size_t len);
+
+/**
+ * @brief Stage that inserts an access unit delimiter in front of frames without one
+ */
+bool video_sei_hook_aud_stage(video_frame_ctx_t *ctx, void *user_ctx);
+
 /**
  * @brief Initialize video SEI hook system
  * 
@@ -38,17 +166,97 @@ bool video_sei_hook_init(void);
 
 /**
  * @brief Deinitialize video SEI hook system
+ * 
+ * Swaps in an empty chain and waits for frames still being processed.
+ * Every output frame must be released first (stop_webrtc hands back the
+ * one the peer keeps), otherwise the hook is left running.
+ * 
+ * @return true if the hook was deinitialized
  */
-void video_sei_hook_deinit(void);
+bool video_sei_hook_deinit(void);
 
 /**
  * @brief Set custom video frame processor
  * 
- * @param processor Frame processor callback
+ * A custom processor replaces the whole stage chain and copies the frame
+ * itself; prefer video_sei_hook_add_stage. Changes to the processor or
+ * the chain are swapped in atomically and return once no frame uses the
+ * previous one, so frames never wait for them.
+ * 
+ * @param processor Frame processor callback, NULL restores the stage chain
  * @param user_ctx User context to pass to processor
  */
 void video_sei_hook_set_processor(video_frame_processor_t processor, void *user_ctx);
 
+/**
+ * @brief Append a stage to the frame chain
+ * 
+ * The chain starts with the built-in "sei" stage, which splices the blocks
+ * of every registered publisher. Stages run in the order they were added.
+ * 
+ * @param name Stage name for the console (truncated to VIDEO_SEI_HOOK_STAGE_NAME_LEN - 1)
+ * @param stage Stage callback
+ * @param user_ctx Passed to the callback
+ * @return false if the chain is full or the hook isn't initialized
+ */
+bool video_sei_hook_add_stage(const char *name, video_frame_stage_t stage, void *user_ctx);
+
+/**
+ * @brief Remove a stage from the frame chain
+ * 
+ * Waits for the frames still running the stage, so its context can be
+ * freed right after.
+ * 
+ * @param stage Stage callback given to video_sei_hook_add_stage
+ * @return true if the stage was found
+ */
+bool video_sei_hook_remove_stage(video_frame_stage_t stage);
+
+/**
+ * @brief Copy the counters of every stage, in chain order
+ * 
+ * @param out Array to fill
+ * @param max_count Capacity of out
+ * @return Number of stages copied
+ */
+int video_sei_hook_get_stages(video_sei_hook_stage_info_t *out, int max_count);
+
+/**
+ * @brief Register an SEI publisher with the "sei" stage
+ * 
+ * Every registered publisher keeps its own queues, budgets and UUID (see
+ * sei_publisher_config_t.uuid), so producers of different publishers never
+ * share a ring or a lock. Each frame, the "sei" stage builds a block
+ * from every publisher and splices all of them in one copy, highest
+ * priority first. Can be called before video_sei_hook_init.
+ * 
+ * @param publisher Publisher to add, must stay valid until unregistered
+ * @param name Name for logs and the console, must stay valid as well
+ * @param priority Position in the access unit, higher first
+ * @return false if the publisher is already registered or the table is full
+ */
+bool video_sei_hook_register_publisher(sei_publisher_handle_t publisher, const char *name, int priority);
+
+/**
+ * @brief Remove a publisher from the "sei" stage
+ * 
+ * Waits for a frame being processed to finish, so the publisher can be
+ * deinitialized right after.
+ * 
+ * @param publisher Publisher to remove
+ * @return true if it was registered
+ */
+bool video_sei_hook_unregister_publisher(sei_publisher_handle_t publisher);
+
+/**
+ * @brief Copy the registered publishers, highest priority first
+ * 
+ * @param out Array to fill
+ * @param max_count Capacity of out
+ * @return Number of publishers copied
+ */
+int video_sei_hook_get_publishers(video_sei_channel_t *out, int max_count);
+
 /**
  * @brief Process video frame with SEI injection
  * 
@@ -57,13 +265,34 @@ void video_sei_hook_set_processor(video_frame_processor_t processor, void *user_
  * 
  * @param frame_data Input video frame data
  * @param frame_size Size of input frame data
- * @param output_data Pointer to store output frame data (caller must free)
+ * @param output_data Pointer to store output frame data (release with video_frame_pool_release)
  * @param output_size Pointer to store output frame size
- * @return true if processing successful, false otherwise
+ * @return true if a new frame was produced, false to send the original frame
  */
 bool video_sei_hook_process_frame(const uint8_t *frame_data, size_t frame_size,
                                  uint8_t **output_data, size_t *output_size);
 
+/**
+ * @brief Process a described video frame with SEI injection
+ * 
+ * Runs the stage chain (or the custom processor) without taking a lock,
+ * so it is safe from tasks of any priority. A frame arriving while
+ * another is being processed (for example from a test command) is sent
+ * as is rather than waiting. When the descriptor
+ * carries the encoder's NAL layout, stages share it instead of parsing the
+ * payload; otherwise the frame is indexed at most once for all of them.
+ * 
+ * @param frame Frame descriptor
+ * @param output_data Pointer to store output frame data (release with video_frame_pool_release)
+ * @param output_size Pointer to store output frame size
+ * @param failed Set to true if a stage failed or no output buffer could be had,
+ *               so the frame goes out without some or all of its insertions (may be NULL)
+ * @return true if a new frame was produced, false to send the original frame
+ */
+bool video_sei_hook_process_frame_desc(const video_frame_desc_t *frame,
+                                      uint8_t **output_data, size_t *output_size,
+                                      bool *failed);
+
 /**
  * @brief Get statistics about SEI processing
  * 
@@ -14,85 +14,310 @@
 #include "esp_webrtc_defaults.h"
 #include "media_lib_os.h"
 #include "video_sei_hook.h"
+#include "video_profile.h"
+#include "webrtc_stats.h"
+#include "latency_probe.h"
+#include "telemetry_log.h"
+#include "sei.h"
+#include "sei_metrics.h"
+#include "token_cache.h"
+#include "esp_system.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
 // clang-format on
 
 #define TAG "WHIP_DEMO"
 
+#ifndef SEI_PUBLISH_WEBRTC_STATS
+#define SEI_PUBLISH_WEBRTC_STATS false
+#endif
+
+// Stats samples between two SEI stats messages (10 s at the 2 s sampling interval)
+#define WEBRTC_STATS_SEI_INTERVAL 5
+
+// Reconnect backoff: the first retry is quick to ride out short drops, then
+// doubles up to the maximum, with up to 25% jitter
+#define SESSION_RETRY_MIN_MS 250
+#define SESSION_RETRY_MAX_MS 30000
+
+// A session that neither connects nor fails within this time is retried
+#define SESSION_CONNECT_TIMEOUT_MS 15000
+
+// How long a reopen waits for the token cache to fetch a participant token
+#define SESSION_TOKEN_WAIT_MS 5000
+
+// A resolution change that found no participant token is retried after this
+#define SESSION_PROFILE_RETRY_MS 2000
+
+#define SESSION_TASK_STACK_SIZE 6144
+#define SESSION_TASK_PRIORITY 5
+
+typedef enum {
+  SESSION_IDLE,         // Not streaming
+  SESSION_CONNECTING,   // Session opened, waiting for the peer to connect
+  SESSION_CONNECTED,    // Streaming
+  SESSION_BACKOFF,      // Lost, reopening once the backoff expires
+  SESSION_WAIT_NETWORK, // Lost with the network, reopening when it is back
+} session_state_t;
+
+// Peer events, handed from the esp_webrtc thread to the session task
+typedef enum {
+  SESSION_EVENT_NONE,
+  SESSION_EVENT_CONNECTED,
+  SESSION_EVENT_LOST,
+} session_event_t;
+
 static esp_webrtc_handle_t webrtc;
 
+// Session parameters, kept so a profile change or reconnect can reopen the session
+static char *session_url;
+static char *session_token;
+// Token came from the token cache, so every reopen takes a fresh one
+static bool session_token_renew;
+static char renewed_token[TOKEN_CACHE_MAX_LEN];
+
+// Reconnect state machine. Opening and closing happen under session_lock,
+// either from the caller of start_webrtc/stop_webrtc or from the session
+// task; esp_webrtc events only post to the task, since closing the session
+// from its own event thread would deadlock. A reopen holds the lock through
+// signaling, so readers only try it and skip the sample when it is busy.
+// session_lock and the task exist once session_task_handle is set
+static SemaphoreHandle_t session_lock;
+static TaskHandle_t session_task_handle;
+static session_state_t session_state = SESSION_IDLE;
+static _Atomic uint32_t session_generation; // Bumped on every open and close
+static _Atomic int session_pending_event;
+static atomic_bool session_network_up = true;
+static int session_attempt;
+static int64_t session_deadline_us; // Reopen (BACKOFF) or give up connecting (CONNECTING)
+static int64_t session_outage_start_us;
+
+// Resolution the open session was configured with; profiles at the same
+// resolution are applied to the running capture without reopening
+static uint16_t session_width;
+static uint16_t session_height;
+static atomic_bool session_profile_changed;
+static int64_t session_profile_retry_us; // 0 unless a reopen waits for a token
+
+// Link statistics for the current adaptation window, written by the video
+// send thread and collected by update_webrtc_stats
+static _Atomic uint32_t link_frames;
+static _Atomic uint32_t link_bytes;
+static _Atomic uint32_t link_max_delay_ms;
+static _Atomic uint32_t link_keyframes;
+static _Atomic uint32_t link_frames_missed;
+static _Atomic uint32_t link_frames_late;
+static _Atomic uint32_t link_sei_passthrough;
+static atomic_bool link_reset_baseline;
+static int64_t link_window_start_us;
+
+// Pool buffer handed to the peer for the last frame; the peer has packetized
+// it by the time on_video_send fires for the next frame
+static uint8_t *sei_frame_in_flight;
+
+static void release_sei_frame_in_flight(void) {
+  if (sei_frame_in_flight) {
+    video_frame_pool_release(sei_frame_in_flight);
+    sei_frame_in_flight = NULL;
+  }
+}
+
+// Track frame rate, bitrate and how far sending lags behind capture. The
+// lag has an arbitrary offset (capture and system clocks start apart), so
+// only its growth over the lowest lag of the session counts as delay.
+// Gaps in the capture timestamps show frames lost before the send path
+static void record_link_stats(const esp_peer_video_frame_t *frame) {
+  static int64_t baseline_lag_ms;
+  static uint32_t last_pts;
+  int64_t lag_ms = esp_timer_get_time() / 1000 - (int64_t)frame->pts;
+  bool reset = atomic_exchange(&link_reset_baseline, false);
+  if (reset || lag_ms < baseline_lag_ms) {
+    baseline_lag_ms = lag_ms;
+  }
+  uint32_t delay_ms = (uint32_t)(lag_ms - baseline_lag_ms);
+  if (delay_ms > atomic_load_explicit(&link_max_delay_ms, memory_order_relaxed)) {
+    atomic_store_explicit(&link_max_delay_ms, delay_ms, memory_order_relaxed);
+  }
+
+  uint32_t frame_ms = 1000 / video_profile_current()->fps;
+  if (!reset && frame->pts > last_pts &&
+      frame->pts - last_pts > frame_ms * 3 / 2) {
+    uint32_t slots = (frame->pts - last_pts + frame_ms / 2) / frame_ms;
+    atomic_fetch_add_explicit(&link_frames_missed, slots - 1,
+                              memory_order_relaxed);
+  }
+  last_pts = frame->pts;
+  if (delay_ms > frame_ms) {
+    atomic_fetch_add_explicit(&link_frames_late, 1, memory_order_relaxed);
+  }
+  atomic_fetch_add_explicit(&link_frames, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&link_bytes, frame->size, memory_order_relaxed);
+}
+
+static void reset_link_stats(void) {
+  atomic_store(&link_frames, 0);
+  atomic_store(&link_bytes, 0);
+  atomic_store(&link_max_delay_ms, 0);
+  atomic_store(&link_keyframes, 0);
+  atomic_store(&link_frames_missed, 0);
+  atomic_store(&link_frames_late, 0);
+  atomic_store(&link_sei_passthrough, 0);
+  atomic_store(&link_reset_baseline, true);
+  link_window_start_us = esp_timer_get_time();
+  video_profile_reset_windows();
+}
+
 // SEI video frame callback - called for each outgoing video frame
 static int sei_video_send_callback(esp_peer_video_frame_t *frame, void *ctx) {
+  // Previous frame is sent, recycle its buffer
+  release_sei_frame_in_flight();
+
   if (!frame || !frame->data || frame->size == 0) {
     return 0; // Pass through unchanged
   }
+  record_link_stats(frame);
+
+  latency_probe_t probe;
+  if (latency_probe_on_send(frame->pts, &probe)) {
+    // Queued ahead of the splice below, so the probe rides in the frame it
+    // describes
+    sei_send_latency_probe(&probe);
+  }
+
+  // Attach the encoder's NAL layout so the hook does not rescan the frame
+  nal_index_t nal_index;
+  video_frame_desc_t desc = {
+      .data = frame->data,
+      .size = frame->size,
+      .pts = frame->pts,
+  };
+  if (media_sys_describe_video_frame(frame->data, frame->size, &nal_index) ==
+      0) {
+    desc.nal_index = &nal_index;
+    desc.is_keyframe = nal_index.is_keyframe;
+    if (desc.is_keyframe) {
+      atomic_fetch_add_explicit(&link_keyframes, 1, memory_order_relaxed);
+    }
+  }
 
   // Process frame through our SEI hook
   uint8_t *sei_output_data = NULL;
   size_t sei_output_size = 0;
+  bool sei_failed = false;
 
-  bool result = video_sei_hook_process_frame(
-      frame->data, frame->size, &sei_output_data, &sei_output_size);
+  bool result = video_sei_hook_process_frame_desc(&desc, &sei_output_data,
+                                                  &sei_output_size, &sei_failed);
+  if (sei_failed) {
+    // The frame goes out without some or all of its SEI
+    ESP_LOGE(TAG, "❌ SEI frame processing failed");
+    atomic_fetch_add_explicit(&link_sei_passthrough, 1, memory_order_relaxed);
+  }
 
   if (result && sei_output_data && sei_output_size > 0) {
     // SEI data was processed - update frame info
     ESP_LOGD(TAG, "SEI processed: %zu -> %zu bytes", frame->size,
              sei_output_size);
 
-    // Update frame data and size
+    // Update frame data and size, keep the buffer until the peer is done
     frame->data = sei_output_data;
     frame->size = sei_output_size;
+    sei_frame_in_flight = sei_output_data;
     return 0; // Success
-  } else if (!result && sei_output_data == NULL && sei_output_size == 0) {
-    // No processing needed (no messages queued) - pass through original frame silently
-    return 0;
-  } else if (!result) {
-    ESP_LOGE(TAG, "❌ SEI frame processing failed - passing through original frame");
-    // Don't return error, just pass through the original frame
-    return 0;
   }
 
-  // Return success (frame unchanged)
+  // Nothing inserted or processing failed, pass through the original frame
   return 0;
 }
 
+static void notify_session_task(void) {
+  if (session_task_handle) {
+    xTaskNotifyGive(session_task_handle);
+  }
+}
+
 static int webrtc_event_handler(esp_webrtc_event_t *event, void *ctx) {
-  // For now, just log events
+  // Ignore late events from a session that was already closed
+  if ((uint32_t)(uintptr_t)ctx != atomic_load(&session_generation)) {
+    return 0;
+  }
+  session_event_t session_event = SESSION_EVENT_NONE;
+  switch (event->type) {
+  case ESP_WEBRTC_EVENT_CONNECTED:
+    session_event = SESSION_EVENT_CONNECTED;
+    break;
+  case ESP_WEBRTC_EVENT_CONNECT_FAILED:
+  case ESP_WEBRTC_EVENT_DISCONNECTED:
+    session_event = SESSION_EVENT_LOST;
+    break;
+  default:
+    break;
+  }
+  if (session_event != SESSION_EVENT_NONE) {
+    atomic_store(&session_pending_event, session_event);
+    notify_session_task();
+  }
   return 0;
 }
 
-int start_webrtc(char *url, char *token) {
-  if (network_is_connected() == false) {
-    ESP_LOGE(TAG, "Wifi not connected yet");
-    return -1;
-  }
-  if (url[0] == 0) {
-    ESP_LOGE(TAG, "Room Url not set yet");
-    return -1;
+static void keep_session_string(char **slot, const char *value) {
+  if (*slot == value) {
+    return;
   }
+  free(*slot);
+  *slot = value ? strdup(value) : NULL;
+}
+
+// Scale SEI traffic with the video bitrate so it stays a similar share of
+// the stream on every profile
+static void apply_sei_budget(const video_profile_t *profile) {
+  sei_publisher_set_byte_budget(
+      sei_get_publisher(),
+      video_profile_scale_budget(profile, SEI_DEFAULT_FRAME_BUDGET),
+      video_profile_scale_budget(profile, SEI_DEFAULT_BULK_BUDGET));
+}
+
+static void close_session(void) {
   if (webrtc) {
-    esp_webrtc_close(webrtc);
+    esp_webrtc_handle_t handle = webrtc;
     webrtc = NULL;
+    atomic_fetch_add(&session_generation, 1);
+    // Readings go to the telemetry log until a session connects again
+    telemetry_log_set_online(false);
+    ESP_LOGI(TAG, "Start to close webrtc %p", handle);
+    esp_webrtc_close(handle);
+    release_sei_frame_in_flight();
   }
+}
+
+// Open a session with the kept URL and token, closing the current one.
+// The capture system and SEI publisher live outside the session, so only
+// signaling and the peer are rebuilt. Caller holds session_lock
+static int open_session(void) {
+  close_session();
+  char *url = session_url;
+  char *token = session_token;
   esp_peer_signaling_whip_cfg_t whip_cfg = {
       .auth_type = ESP_PEER_SIGNALING_WHIP_AUTH_TYPE_BEARER,
       .token = token,
   };
 
   // Log the video configuration being used
-  ESP_LOGI(TAG, "🎥 Configuring WebRTC with video: %dx%d@%dfps", VIDEO_WIDTH,
-           VIDEO_HEIGHT, VIDEO_FPS);
-
-#if CONFIG_IDF_TARGET_ESP32P4
-  ESP_LOGI(TAG, "✅ ESP32P4 target detected - using 1920x1080@25fps");
-#else
-  ESP_LOGI(TAG, "⚠️  Non-ESP32P4 target - using 320x240@10fps");
-#endif
-
-  // Compile-time verification of the actual values
-  ESP_LOGI(
-      TAG,
-      "📊 Compile-time values: VIDEO_WIDTH=%d, VIDEO_HEIGHT=%d, VIDEO_FPS=%d",
-      VIDEO_WIDTH, VIDEO_HEIGHT, VIDEO_FPS);
+  const video_profile_t *profile = video_profile_current();
+  ESP_LOGI(TAG, "🎥 Configuring WebRTC with video profile %s: %dx%d@%dfps (%s)",
+           profile->name, profile->width, profile->height, profile->fps,
+           video_profile_is_auto() ? "auto" : "pinned");
+  apply_sei_budget(profile);
+  media_sys_set_video_fps(profile->fps);
+  session_width = profile->width;
+  session_height = profile->height;
+  session_profile_retry_us = 0;
 
   esp_webrtc_cfg_t cfg = {
       .peer_cfg =
@@ -114,9 +339,9 @@ int start_webrtc(char *url, char *token) {
               .video_info =
                   {
                       .codec = ESP_PEER_VIDEO_CODEC_H264,
-                      .width = VIDEO_WIDTH,
-                      .height = VIDEO_HEIGHT,
-                      .fps = VIDEO_FPS,
+                      .width = profile->width,
+                      .height = profile->height,
+                      .fps = profile->fps,
                   },
               .audio_dir = ESP_PEER_MEDIA_DIR_SEND_ONLY,
               .video_dir = ESP_PEER_MEDIA_DIR_SEND_ONLY,
@@ -137,6 +362,7 @@ int start_webrtc(char *url, char *token) {
   int ret = esp_webrtc_open(&cfg, &webrtc);
   if (ret != 0) {
     ESP_LOGE(TAG, "Fail to open webrtc");
+    webrtc = NULL;
     return ret;
   }
   // Set media provider
@@ -144,13 +370,16 @@ int start_webrtc(char *url, char *token) {
   media_sys_get_provider(&media_provider);
   esp_webrtc_set_media_provider(webrtc, &media_provider);
 
-  // Set event handler
-  esp_webrtc_set_event_handler(webrtc, webrtc_event_handler, NULL);
+  // Set event handler, tagged with this session's generation
+  uint32_t generation = atomic_fetch_add(&session_generation, 1) + 1;
+  esp_webrtc_set_event_handler(webrtc, webrtc_event_handler,
+                               (void *)(uintptr_t)generation);
 
   // Default disable auto connect of peer connection
   esp_webrtc_enable_peer_connection(webrtc, true);
 
   // Start webrtc
+  reset_link_stats();
   ret = esp_webrtc_start(webrtc);
   if (ret != 0) {
     ESP_LOGE(TAG, "Fail to start webrtc");
@@ -158,18 +387,366 @@ int start_webrtc(char *url, char *token) {
   return ret;
 }
 
+static void enter_connecting(void) {
+  session_state = SESSION_CONNECTING;
+  session_deadline_us =
+      esp_timer_get_time() + (int64_t)SESSION_CONNECT_TIMEOUT_MS * 1000;
+}
+
+static void schedule_reconnect(const char *reason) {
+  int64_t now = esp_timer_get_time();
+  if (session_outage_start_us == 0) {
+    session_outage_start_us = now;
+  }
+  // Drop the dead session now, so its late events are ignored
+  close_session();
+  if (!atomic_load(&session_network_up)) {
+    // Nothing to retry until the network is back
+    session_state = SESSION_WAIT_NETWORK;
+    ESP_LOGW(TAG, "📴 WebRTC %s, waiting for the network", reason);
+    return;
+  }
+  uint32_t delay_ms = SESSION_RETRY_MIN_MS;
+  for (int i = 0; i < session_attempt && delay_ms < SESSION_RETRY_MAX_MS; i++) {
+    delay_ms *= 2;
+  }
+  if (delay_ms > SESSION_RETRY_MAX_MS) {
+    delay_ms = SESSION_RETRY_MAX_MS;
+  }
+  delay_ms += esp_random() % (delay_ms / 4 + 1);
+  session_attempt++;
+  session_state = SESSION_BACKOFF;
+  session_deadline_us = now + (int64_t)delay_ms * 1000;
+  ESP_LOGW(TAG, "🔁 WebRTC %s, reconnect attempt %d in %" PRIu32 " ms", reason,
+           session_attempt, delay_ms);
+}
+
+// Participant tokens are single-use and expire, so a session started with a
+// cached token only reopens with a new one. Caller holds session_lock
+static bool renew_session_token(uint32_t wait_ms) {
+  if (!session_token_renew) {
+    return true;
+  }
+  if (!token_cache_get(renewed_token, sizeof(renewed_token), wait_ms)) {
+    return false;
+  }
+  token_cache_consume();
+  keep_session_string(&session_token, renewed_token);
+  return true;
+}
+
+// Retrying with a used token can never succeed, so stop until the next start
+static void give_up_session(void) {
+  close_session();
+  session_state = SESSION_IDLE;
+  ESP_LOGE(TAG, "❌ No participant token to reopen WebRTC, giving up after "
+                "%d attempts; start the stream again",
+           session_attempt);
+}
+
+static void reopen_session(void) {
+  if (!renew_session_token(SESSION_TOKEN_WAIT_MS)) {
+    give_up_session();
+  } else if (open_session() == 0) {
+    enter_connecting();
+  } else {
+    schedule_reconnect("reopen failed");
+  }
+}
+
+// Runs one step of the state machine. Caller holds session_lock
+static void run_session_state(session_event_t event) {
+  int64_t now = esp_timer_get_time();
+  switch (session_state) {
+  case SESSION_IDLE:
+    break;
+  case SESSION_CONNECTING:
+  case SESSION_CONNECTED:
+    if (event == SESSION_EVENT_CONNECTED) {
+      if (session_outage_start_us) {
+        ESP_LOGI(TAG, "✅ WebRTC reconnected after %" PRId64 " ms (%d attempts)",
+                 (now - session_outage_start_us) / 1000, session_attempt);
+      }
+      session_state = SESSION_CONNECTED;
+      session_attempt = 0;
+      session_outage_start_us = 0;
+      telemetry_log_set_online(true);
+    } else if (event == SESSION_EVENT_LOST) {
+      schedule_reconnect(session_state == SESSION_CONNECTED ? "disconnected"
+                                                            : "connect failed");
+    } else if (!atomic_load(&session_network_up)) {
+      schedule_reconnect("lost the network");
+    } else if (session_state == SESSION_CONNECTING &&
+               now >= session_deadline_us) {
+      schedule_reconnect("connect timed out");
+    }
+    break;
+  case SESSION_BACKOFF:
+    if (!atomic_load(&session_network_up)) {
+      schedule_reconnect("lost the network");
+    } else if (now >= session_deadline_us) {
+      reopen_session();
+    }
+    break;
+  case SESSION_WAIT_NETWORK:
+    if (atomic_load(&session_network_up)) {
+      // Fresh network, retry right away
+      session_attempt = 0;
+      reopen_session();
+    }
+    break;
+  }
+}
+
+// Apply the selected video profile to the open session. A new frame rate
+// goes to the running capture; only a new resolution reopens the session,
+// and without a fresh token the current session keeps streaming and the
+// step is retried. Caller holds session_lock
+static void apply_video_profile(void) {
+  if (!webrtc ||
+      (session_state != SESSION_CONNECTING && session_state != SESSION_CONNECTED)) {
+    // The next open picks up the profile
+    session_profile_retry_us = 0;
+    return;
+  }
+  const video_profile_t *profile = video_profile_current();
+  if (profile->width == session_width && profile->height == session_height) {
+    ESP_LOGI(TAG, "🎚️  Video profile %s applied to the running session",
+             profile->name);
+    apply_sei_budget(profile);
+    media_sys_set_video_fps(profile->fps);
+    session_profile_retry_us = 0;
+    video_profile_reset_windows();
+    return;
+  }
+  // Don't wait for the token cache, the session task serves reconnects too
+  if (!renew_session_token(0)) {
+    if (session_profile_retry_us == 0) {
+      ESP_LOGW(TAG, "⏳ No participant token for video profile %s yet, "
+                    "keeping the current session",
+               profile->name);
+    }
+    session_profile_retry_us =
+        esp_timer_get_time() + (int64_t)SESSION_PROFILE_RETRY_MS * 1000;
+    return;
+  }
+  ESP_LOGI(TAG, "🔁 Reopening WebRTC session for video profile %s",
+           profile->name);
+  session_attempt = 0;
+  if (open_session() == 0) {
+    enter_connecting();
+  } else {
+    schedule_reconnect("reopen failed");
+  }
+}
+
+static void session_task(void *arg) {
+  TickType_t wait = portMAX_DELAY;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, wait);
+    session_event_t event =
+        atomic_exchange(&session_pending_event, SESSION_EVENT_NONE);
+    xSemaphoreTake(session_lock, portMAX_DELAY);
+    run_session_state(event);
+    if (atomic_exchange(&session_profile_changed, false) ||
+        (session_profile_retry_us &&
+         esp_timer_get_time() >= session_profile_retry_us)) {
+      apply_video_profile();
+    }
+    // Sleep until the next deadline, or until an event or a state change
+    int64_t deadline_us = 0;
+    if (session_state == SESSION_CONNECTING ||
+        session_state == SESSION_BACKOFF) {
+      deadline_us = session_deadline_us;
+    }
+    if (session_profile_retry_us &&
+        (deadline_us == 0 || session_profile_retry_us < deadline_us)) {
+      deadline_us = session_profile_retry_us;
+    }
+    wait = portMAX_DELAY;
+    if (deadline_us) {
+      int64_t remaining_us = deadline_us - esp_timer_get_time();
+      wait = remaining_us > 0 ? pdMS_TO_TICKS(remaining_us / 1000) + 1 : 0;
+    }
+    xSemaphoreGive(session_lock);
+  }
+}
+
+// Hand a profile change to the session task, which owns opening and closing
+static void request_video_profile(void) {
+  atomic_store(&session_profile_changed, true);
+  notify_session_task();
+}
+
+static bool ensure_session_task(void) {
+  if (session_task_handle) {
+    return true;
+  }
+  session_lock = xSemaphoreCreateMutex();
+  if (!session_lock) {
+    ESP_LOGE(TAG, "Failed to create session lock");
+    return false;
+  }
+  TaskHandle_t task = NULL;
+  if (xTaskCreate(session_task, "webrtc_session", SESSION_TASK_STACK_SIZE,
+                  NULL, SESSION_TASK_PRIORITY, &task) != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create session task");
+    // Nothing can hold the lock yet, readers wait for the task handle
+    vSemaphoreDelete(session_lock);
+    session_lock = NULL;
+    return false;
+  }
+  session_task_handle = task;
+  return true;
+}
+
+static int start_session(char *url, char *token, bool renew_token) {
+  if (network_is_connected() == false) {
+    ESP_LOGE(TAG, "Wifi not connected yet");
+    return -1;
+  }
+  if (url[0] == 0) {
+    ESP_LOGE(TAG, "Room Url not set yet");
+    return -1;
+  }
+  if (!ensure_session_task()) {
+    return -1;
+  }
+  xSemaphoreTake(session_lock, portMAX_DELAY);
+  keep_session_string(&session_url, url);
+  keep_session_string(&session_token, token);
+  session_token_renew = renew_token;
+  atomic_store(&session_network_up, true);
+  session_attempt = 0;
+  session_outage_start_us = 0;
+  int ret = open_session();
+  if (ret == 0) {
+    enter_connecting();
+  } else {
+    // A session that never opened is a setup problem, don't retry it
+    close_session();
+    session_state = SESSION_IDLE;
+  }
+  xSemaphoreGive(session_lock);
+  // Let the task pick up the connect deadline
+  notify_session_task();
+  return ret;
+}
+
+int start_webrtc(char *url, char *token) {
+  return start_session(url, token, false);
+}
+
+int start_webrtc_with_cached_token(char *url, char *token) {
+  return start_session(url, token, true);
+}
+
 void query_webrtc(void) {
+  if (!session_task_handle) {
+    return;
+  }
+  // The session task may close the handle at any time
+  if (xSemaphoreTake(session_lock, 0) != pdTRUE) {
+    ESP_LOGI(TAG, "WebRTC session is reopening, query skipped");
+    return;
+  }
   if (webrtc) {
     esp_webrtc_query(webrtc);
   }
+  xSemaphoreGive(session_lock);
+}
+
+static uint32_t sei_drop_total(void) {
+  return sei_metrics_get_count(SEI_EVENT_DROPPED_OLDEST) +
+         sei_metrics_get_count(SEI_EVENT_DROPPED_NEW) +
+         sei_metrics_get_count(SEI_EVENT_BULK_SHED);
+}
+
+// Reports a session that is being reopened as closed
+static bool session_is_open(void) {
+  if (!session_task_handle || xSemaphoreTake(session_lock, 0) != pdTRUE) {
+    return false;
+  }
+  bool open = webrtc != NULL;
+  xSemaphoreGive(session_lock);
+  return open;
+}
+
+void update_webrtc_stats(void) {
+  static uint32_t last_sei_drops;
+  static uint32_t samples_since_sei;
+  // While a reopen holds the lock the window runs on into the next sample
+  if (!session_is_open()) {
+    return;
+  }
+  int64_t now = esp_timer_get_time();
+  uint32_t interval_ms = (uint32_t)((now - link_window_start_us) / 1000);
+  uint32_t bytes = atomic_exchange(&link_bytes, 0);
+  uint32_t sei_drops = sei_drop_total();
+  int pool_in_use = 0;
+  video_frame_pool_get_stats(&pool_in_use, NULL);
+  int queue_depth = sei_get_queue_status();
+  webrtc_stats_sample_t sample = {
+      .timestamp_ms = (uint32_t)(now / 1000),
+      .interval_ms = interval_ms,
+      .frames = atomic_exchange(&link_frames, 0),
+      .send_kbps = interval_ms ? bytes * 8 / interval_ms : 0,
+      .max_send_delay_ms = atomic_exchange(&link_max_delay_ms, 0),
+      .keyframes = atomic_exchange(&link_keyframes, 0),
+      .frames_missed = atomic_exchange(&link_frames_missed, 0),
+      .frames_late = atomic_exchange(&link_frames_late, 0),
+      .sei_passthrough = atomic_exchange(&link_sei_passthrough, 0),
+      // Counters restart on sei_metrics reset
+      .sei_dropped = sei_drops >= last_sei_drops ? sei_drops - last_sei_drops : sei_drops,
+      .sei_queue_depth = queue_depth > 0 ? (uint16_t)queue_depth : 0,
+      .frame_pool_in_use = (uint8_t)pool_in_use,
+      .profile_index = (uint8_t)video_profile_current_index(),
+      .free_heap = esp_get_free_heap_size(),
+  };
+  link_window_start_us = now;
+  last_sei_drops = sei_drops;
+  webrtc_stats_push(&sample);
+
+  if (SEI_PUBLISH_WEBRTC_STATS &&
+      ++samples_since_sei >= WEBRTC_STATS_SEI_INTERVAL) {
+    samples_since_sei = 0;
+    sei_send_webrtc_stats(&sample);
+  }
+
+  video_link_sample_t link = {
+      .interval_ms = sample.interval_ms,
+      .frames = sample.frames,
+      .bytes = bytes,
+      .max_send_delay_ms = sample.max_send_delay_ms,
+  };
+  if (video_profile_update(&link)) {
+    request_video_profile();
+  }
+}
+
+int set_webrtc_video_profile(int index) {
+  int previous = video_profile_current_index();
+  if (!video_profile_select(index)) {
+    return -1;
+  }
+  if (index >= 0 && index != previous) {
+    request_video_profile();
+  }
+  return 0;
+}
+
+void set_webrtc_network_state(bool connected) {
+  atomic_store(&session_network_up, connected);
+  notify_session_task();
 }
 
 int stop_webrtc(void) {
-  if (webrtc) {
-    esp_webrtc_handle_t handle = webrtc;
-    webrtc = NULL;
-    ESP_LOGI(TAG, "Start to close webrtc %p", handle);
-    esp_webrtc_close(handle);
+  if (!session_task_handle) {
+    return 0;
   }
+  xSemaphoreTake(session_lock, portMAX_DELAY);
+  session_state = SESSION_IDLE;
+  close_session();
+  xSemaphoreGive(session_lock);
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+/* WebRTC Stream Statistics Implementation
+ *
+ * Fixed ring of samples guarded by a spinlock; samples are small, so
+ * readers copy them out instead of holding the lock
+ */
+
+#include "webrtc_stats.h"
+#include "freertos/FreeRTOS.h"
+
+typedef struct {
+    webrtc_stats_sample_t samples[WEBRTC_STATS_HISTORY];
+    int next;                   // Slot written by the next push
+    int count;
+    portMUX_TYPE lock;
+} webrtc_stats_ring_t;
+
+static webrtc_stats_ring_t g_stats = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+void webrtc_stats_push(const webrtc_stats_sample_t *sample) {
+    if (!sample) return;
+
+    taskENTER_CRITICAL(&g_stats.lock);
+    g_stats.samples[g_stats.next] = *sample;
+    g_stats.next = (g_stats.next + 1) % WEBRTC_STATS_HISTORY;
+    if (g_stats.count < WEBRTC_STATS_HISTORY) {
+        g_stats.count++;
+    }
+    taskEXIT_CRITICAL(&g_stats.lock);
+}
+
+int webrtc_stats_get_recent(webrtc_stats_sample_t *out, int max_count) {
+    if (!out || max_count <= 0) return 0;
+
+    taskENTER_CRITICAL(&g_stats.lock);
+    int count = g_stats.count < max_count ? g_stats.count : max_count;
+    for (int i = 0; i < count; i++) {
+        int slot = (g_stats.next - 1 - i + WEBRTC_STATS_HISTORY) % WEBRTC_STATS_HISTORY;
+        out[i] = g_stats.samples[slot];
+    }
+    taskEXIT_CRITICAL(&g_stats.lock);
+    return count;
+}
+
+bool webrtc_stats_get_latest(webrtc_stats_sample_t *out) {
+    return webrtc_stats_get_recent(out, 1) == 1;
+}
+
+uint32_t webrtc_stats_fps_x10(const webrtc_stats_sample_t *sample) {
+    if (!sample || sample->interval_ms == 0) return 0;
+    return sample->frames * 10000u / sample->interval_ms;
+}
+
+void webrtc_stats_reset(void) {
+    taskENTER_CRITICAL(&g_stats.lock);
+    g_stats.next = 0;
+    g_stats.count = 0;
+    taskEXIT_CRITICAL(&g_stats.lock);
+}
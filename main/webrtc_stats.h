@@ -0,0 +1,80 @@
+/* WebRTC Stream Statistics
+ *
+ * Rolling history of per-window stream statistics, sampled every 2 seconds
+ * next to esp_webrtc_query, so stream quality can be read from code, the
+ * console or an SEI topic instead of the log.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of samples kept (one minute at the 2 s sampling interval)
+#define WEBRTC_STATS_HISTORY 30
+
+/**
+ * @brief Statistics for one sampling window
+ *
+ * esp_webrtc_query only logs, so the values are measured on the video send
+ * path and the SEI publisher: keyframes stand in for PLI requests and the
+ * capture-to-send delay for RTT and loss, which the peer doesn't expose.
+ */
+typedef struct {
+    uint32_t timestamp_ms;      /*!< End of the window, milliseconds since boot */
+    uint32_t interval_ms;       /*!< Window length */
+    uint32_t frames;            /*!< Video frames handed to the peer */
+    uint32_t send_kbps;         /*!< Encoded video bitrate handed to the peer */
+    uint32_t max_send_delay_ms; /*!< Worst capture-to-send delay above the session baseline */
+    uint32_t keyframes;         /*!< IDR frames sent (periodic plus those forced by PLI/FIR) */
+    uint32_t frames_missed;     /*!< Frame slots with no frame: dropped by the camera or encoder */
+    uint32_t frames_late;       /*!< Frames sent more than a frame interval behind the baseline */
+    uint32_t sei_passthrough;   /*!< Frames sent without some or all of their SEI because injection failed */
+    uint32_t sei_dropped;       /*!< SEI messages dropped or shed */
+    uint16_t sei_queue_depth;   /*!< SEI messages pending at the end of the window */
+    uint8_t frame_pool_in_use;  /*!< Output frame buffers held by the peer */
+    uint8_t profile_index;      /*!< Active video profile (see video_profile.h) */
+    uint32_t free_heap;         /*!< Free heap at the end of the window */
+} webrtc_stats_sample_t;
+
+/**
+ * @brief Append a sample, overwriting the oldest once the history is full
+ *
+ * @param sample Sample to store
+ */
+void webrtc_stats_push(const webrtc_stats_sample_t *sample);
+
+/**
+ * @brief Copy the most recent samples, newest first
+ *
+ * @param out Array to fill
+ * @param max_count Capacity of out
+ * @return Number of samples copied
+ */
+int webrtc_stats_get_recent(webrtc_stats_sample_t *out, int max_count);
+
+/**
+ * @brief Get the newest sample
+ *
+ * @param out Sample to fill
+ * @return true if a sample was available
+ */
+bool webrtc_stats_get_latest(webrtc_stats_sample_t *out);
+
+/**
+ * @brief Get the delivered frame rate of a sample in tenths of a frame per second
+ */
+uint32_t webrtc_stats_fps_x10(const webrtc_stats_sample_t *sample);
+
+/**
+ * @brief Drop all stored samples
+ */
+void webrtc_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif